@@ -21,8 +21,88 @@ pub const CurveApproximator = struct {
 
     pub const BEZIER_TOLERANCE: f32 = 0.25;
     pub const CIRCULAR_ARC_TOLERANCE: f32 = 0.1;
+
+    ///Max distance (osu pixels) the flattened curve may be off by. The defaults are what osu! uses and what gameplay
+    ///code should stick to, rendering can go coarser or finer depending on how big an osu pixel is on screen.
+    pub const Tolerance = struct {
+        Bezier: f32 = BEZIER_TOLERANCE,
+        CircularArc: f32 = CIRCULAR_ARC_TOLERANCE,
+    };
     pub const PRECISION_EPSILON: f32 = 1e-6;
 
+    //Every subdivision shrinks the second derivative by 4x, past this depth a piece is treated as flat regardless.
+    //Also what bounds the subdivision stack of the *Into approximators.
+    pub const MAX_SUBDIVISION_DEPTH: usize = 32;
+
+    pub const LAGRANGE_STEPS: usize = 51;
+
+    pub const Error = error{ OutputTooSmall, ScratchTooSmall };
+
+    ///Which bezier flattening code approximateBSplineIntoKernel uses. Scalar is the original AoS subdivision, it's what
+    ///osu! does and what every gameplay path is flattened with. Simd puts its points elsewhere on the curve (within the
+    ///tolerance), so it's only for geometry that is just drawn, see SliderPath.FlattenDetail.Kernel.
+    pub const Kernel = enum { Scalar, Simd };
+
+    const LANES = 8;
+    const Lane = @Vector(LANES, f32);
+
+    //Stack slots plus the subdivision buffer and both children
+    const SOA_PIECE_SLOTS = MAX_SUBDIVISION_DEPTH + 1 + 3;
+    //Quadratics/cubics that would need more uniform steps than this are far from anything a slider does
+    const MAX_FORWARD_STEPS: f32 = 4096.0;
+
+    //Appends into a fixed caller owned slice instead of a list
+    const PointWriter = struct {
+        Buffer: []zm.Vec2f,
+        Len: usize = 0,
+
+        inline fn append(self: *PointWriter, point: zm.Vec2f) Error!void {
+            if (self.Len == self.Buffer.len)
+                return error.OutputTooSmall;
+
+            self.Buffer[self.Len] = point;
+            self.Len += 1;
+        }
+
+        fn written(self: *const PointWriter) []zm.Vec2f {
+            return self.Buffer[0..self.Len];
+        }
+    };
+
+    fn takeScratch(scratch: *[]zm.Vec2f, count: usize) []zm.Vec2f {
+        const taken = scratch.*[0..count];
+        scratch.* = scratch.*[count..];
+        return taken;
+    }
+
+    ///Scratch points approximateBSplineInto needs for _count_ control points of degree _p_
+    pub fn BSplineScratchSize(count: usize, p: i32) usize {
+        if (count < 2)
+            return 0;
+
+        const n = count - 1;
+        const degree: usize = if (p > 0 and p < n) @intCast(p) else n;
+        const segments = n - degree + 1;
+
+        //points copy + 2 subdivision buffers + the subdivision stack + the SIMD kernel's SoA pieces
+        return count + (degree + 1) + (2 * degree + 1) + (segments + MAX_SUBDIVISION_DEPTH) * (degree + 1) +
+            SOA_PIECE_SLOTS * soaStride(degree + 1);
+    }
+
+    ///Scratch points that are enough for any of the *Into approximators on _count_ control points
+    pub fn ScratchSize(count: usize) usize {
+        //Bezier is the worst case, lagrange weights only need one point worth of space each
+        return @max(BSplineScratchSize(count, 0), count);
+    }
+
+    ///Exact amount of points approximateCatmullInto writes
+    pub fn CatmullOutputSize(count: usize, detail: i32) usize {
+        if (count < 2)
+            return 0;
+
+        return (count - 1) * @as(usize, @intCast(detail)) * 2;
+    }
+
     // Optimized precision check
     pub fn almostEquals(a: f32, b: f32, epsilon: f32) bool {
         return @abs(a - b) < epsilon;
@@ -42,8 +122,14 @@ pub const CurveApproximator = struct {
 
     // Helper functions
     pub fn calculateBarycentricWeights(allocator: Allocator, points: []const zm.Vec2f) ![]f64 {
+        const weights = try allocator.alloc(f64, points.len);
+        calculateBarycentricWeightsInto(points, weights);
+
+        return weights;
+    }
+
+    pub fn calculateBarycentricWeightsInto(points: []const zm.Vec2f, weights: []f64) void {
         const n = points.len;
-        var weights = try allocator.alloc(f64, n);
 
         for (0..n) |i| {
             weights[i] = 1.0;
@@ -54,8 +140,6 @@ pub const CurveApproximator = struct {
             }
             weights[i] = 1.0 / weights[i];
         }
-
-        return weights;
     }
 
     pub fn barycentricLagrange(points: []const zm.Vec2f, weights: []const f64, time: f64) f64 {
@@ -77,7 +161,11 @@ pub const CurveApproximator = struct {
     }
 
     pub fn isBezierFlatEnough(control_points: []const zm.Vec2f) bool {
-        const tolerance_squared = BEZIER_TOLERANCE * BEZIER_TOLERANCE * 4;
+        return isBezierFlatEnoughWithin(control_points, BEZIER_TOLERANCE);
+    }
+
+    pub fn isBezierFlatEnoughWithin(control_points: []const zm.Vec2f, tolerance: f32) bool {
+        const tolerance_squared = tolerance * tolerance * 4;
         //std.debug.print("isBezierFlatEnough control_points.len: {d}\n", .{control_points.len});
 
         for (1..control_points.len - 1) |i| {
@@ -211,106 +299,349 @@ pub const CurveApproximator = struct {
         }
     }
 
+    fn bezierApproximateInto(
+        control_points: []const zm.Vec2f,
+        output: *PointWriter,
+        subdivision_buffer1: []zm.Vec2f,
+        subdivision_buffer2: []zm.Vec2f,
+    ) Error!void {
+        const count = control_points.len;
+
+        bezierSubdivide(control_points, subdivision_buffer2, subdivision_buffer1, subdivision_buffer1);
+
+        for (0..count - 1) |i| {
+            subdivision_buffer2[count + i] = subdivision_buffer1[i + 1];
+        }
+
+        try output.append(control_points[0]);
+
+        for (1..count - 1) |i| {
+            const index = 2 * i;
+            const two = zm.Vec2f{ 2.0, 2.0 };
+            const quarter = zm.Vec2f{ 0.25, 0.25 };
+            try output.append(quarter * (subdivision_buffer2[index - 1] + two * subdivision_buffer2[index] + subdivision_buffer2[index + 1]));
+        }
+    }
+
     // Main approximation functions
     pub fn approximateBezier(allocator: Allocator, control_points: []const zm.Vec2f) ![]zm.Vec2f {
         return approximateBSpline(allocator, control_points, 0);
     }
 
     pub fn approximateBSpline(allocator: Allocator, control_points: []const zm.Vec2f, p: i32) ![]zm.Vec2f {
-        var output = ArrayList(zm.Vec2f).init(allocator);
-        defer output.deinit();
+        const scratch = try allocator.alloc(zm.Vec2f, BSplineScratchSize(control_points.len, p));
+        defer allocator.free(scratch);
+
+        //The flattened size isn't known up front, start with a guess and grow
+        var capacity = control_points.len * 4 + 16;
+
+        while (true) {
+            const output = try allocator.alloc(zm.Vec2f, capacity);
+            errdefer allocator.free(output);
+
+            const result = approximateBSplineInto(control_points, p, output, scratch, .{}) catch |err| switch (err) {
+                error.OutputTooSmall => {
+                    allocator.free(output);
+                    capacity *= 2;
+                    continue;
+                },
+                error.ScratchTooSmall => unreachable,
+            };
+
+            return try allocator.realloc(output, result.len);
+        }
+    }
+
+    pub fn approximateBezierInto(control_points: []const zm.Vec2f, output: []zm.Vec2f, scratch: []zm.Vec2f, tolerance: Tolerance) Error![]zm.Vec2f {
+        return approximateBSplineInto(control_points, 0, output, scratch, tolerance);
+    }
 
-        const n = @as(i32, @intCast(control_points.len)) - 1;
+    ///Flattens into _output_ and returns the written part of it, never allocates. Always the Scalar kernel, the same
+    ///points approximateBSpline returns.
+    ///_scratch_ needs BSplineScratchSize(control_points.len, p) points, subdivision uses a fixed stack of pieces in there.
+    ///Fails with OutputTooSmall when the curve doesn't fit, _output_ is garbage then and the call can be retried with more room.
+    pub fn approximateBSplineInto(control_points: []const zm.Vec2f, p: i32, output: []zm.Vec2f, scratch: []zm.Vec2f, tolerance: Tolerance) Error![]zm.Vec2f {
+        return approximateBSplineIntoKernel(.Scalar, control_points, p, output, scratch, tolerance);
+    }
 
-        if (n < 0) return try output.toOwnedSlice();
+    ///approximateBSplineInto with an explicit bezier kernel, for comparing them
+    pub fn approximateBSplineIntoKernel(comptime kernel: Kernel, control_points: []const zm.Vec2f, p: i32, output: []zm.Vec2f, scratch: []zm.Vec2f, tolerance: Tolerance) Error![]zm.Vec2f {
+        var writer = PointWriter{ .Buffer = output };
 
-        const Stack = ArrayList([]zm.Vec2f);
-        var to_flatten = Stack.init(allocator);
-        defer {
-            // Clean up any remaining slices in the stack
-            while (to_flatten.items.len > 0) {
-                const item = to_flatten.pop().?;
-                allocator.free(item);
-            }
-            to_flatten.deinit();
+        const count = control_points.len;
+
+        if (count == 0)
+            return writer.written();
+
+        if (count == 1) {
+            try writer.append(control_points[0]);
+            return writer.written();
         }
 
-        var points = try allocator.dupe(zm.Vec2f, control_points);
-        defer allocator.free(points);
+        if (scratch.len < BSplineScratchSize(count, p))
+            return error.ScratchTooSmall;
+
+        const n = count - 1;
+        const degree: usize = if (p > 0 and p < n) @intCast(p) else n;
+        const piece_size = degree + 1;
+        const segments = n - degree + 1;
+        const stack_capacity = segments + MAX_SUBDIVISION_DEPTH;
 
-        var actual_p = p;
+        var rest = scratch;
+        const points = takeScratch(&rest, count);
+        const subdivision_buffer1 = takeScratch(&rest, piece_size);
+        const subdivision_buffer2 = takeScratch(&rest, 2 * degree + 1);
+        const stack = takeScratch(&rest, stack_capacity * piece_size);
+        const soa_scratch = takeScratch(&rest, SOA_PIECE_SLOTS * soaStride(piece_size));
 
-        if (p > 0 and p < n) {
-            // B-spline subdivision
-            for (0..@intCast(n - p)) |i| {
-                var sub_bezier = try allocator.alloc(zm.Vec2f, @intCast(p + 1));
+        @memcpy(points, control_points);
+
+        if (degree < n) {
+            //B-spline subdivision, segment i goes in at the mirrored slot so the first one ends up on top of the stack
+            for (0..n - degree) |i| {
+                const sub_bezier = stack[(segments - 1 - i) * piece_size ..][0..piece_size];
                 sub_bezier[0] = points[i];
 
                 // Boehm's algorithm for knot insertion
-                for (0..@intCast(p - 1)) |j| {
+                for (0..degree - 1) |j| {
                     sub_bezier[j + 1] = points[i + 1];
 
-                    for (1..@intCast(p - @as(i32, @intCast(j)))) |k| {
-                        const l = @min(k, @as(usize, @intCast(n - p)) - i);
-                        //const l_float: f32 = @floatFromInt(l);
-
-                        const l_float = zm.Vec2f{ @floatFromInt(l), @floatFromInt(l) };
-                        const l_float_plus_one = zm.Vec2f{ l_float[0] + 1.0, l_float[1] + 1.0 };
+                    for (1..degree - j) |k| {
+                        const l: f32 = @floatFromInt(@min(k, n - degree - i));
+                        const l_float = zm.Vec2f{ l, l };
+                        const l_float_plus_one = zm.Vec2f{ l + 1.0, l + 1.0 };
                         points[i + k] = (l_float * points[i + k] + points[i + k + 1]) / l_float_plus_one;
                     }
                 }
 
-                sub_bezier[@intCast(p)] = points[i + 1];
-                try to_flatten.append(sub_bezier);
+                sub_bezier[degree] = points[i + 1];
             }
 
-            const last_segment = try allocator.dupe(zm.Vec2f, points[@intCast(n - p)..]);
-            try to_flatten.append(last_segment);
-
-            // Reverse stack for correct order
-            var temp_stack = Stack.init(allocator);
-            defer temp_stack.deinit();
-            while (to_flatten.items.len > 0) {
-                const item = to_flatten.pop().?;
-                try temp_stack.append(item);
-            }
-            to_flatten = temp_stack;
+            @memcpy(stack[0..piece_size], points[n - degree ..]);
         } else {
             // Degenerate to single bezier
-            actual_p = n;
-            const points_copy = try allocator.dupe(zm.Vec2f, points);
-            try to_flatten.append(points_copy);
+            @memcpy(stack[0..piece_size], points);
+        }
+
+        switch (kernel) {
+            .Scalar => {
+                //Depth first, the top piece either gets flattened and popped or split in place into right (same slot) and left (above it)
+                var top = segments;
+                while (top > 0) {
+                    const parent = stack[(top - 1) * piece_size ..][0..piece_size];
+
+                    if (top == stack_capacity or isBezierFlatEnoughWithin(parent, tolerance.Bezier)) {
+                        try bezierApproximateInto(parent, &writer, subdivision_buffer1, subdivision_buffer2);
+                        top -= 1;
+                        continue;
+                    }
+
+                    //bezierSubdivide copies the parent out before writing either child, so the right child can overwrite it
+                    const left_child = stack[top * piece_size ..][0..piece_size];
+                    bezierSubdivide(parent, left_child, parent, subdivision_buffer1);
+                    top += 1;
+                }
+            },
+            .Simd => {
+                const soa: []f32 = @as([*]f32, @ptrCast(soa_scratch.ptr))[0 .. soa_scratch.len * 2];
+
+                var top = segments;
+                while (top > 0) : (top -= 1) {
+                    try flattenPieceSimd(stack[(top - 1) * piece_size ..][0..piece_size], &writer, soa, tolerance.Bezier);
+                }
+            },
+        }
+
+        try writer.append(control_points[count - 1]);
+
+        return writer.written();
+    }
+
+    //SIMD bezier kernel
+    //Pieces live as SoA x/y columns padded to a multiple of 8 plus one extra lane group, so De Casteljau and the flatness
+    //test can load 8 neighbours (shifted by 1 or 2) at once without any bounds handling. Lanes past the piece hold
+    //garbage that gets masked out or never read back.
+
+    const SoaPiece = struct {
+        X: []f32,
+        Y: []f32,
+
+        fn at(soa: []f32, stride: usize, slot: usize) SoaPiece {
+            const base = soa[slot * 2 * stride ..];
+            return .{ .X = base[0..stride], .Y = base[stride..][0..stride] };
+        }
+
+        inline fn point(self: SoaPiece, index: usize) zm.Vec2f {
+            return .{ self.X[index], self.Y[index] };
+        }
+    };
+
+    ///Floats per SoA column for a piece of _count_ points, in points of scratch that's also the size of a whole slot
+    fn soaStride(count: usize) usize {
+        return std.mem.alignForward(usize, count, LANES) + LANES;
+    }
+
+    fn flattenPieceSimd(piece: []const zm.Vec2f, writer: *PointWriter, soa: []f32, tolerance: f32) Error!void {
+        const count = piece.len;
+
+        if (count <= 2) {
+            try writer.append(piece[0]);
+            return;
+        }
+
+        if (count <= 4) {
+            try flattenForwardDifferences(piece, writer, tolerance);
+            return;
         }
 
-        // Adaptive subdivision using stack
-        const subdivision_buffer1 = try allocator.alloc(zm.Vec2f, @intCast(actual_p + 1));
-        defer allocator.free(subdivision_buffer1);
-        const subdivision_buffer2 = try allocator.alloc(zm.Vec2f, @intCast(actual_p * 2 + 1));
-        defer allocator.free(subdivision_buffer2);
+        const stride = soaStride(count);
+        const stack_capacity = MAX_SUBDIVISION_DEPTH + 1;
+
+        const buffer = SoaPiece.at(soa, stride, stack_capacity);
+        const left = SoaPiece.at(soa, stride, stack_capacity + 1);
+        const right = SoaPiece.at(soa, stride, stack_capacity + 2);
+
+        const first = SoaPiece.at(soa, stride, 0);
+        for (piece, 0..) |point, i| {
+            first.X[i] = point[0];
+            first.Y[i] = point[1];
+        }
 
-        while (to_flatten.items.len > 0) {
-            const parent = to_flatten.pop().?;
-            defer allocator.free(parent);
+        var top: usize = 1;
+        while (top > 0) {
+            const parent = SoaPiece.at(soa, stride, top - 1);
 
-            if (isBezierFlatEnough(parent)) {
-                try bezierApproximate(parent, &output, subdivision_buffer1, subdivision_buffer2);
+            if (top == stack_capacity or isBezierFlatEnoughSoa(parent, count, tolerance)) {
+                try bezierApproximateSoa(parent, count, writer, buffer, left, right);
+                top -= 1;
                 continue;
             }
 
-            // Subdivide
-            const left_child = try allocator.alloc(zm.Vec2f, @intCast(actual_p + 1));
-            const right_child = try allocator.alloc(zm.Vec2f, @intCast(actual_p + 1));
-            bezierSubdivide(parent, left_child, right_child, subdivision_buffer1);
+            bezierSubdivideSoa(parent, count, SoaPiece.at(soa, stride, top), parent, buffer);
+            top += 1;
+        }
+    }
+
+    fn isBezierFlatEnoughSoa(piece: SoaPiece, count: usize, tolerance: f32) bool {
+        const tolerance_squared: Lane = @splat(tolerance * tolerance * 4);
+        const two: Lane = @splat(2.0);
+        const lane_index = std.simd.iota(u32, LANES);
+        const none: @Vector(LANES, bool) = @splat(false);
+
+        const inner = count - 2;
+
+        var i: usize = 0;
+        while (i < inner) : (i += LANES) {
+            const dx = @as(Lane, piece.X[i..][0..LANES].*) - two * @as(Lane, piece.X[i + 1 ..][0..LANES].*) + @as(Lane, piece.X[i + 2 ..][0..LANES].*);
+            const dy = @as(Lane, piece.Y[i..][0..LANES].*) - two * @as(Lane, piece.Y[i + 1 ..][0..LANES].*) + @as(Lane, piece.Y[i + 2 ..][0..LANES].*);
+
+            const in_range = lane_index < @as(@Vector(LANES, u32), @splat(@intCast(inner - i)));
+            const too_curved = (dx * dx + dy * dy) > tolerance_squared;
+
+            if (@reduce(.Or, @select(bool, in_range, too_curved, none)))
+                return false;
+        }
+
+        return true;
+    }
+
+    ///Same as bezierSubdivide on SoA pieces, _right_ may be _parent_ but _buffer_ can't alias either child
+    fn bezierSubdivideSoa(parent: SoaPiece, count: usize, left: SoaPiece, right: SoaPiece, buffer: SoaPiece) void {
+        const half: Lane = @splat(0.5);
+
+        @memcpy(buffer.X[0..count], parent.X[0..count]);
+        @memcpy(buffer.Y[0..count], parent.Y[0..count]);
+
+        for (0..count) |i| {
+            const last = count - i - 1;
+
+            left.X[i] = buffer.X[0];
+            left.Y[i] = buffer.Y[0];
+            right.X[last] = buffer.X[last];
+            right.Y[last] = buffer.Y[last];
+
+            //Chunks are processed front to back and each one loads its neighbours before storing, so in place is fine.
+            //The last chunk spills past _last_ into values that aren't needed anymore.
+            var j: usize = 0;
+            while (j < last) : (j += LANES) {
+                const x0: Lane = buffer.X[j..][0..LANES].*;
+                const x1: Lane = buffer.X[j + 1 ..][0..LANES].*;
+                const y0: Lane = buffer.Y[j..][0..LANES].*;
+                const y1: Lane = buffer.Y[j + 1 ..][0..LANES].*;
+
+                buffer.X[j..][0..LANES].* = (x0 + x1) * half;
+                buffer.Y[j..][0..LANES].* = (y0 + y1) * half;
+            }
+        }
+    }
+
+    fn bezierApproximateSoa(piece: SoaPiece, count: usize, writer: *PointWriter, buffer: SoaPiece, left: SoaPiece, right: SoaPiece) Error!void {
+        bezierSubdivideSoa(piece, count, left, right, buffer);
+
+        try writer.append(piece.point(0));
 
-            try to_flatten.append(right_child);
-            try to_flatten.append(left_child);
+        const two = zm.Vec2f{ 2.0, 2.0 };
+        const quarter = zm.Vec2f{ 0.25, 0.25 };
+
+        //Same smoothing as bezierApproximate over left followed by right[1..]
+        for (1..count - 1) |i| {
+            const index = 2 * i;
+            const a = if (index - 1 < count) left.point(index - 1) else right.point(index - count);
+            const b = if (index < count) left.point(index) else right.point(index - count + 1);
+            const c = if (index + 1 < count) left.point(index + 1) else right.point(index - count + 2);
+            try writer.append(quarter * (a + two * b + c));
         }
+    }
 
-        if (control_points.len > 0) {
-            try output.append(control_points[control_points.len - 1]);
+    ///Quadratic/cubic fast path: uniform steps by forward differencing, the step count comes from the chord error bound
+    ///(max |B''| * h^2 / 8 <= _tolerance_) so the result is as flat as the adaptive subdivision guarantees.
+    ///Writes every point but the last like the other flatteners.
+    fn flattenForwardDifferences(piece: []const zm.Vec2f, writer: *PointWriter, tolerance: f32) Error!void {
+        const two: zm.Vec2f = @splat(2.0);
+        const three: zm.Vec2f = @splat(3.0);
+        const six: zm.Vec2f = @splat(6.0);
+
+        const cubic = piece.len == 4;
+
+        const p0 = piece[0];
+        const p1 = piece[1];
+        const p2 = piece[2];
+
+        //Power basis a*t^3 + b*t^2 + c*t + p0
+        var a: zm.Vec2f = @splat(0.0);
+        var b = p0 - two * p1 + p2;
+        var c = two * (p1 - p0);
+        var max_second_difference = zm.vec.len(b);
+        var degree: f32 = 2.0;
+
+        if (cubic) {
+            const p3 = piece[3];
+            a = p3 - p0 + three * (p1 - p2);
+            b = three * b;
+            c = three * (p1 - p0);
+            max_second_difference = @max(max_second_difference, zm.vec.len(p1 - two * p2 + p3));
+            degree = 3.0;
         }
 
-        return try output.toOwnedSlice();
+        const steps_needed = @ceil(@sqrt(degree * (degree - 1.0) * max_second_difference / (8.0 * tolerance)));
+        const steps: usize = @intFromFloat(std.math.clamp(steps_needed, 1.0, MAX_FORWARD_STEPS));
+
+        const h: f32 = 1.0 / @as(f32, @floatFromInt(steps));
+        const h_vec: zm.Vec2f = @splat(h);
+        const h2: zm.Vec2f = @splat(h * h);
+        const h3: zm.Vec2f = @splat(h * h * h);
+
+        var point = p0;
+        var first = a * h3 + b * h2 + c * h_vec;
+        var second = six * a * h3 + two * b * h2;
+        const third = six * a * h3;
+
+        for (0..steps) |_| {
+            try writer.append(point);
+            point += first;
+            first += second;
+            second += third;
+        }
     }
 
     pub fn approximateCatmull(allocator: Allocator, control_points: []const zm.Vec2f, detail: i32) ![]zm.Vec2f {
@@ -361,30 +692,76 @@ pub const CurveApproximator = struct {
         }
     }
 
+    ///_output_ needs CatmullOutputSize(control_points.len, detail) points
+    pub fn approximateCatmullInto(control_points: []const zm.Vec2f, detail: i32, output: []zm.Vec2f) Error![]zm.Vec2f {
+        var writer = PointWriter{ .Buffer = output };
+
+        if (output.len < CatmullOutputSize(control_points.len, detail))
+            return error.OutputTooSmall;
+
+        const detail_float: f32 = @floatFromInt(detail);
+
+        for (0..control_points.len -| 1) |i| {
+            const v1 = if (i > 0) control_points[i - 1] else control_points[i];
+            const v2 = control_points[i];
+            const v3 = if (i < control_points.len - 1) control_points[i + 1] else v2 + v2 - v1;
+            const v4 = if (i < control_points.len - 2) control_points[i + 2] else v3 + v3 - v2;
+
+            for (0..@intCast(detail)) |c| {
+                const t1: f32 = @floatFromInt(c);
+                const t2: f32 = @floatFromInt(c + 1);
+                try writer.append(catmullFindPoint(v1, v2, v3, v4, t1 / detail_float));
+                try writer.append(catmullFindPoint(v1, v2, v3, v4, t2 / detail_float));
+            }
+        }
+
+        return writer.written();
+    }
+
+    pub fn circularArcPointCount(props: CircularArcProperties, tolerance: f32) usize {
+        if (2 * props.radius <= tolerance)
+            return 2;
+
+        return @max(2, @as(usize, @intFromFloat(@ceil(props.theta_range / (2 * math.acos(1 - tolerance / props.radius))))));
+    }
+
     pub fn approximateCircularArc(allocator: Allocator, control_points: []const zm.Vec2f) ![]zm.Vec2f {
         const props = getCircularArcProperties(control_points);
         if (!props.is_valid) {
             return approximateBezier(allocator, control_points);
         }
 
-        const amount_points = if (2 * props.radius <= CIRCULAR_ARC_TOLERANCE)
-            2
-        else
-            @max(2, @as(i32, @intFromFloat(@ceil(props.theta_range / (2 * math.acos(1 - CIRCULAR_ARC_TOLERANCE / props.radius))))));
+        const output = try allocator.alloc(zm.Vec2f, circularArcPointCount(props, CIRCULAR_ARC_TOLERANCE));
+        writeCircularArc(props, output);
 
-        var output = ArrayList(zm.Vec2f).init(allocator);
-        defer output.deinit();
-        try output.ensureTotalCapacity(@intCast(amount_points));
+        return output;
+    }
 
-        for (0..@intCast(amount_points)) |i| {
+    ///Needs circularArcPointCount points of _output_, _scratch_ is only used when the arc degenerates into a bezier
+    pub fn approximateCircularArcInto(control_points: []const zm.Vec2f, output: []zm.Vec2f, scratch: []zm.Vec2f, tolerance: Tolerance) Error![]zm.Vec2f {
+        const props = getCircularArcProperties(control_points);
+        if (!props.is_valid) {
+            return approximateBezierInto(control_points, output, scratch, tolerance);
+        }
+
+        const amount_points = circularArcPointCount(props, tolerance.CircularArc);
+        if (output.len < amount_points)
+            return error.OutputTooSmall;
+
+        writeCircularArc(props, output[0..amount_points]);
+
+        return output[0..amount_points];
+    }
+
+    fn writeCircularArc(props: CircularArcProperties, output: []zm.Vec2f) void {
+        const amount_points_f64: f64 = @floatFromInt(output.len - 1);
+
+        for (output, 0..) |*point, i| {
             const fract: f64 = @floatFromInt(i);
-            const amount_points_f64: f64 = @floatFromInt(amount_points - 1);
             const theta = props.theta_start + props.direction * (fract / amount_points_f64) * props.theta_range;
             const offset = zm.Vec2f{ @floatCast(math.cos(theta)), @floatCast(math.sin(theta)) } * zm.Vec2f{ props.radius, props.radius };
-            try output.append(props.centre + offset);
+            point.* = props.centre + offset;
         }
-
-        return try output.toOwnedSlice();
     }
 
     pub fn circularArcBoundingBox(control_points: []const zm.Vec2f) zm.Vec4f {
@@ -437,14 +814,36 @@ pub const CurveApproximator = struct {
     }
 
     pub fn approximateLagrangePolynomial(allocator: Allocator, control_points: []const zm.Vec2f) ![]zm.Vec2f {
-        const num_steps = 51;
-        var result = ArrayList(zm.Vec2f).init(allocator);
-        defer result.deinit();
-        try result.ensureTotalCapacity(num_steps);
+        const output = try allocator.alloc(zm.Vec2f, LAGRANGE_STEPS);
+        errdefer allocator.free(output);
 
-        const weights = try calculateBarycentricWeights(allocator, control_points);
+        const weights = try allocator.alloc(f64, control_points.len);
         defer allocator.free(weights);
 
+        writeLagrangePolynomial(control_points, weights, output);
+
+        return output;
+    }
+
+    ///Needs LAGRANGE_STEPS points of _output_ and control_points.len points of _scratch_ (the weights live there)
+    pub fn approximateLagrangePolynomialInto(control_points: []const zm.Vec2f, output: []zm.Vec2f, scratch: []zm.Vec2f) Error![]zm.Vec2f {
+        if (output.len < LAGRANGE_STEPS)
+            return error.OutputTooSmall;
+
+        if (scratch.len < control_points.len)
+            return error.ScratchTooSmall;
+
+        //A point is 8 bytes with 8 byte alignment, same as an f64
+        const weights = @as([*]f64, @ptrCast(scratch.ptr))[0..control_points.len];
+
+        writeLagrangePolynomial(control_points, weights, output[0..LAGRANGE_STEPS]);
+
+        return output[0..LAGRANGE_STEPS];
+    }
+
+    fn writeLagrangePolynomial(control_points: []const zm.Vec2f, weights: []f64, output: []zm.Vec2f) void {
+        calculateBarycentricWeightsInto(control_points, weights);
+
         var min_x = control_points[0][0];
         var max_x = control_points[0][0];
         for (control_points[1..]) |point| {
@@ -453,13 +852,154 @@ pub const CurveApproximator = struct {
         }
 
         const dx = max_x - min_x;
+        const step = dx / @as(f32, @floatFromInt(output.len - 1));
 
-        for (0..num_steps) |i| {
-            const x = min_x + dx / (num_steps - 1) * @as(f32, @floatFromInt(i));
+        for (output, 0..) |*point, i| {
+            const x = min_x + step * @as(f32, @floatFromInt(i));
             const y: f32 = @floatCast(barycentricLagrange(control_points, weights, x));
-            try result.append(zm.Vec2f{ x, y });
+            point.* = zm.Vec2f{ x, y };
         }
+    }
 
-        return try result.toOwnedSlice();
+    pub fn approximateLinearInto(control_points: []const zm.Vec2f, output: []zm.Vec2f) Error![]zm.Vec2f {
+        if (output.len < control_points.len)
+            return error.OutputTooSmall;
+
+        @memcpy(output[0..control_points.len], control_points);
+
+        return output[0..control_points.len];
     }
 };
+
+//Test curves, the last one is a high degree zigzag
+const CURVES = [_][]const zm.Vec2f{
+    &.{ .{ 0.0, 0.0 }, .{ 150.0, 300.0 }, .{ 300.0, 0.0 } },
+    &.{ .{ 0.0, 0.0 }, .{ 100.0, 200.0 }, .{ 300.0, -100.0 }, .{ 400.0, 100.0 } },
+    &.{ .{ 0.0, 0.0 }, .{ 300.0, 100.0 }, .{ 0.0, 100.0 }, .{ 300.0, 0.0 } },
+    &.{ .{ 0.0, 0.0 }, .{ 100.0, 0.0 }, .{ 200.0, 0.0 }, .{ 300.0, 0.0 } },
+    &.{ .{ 256.0, 192.0 }, .{ 256.0, 192.0 }, .{ 256.0, 192.0 }, .{ 256.0, 192.0 } },
+    &.{ .{ 0.0, 0.0 }, .{ 20.0, 150.0 }, .{ 40.0, 0.0 }, .{ 60.0, 150.0 }, .{ 80.0, 0.0 }, .{ 100.0, 150.0 }, .{ 120.0, 0.0 }, .{ 140.0, 150.0 }, .{ 160.0, 0.0 }, .{ 180.0, 150.0 }, .{ 200.0, 0.0 } },
+};
+
+test "Into approximators write what the allocating ones return" {
+    const allocator = std.testing.allocator;
+
+    var output: [4096]zm.Vec2f = undefined;
+    var scratch: [CurveApproximator.ScratchSize(CURVES[CURVES.len - 1].len)]zm.Vec2f = undefined;
+
+    for (CURVES) |curve| {
+        //Spelled out as Scalar, approximateBezierInto picking another kernel would move gameplay paths
+        const bezier = try CurveApproximator.approximateBezier(allocator, curve);
+        defer allocator.free(bezier);
+        try std.testing.expectEqualSlices(zm.Vec2f, bezier, try CurveApproximator.approximateBSplineIntoKernel(.Scalar, curve, 0, &output, &scratch, .{}));
+        try std.testing.expectEqualSlices(zm.Vec2f, bezier, try CurveApproximator.approximateBezierInto(curve, &output, &scratch, .{}));
+
+        const catmull = try CurveApproximator.approximateCatmull(allocator, curve, 50);
+        defer allocator.free(catmull);
+        try std.testing.expectEqualSlices(zm.Vec2f, catmull, try CurveApproximator.approximateCatmullInto(curve, 50, &output));
+    }
+
+    const arc = [_]zm.Vec2f{ .{ 0.0, 0.0 }, .{ 100.0, 100.0 }, .{ 200.0, 0.0 } };
+    const arc_points = try CurveApproximator.approximateCircularArc(allocator, &arc);
+    defer allocator.free(arc_points);
+    try std.testing.expectEqualSlices(zm.Vec2f, arc_points, try CurveApproximator.approximateCircularArcInto(&arc, &output, &scratch, .{}));
+
+    const lagrange = [_]zm.Vec2f{ .{ 0.0, 0.0 }, .{ 40.0, 80.0 }, .{ 80.0, -20.0 }, .{ 120.0, 60.0 } };
+    const lagrange_points = try CurveApproximator.approximateLagrangePolynomial(allocator, &lagrange);
+    defer allocator.free(lagrange_points);
+    try std.testing.expectEqualSlices(zm.Vec2f, lagrange_points, try CurveApproximator.approximateLagrangePolynomialInto(&lagrange, &output, &scratch));
+}
+
+test "gameplay bezier flattening puts the points where it did before the Into approximators" {
+    const allocator = std.testing.allocator;
+
+    //Written down from the allocating approximateBezier the Into approximators replaced. Every value on the way is a
+    //short dyadic fraction, so they're exact in f32 whatever order the math is done in.
+    const Case = struct { Curve: []const zm.Vec2f, Expected: []const zm.Vec2f };
+    const cases = [_]Case{
+        .{
+            .Curve = &.{ .{ 0.0, 0.0 }, .{ 1.0, 1.0 }, .{ 2.0, 0.0 } },
+            .Expected = &.{ .{ 0.0, 0.0 }, .{ 0.5, 0.375 }, .{ 1.0, 0.5 }, .{ 1.5, 0.375 }, .{ 2.0, 0.0 } },
+        },
+        .{
+            .Curve = &.{ .{ 0.0, 0.0 }, .{ 1.0, 2.0 }, .{ 3.0, 2.0 }, .{ 4.0, 0.0 } },
+            .Expected = &.{
+                .{ 0.0, 0.0 },
+                .{ 0.2685546875, 0.4609375 },
+                .{ 0.5732421875, 0.8359375 },
+                .{ 0.90625, 1.125 },
+                .{ 1.2587890625, 1.3359375 },
+                .{ 1.6259765625, 1.4609375 },
+                .{ 2.0, 1.5 },
+                .{ 2.3740234375, 1.4609375 },
+                .{ 2.7412109375, 1.3359375 },
+                .{ 3.09375, 1.125 },
+                .{ 3.4267578125, 0.8359375 },
+                .{ 3.7314453125, 0.4609375 },
+                .{ 4.0, 0.0 },
+            },
+        },
+    };
+
+    var output: [64]zm.Vec2f = undefined;
+    var scratch: [CurveApproximator.ScratchSize(4)]zm.Vec2f = undefined;
+
+    for (cases) |case| {
+        const bezier = try CurveApproximator.approximateBezier(allocator, case.Curve);
+        defer allocator.free(bezier);
+
+        try std.testing.expectEqualSlices(zm.Vec2f, case.Expected, bezier);
+        try std.testing.expectEqualSlices(zm.Vec2f, case.Expected, try CurveApproximator.approximateBezierInto(case.Curve, &output, &scratch, .{}));
+    }
+}
+
+test "Into approximators fail instead of writing past their buffers" {
+    var output: [4]zm.Vec2f = undefined;
+    var scratch: [CurveApproximator.ScratchSize(CURVES[CURVES.len - 1].len)]zm.Vec2f = undefined;
+
+    try std.testing.expectError(error.OutputTooSmall, CurveApproximator.approximateBezierInto(CURVES[1], &output, &scratch, .{}));
+    try std.testing.expectError(error.ScratchTooSmall, CurveApproximator.approximateBezierInto(CURVES[1], &output, scratch[0..1], .{}));
+    try std.testing.expectError(error.OutputTooSmall, CurveApproximator.approximateCatmullInto(CURVES[1], 50, &output));
+}
+
+test "SIMD bezier kernel stays within tolerance of the scalar one" {
+    var scalar_output: [4096]zm.Vec2f = undefined;
+    var simd_output: [4096]zm.Vec2f = undefined;
+    var scratch: [CurveApproximator.ScratchSize(CURVES[CURVES.len - 1].len)]zm.Vec2f = undefined;
+
+    //Each is within BEZIER_TOLERANCE of the real curve, so of each other within twice that
+    const tolerance = CurveApproximator.BEZIER_TOLERANCE * 2.0;
+
+    for (CURVES) |curve| {
+        for ([_]i32{ 0, 3 }) |degree| {
+            const scalar = try CurveApproximator.approximateBSplineIntoKernel(.Scalar, curve, degree, &scalar_output, &scratch, .{});
+            const simd = try CurveApproximator.approximateBSplineIntoKernel(.Simd, curve, degree, &simd_output, &scratch, .{});
+
+            try std.testing.expectEqual(scalar[0], simd[0]);
+            try std.testing.expectEqual(scalar[scalar.len - 1], simd[simd.len - 1]);
+            try std.testing.expect(testDeviation(scalar, simd) <= tolerance);
+            try std.testing.expect(testDeviation(simd, scalar) <= tolerance);
+        }
+    }
+}
+
+///Largest distance from a point of _points_ to the polyline _line_
+fn testDeviation(points: []const zm.Vec2f, line: []const zm.Vec2f) f32 {
+    var deviation: f32 = 0.0;
+
+    for (points) |point| {
+        var closest = zm.vec.distance(point, line[0]);
+
+        for (0..line.len - 1) |i| {
+            const ab = line[i + 1] - line[i];
+            const length_squared = zm.vec.dot(ab, ab);
+            const t = if (length_squared > 0.0) std.math.clamp(zm.vec.dot(point - line[i], ab) / length_squared, 0.0, 1.0) else 0.0;
+
+            closest = @min(closest, zm.vec.distance(point, line[i] + ab * zm.Vec2f{ t, t }));
+        }
+
+        deviation = @max(deviation, closest);
+    }
+
+    return deviation;
+}
@@ -47,6 +47,19 @@ pub const DrawableManager = struct {
         }
     }
 
+    ///Draw, calling _interleave_ with every object's layer before drawing it and with maxInt(i32) at the end, so things
+    ///drawn outside the manager can go in between by layer
+    pub fn DrawInterleaved(self: *DrawableManager, g: *Graphics, context: anytype, comptime interleave: fn (@TypeOf(context), *Graphics, i32) void) void {
+        const items = self.m_GameObjects.items;
+
+        for (0..items.len) |i| {
+            interleave(context, g, items[i].Layer.*);
+            items[i].OnDrawFn(items[i].BaseObjectPtr, g);
+        }
+
+        interleave(context, g, std.math.maxInt(i32));
+    }
+
     pub fn OnEvent(self: *DrawableManager, event: *const c.SDL_Event) bool {
         const objs = self.m_GameObjects.items;
         for (0..objs.len) |i| {
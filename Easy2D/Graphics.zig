@@ -11,6 +11,7 @@ const VertexBuffer = @import("GLBuffer.zig").GLBuffer(Vertex);
 const IndexBuffer = @import("GLBuffer.zig").GLBuffer(u16);
 
 const Shader = @import("Shader.zig").Shader;
+const SliderGradient = @import("SliderGradient.zig").SliderGradient;
 
 const zm = @import("zm");
 
@@ -47,8 +48,11 @@ const Vertex = packed struct {
 };
 
 const MAX_TEXTURES: usize = 4;
+//The slider gradient keyframes go on the two units after the batch's textures
+const GRADIENT_TEXTURE_UNIT: u8 = MAX_TEXTURES;
 
-const DEFAULT_FRAGMENT_SHADER_SRC = @embedFile("../shaders/main.frag");
+pub const SLIDER_BODY_SHADER_SRC = @embedFile("../shaders/slider_body.glsl");
+const DEFAULT_FRAGMENT_SHADER_SRC = SLIDER_BODY_SHADER_SRC ++ @embedFile("../shaders/main.frag");
 const DEFAULT_VERTEX_SHADER_SRC = @embedFile("../shaders/main.vert");
 
 //const TextureHashMap = std.AutoHashMap(*const Texture, u8);
@@ -61,6 +65,7 @@ pub const Graphics = struct {
     m_Shader: Shader,
 
     m_TextureBindList: TextureBindList,
+    m_SliderGradient: SliderGradient,
 
     ProjectionMatrix: zm.Mat4f = zm.Mat4f.identity(),
     Time: f32 = 0.0,
@@ -74,6 +79,7 @@ pub const Graphics = struct {
             .m_Shader = try Shader.Init(DEFAULT_VERTEX_SHADER_SRC, DEFAULT_FRAGMENT_SHADER_SRC),
 
             .m_TextureBindList = TextureBindList.init(std.heap.c_allocator),
+            .m_SliderGradient = try SliderGradient.Init(),
         };
 
         return graphics;
@@ -94,6 +100,38 @@ pub const Graphics = struct {
         return index;
     }
 
+    ///Batch slots for all of _textures_ at once, flushing first if they don't fit together. They stay valid until another
+    ///texture asks for a slot, so a run of quads using only these can go through DrawRectangleInSlot.
+    pub fn GetTextureSlots(self: *Graphics, comptime N: usize, textures: [N]*const Texture) [N]f32 {
+        comptime std.debug.assert(N <= MAX_TEXTURES);
+
+        var missing: usize = 0;
+        for (textures, 0..) |texture, i| {
+            const bound = for (self.m_TextureBindList.items) |handle| {
+                if (handle == texture.id) break true;
+            } else false;
+
+            //The same texture twice only needs one slot
+            const repeated = for (textures[0..i]) |previous| {
+                if (previous.id == texture.id) break true;
+            } else false;
+
+            if (!bound and !repeated)
+                missing += 1;
+        }
+
+        if (self.m_TextureBindList.items.len + missing > MAX_TEXTURES) {
+            self.EndDraw();
+        }
+
+        var slots: [N]f32 = undefined;
+        for (textures, &slots) |texture, *slot| {
+            slot.* = @floatFromInt(self.getTextureSlot(texture));
+        }
+
+        return slots;
+    }
+
     pub inline fn DrawRectangleCentered(self: *Graphics, pos: zm.Vec2f, size: zm.Vec2f, color: zm.Vec4f, texture: *const Texture, textureRect: zm.Vec4f) void {
         const newPos = pos - size * zm.Vec2f{ 0.5, 0.5 };
 
@@ -176,14 +214,51 @@ pub const Graphics = struct {
         quad[3].TexCoord = .{ texture_rect[0], texture_rect[1] + texture_rect[3] };
     }
 
+    ///A slider body from the depth texture _texture_ (red above 9 is what tells the shader). Green and blue carry the
+    ///position inside the body, since _texture_rect_ is usually just a small part of an atlas page.
+    pub inline fn DrawSliderBody(self: *Graphics, bounds: zm.Vec4f, alpha: f32, texture: *const Texture, texture_rect: zm.Vec4f) void {
+        const slot = self.getTextureSlot(texture);
+
+        var quad = self.m_PrimitiveBatcher.GetQuad();
+
+        const texIDFloat: f32 = @floatFromInt(slot);
+
+        quad[0] = Vertex{
+            .Position = .{ bounds[0], bounds[1] },
+            .TexCoord = .{ texture_rect[0], texture_rect[1] },
+            .Color = .{ 10.0, 0.0, 0.0, alpha },
+            .TexID = texIDFloat,
+        };
+
+        quad[1].Position = .{ bounds[2], bounds[1] };
+        quad[1].TexID = texIDFloat;
+        quad[1].Color = .{ 10.0, 1.0, 0.0, alpha };
+        quad[1].TexCoord = .{ texture_rect[0] + texture_rect[2], texture_rect[1] };
+
+        quad[2].Position = .{ bounds[2], bounds[3] };
+        quad[2].TexID = texIDFloat;
+        quad[2].Color = .{ 10.0, 1.0, 1.0, alpha };
+        quad[2].TexCoord = .{ texture_rect[0] + texture_rect[2], texture_rect[1] + texture_rect[3] };
+
+        quad[3].Position = .{ bounds[0], bounds[3] };
+        quad[3].TexID = texIDFloat;
+        quad[3].Color = .{ 10.0, 0.0, 1.0, alpha };
+        quad[3].TexCoord = .{ texture_rect[0], texture_rect[1] + texture_rect[3] };
+    }
+
     pub inline fn DrawRectangle(self: *Graphics, pos: zm.Vec2f, size: zm.Vec2f, color: zm.Vec4f, texture: *const Texture, textureRect: zm.Vec4f) void {
         const slot = self.getTextureSlot(texture);
 
+        self.DrawRectangleInSlot(pos, size, color, @floatFromInt(slot), textureRect);
+    }
+
+    ///DrawRectangle with a slot from GetTextureSlots, straight into the batcher
+    pub inline fn DrawRectangleInSlot(self: *Graphics, pos: zm.Vec2f, size: zm.Vec2f, color: zm.Vec4f, slot: f32, textureRect: zm.Vec4f) void {
         var quad = self.m_PrimitiveBatcher.GetQuad();
 
         //glm::vec2 rotationOrigin = position;
 
-        const texIDFloat: f32 = @floatFromInt(slot);
+        const texIDFloat = slot;
 
         quad[0] = Vertex{
             .Position = pos,
@@ -214,7 +289,35 @@ pub const Graphics = struct {
         quad[3].TexCoord = .{ textureRect[0], textureRect[1] + textureRect[3] };
     }
 
+    ///Colours and the border gradient for shaders built on SLIDER_BODY_SHADER_SRC, _shader_ has to be in use. Binds the
+    ///gradient to texture units GRADIENT_TEXTURE_UNIT and the one after it.
+    pub fn SetSliderBodyUniforms(self: *const Graphics, shader: *Shader) void {
+        const BorderColorOuter: zm.Vec3f = .{ 0.5, 0.5, 0.5 };
+        const BorderColorInner: zm.Vec3f = .{ 0.5, 0.5, 0.5 };
+
+        const TrackColorInner: zm.Vec3f = .{ 0.2, 0.2, 0.2 };
+        const TrackColorOuter: zm.Vec3f = .{ 0.0, 0.0, 0.0 };
+
+        const ShadowColor: zm.Vec4f = .{ 0.0, 0.0, 0.0, 0.5 };
+
+        const BorderWidth: f32 = 1.0;
+        shader.SetFloat("u_BorderWidth", BorderWidth);
+
+        shader.SetVec3f("u_BorderColorOuter", BorderColorOuter);
+        shader.SetVec3f("u_BorderColorInner", BorderColorInner);
+
+        shader.SetVec3f("u_TrackColorOuter", TrackColorOuter);
+        shader.SetVec3f("u_TrackColorInner", TrackColorInner);
+
+        shader.SetVec4f("u_ShadowColor", ShadowColor);
+
+        self.m_SliderGradient.Bind(shader, GRADIENT_TEXTURE_UNIT);
+    }
+
     pub fn EndDraw(self: *Graphics) void {
+        //Rebakes on its own timer, uploading binds a texture so it goes before the batch's
+        self.m_SliderGradient.Update(self.Time);
+
         //Bind Textures
 
         for (0..self.m_TextureBindList.items.len) |i| {
@@ -237,26 +340,7 @@ pub const Graphics = struct {
         //PrintGLError("tex2");
         self.m_Shader.SetI32("u_tex3", 3);
 
-        const BorderColorOuter: zm.Vec3f = .{ 0.5, 0.5, 0.5 };
-        const BorderColorInner: zm.Vec3f = .{ 0.5, 0.5, 0.5 };
-
-        const TrackColorInner: zm.Vec3f = .{ 0.2, 0.2, 0.2 };
-        const TrackColorOuter: zm.Vec3f = .{ 0.0, 0.0, 0.0 };
-
-        const ShadowColor: zm.Vec4f = .{ 0.0, 0.0, 0.0, 0.5 };
-
-        const BorderWidth: f32 = 1.0;
-        self.m_Shader.SetFloat("u_BorderWidth", BorderWidth);
-
-        self.m_Shader.SetVec3f("u_BorderColorOuter", BorderColorOuter);
-        self.m_Shader.SetVec3f("u_BorderColorInner", BorderColorInner);
-
-        self.m_Shader.SetVec3f("u_TrackColorOuter", TrackColorOuter);
-        self.m_Shader.SetVec3f("u_TrackColorInner", TrackColorInner);
-
-        self.m_Shader.SetVec4f("u_ShadowColor", ShadowColor);
-
-        self.m_Shader.SetFloat("u_Time", self.Time);
+        self.SetSliderBodyUniforms(&self.m_Shader);
         //PrintGLError("tex3");
         //const tmpTexBuf: [16]u8 = undefined;
         //for (0..MAX_TEXTURES) |i| {
@@ -1,41 +1,79 @@
 const std = @import("std");
 
 pub fn PrimitiveBatcher(comptime T: type) type {
+    return IndexedPrimitiveBatcher(T, u16);
+}
+
+///_I_ is the index type, u16 or u32. Every primitive's vertices and indices always land in the same fill, when one
+///doesn't fit OutOfSpaceCallback gets to empty the batcher first (see Flush).
+pub fn IndexedPrimitiveBatcher(comptime T: type, comptime I: type) type {
     return struct {
-        OutOfSpaceCallback: ?*const fn (*PrimitiveBatcher(T)) void = null,
+        const Self = @This();
+
+        OutOfSpaceCallback: ?*const fn (*Self) void = null,
+        //For the callback, the batcher never touches it
+        OutOfSpaceContext: ?*anyopaque = null,
         vertexBuffer: []T,
-        indexBuffer: []u16,
+        indexBuffer: []I,
+
+        vertexWriteIndex: I = 0,
+        indexWriteIndex: u32 = 0,
 
-        vertexWriteIndex: u16 = 0,
-        indexWriteIndex: u16 = 0,
+        //Written before the last Flush calls, see GetStreamVertexCount
+        flushedVertexCount: u32 = 0,
+        flushedIndexCount: u32 = 0,
+
+        pub fn Init(vertexCnt: u32, indexCnt: u32) !Self {
+            //The write index has to be able to count past the last vertex
+            std.debug.assert(vertexCnt <= std.math.maxInt(I));
 
-        pub fn Init(vertexCnt: u16, indexCnt: u16) !PrimitiveBatcher(T) {
             //Primitive batchers are always meant to live for the lifetime of the application
-            const batcher = PrimitiveBatcher(T){
+            const batcher = Self{
                 .vertexBuffer = try std.heap.c_allocator.alloc(T, vertexCnt),
-                .indexBuffer = try std.heap.c_allocator.alloc(u16, indexCnt),
+                .indexBuffer = try std.heap.c_allocator.alloc(I, indexCnt),
             };
             return batcher;
         }
 
-        pub fn ResetWritePosition(self: *PrimitiveBatcher(T)) void {
+        pub fn ResetWritePosition(self: *Self) void {
             self.vertexWriteIndex = 0;
             self.indexWriteIndex = 0;
+            self.flushedVertexCount = 0;
+            self.flushedIndexCount = 0;
         }
 
-        pub fn GetIndexCount(self: *const PrimitiveBatcher(T)) u16 {
+        ///Empties the batcher once its contents are uploaded, for an OutOfSpaceCallback. Unlike ResetWritePosition the
+        ///stream counts keep going.
+        pub fn Flush(self: *Self) void {
+            self.flushedVertexCount += self.vertexWriteIndex;
+            self.flushedIndexCount += self.indexWriteIndex;
+            self.vertexWriteIndex = 0;
+            self.indexWriteIndex = 0;
+        }
+
+        pub fn GetIndexCount(self: *const Self) u32 {
             return self.indexWriteIndex;
         }
 
-        pub fn GetVertexCount(self: *const PrimitiveBatcher(T)) u16 {
+        pub fn GetVertexCount(self: *const Self) I {
             return self.vertexWriteIndex;
         }
 
-        pub fn GetUploadData(self: *PrimitiveBatcher(T)) struct { VertexSlice: []const T, IndexSlice: []const u16 } {
+        ///Vertices written since the last ResetWritePosition, including the ones flushed out in between
+        pub fn GetStreamVertexCount(self: *const Self) u32 {
+            return self.flushedVertexCount + self.vertexWriteIndex;
+        }
+
+        ///Indices written since the last ResetWritePosition, including the ones flushed out in between
+        pub fn GetStreamIndexCount(self: *const Self) u32 {
+            return self.flushedIndexCount + self.indexWriteIndex;
+        }
+
+        pub fn GetUploadData(self: *Self) struct { VertexSlice: []T, IndexSlice: []I } {
             return .{ .VertexSlice = self.vertexBuffer[0..self.vertexWriteIndex], .IndexSlice = self.indexBuffer[0..self.indexWriteIndex] };
         }
 
-        pub inline fn GetTriangle(self: *PrimitiveBatcher(T)) []T {
+        pub inline fn GetTriangle(self: *Self) []T {
             self.checkCapacity(3, 3);
 
             self.indexBuffer[self.indexWriteIndex + 0] = self.vertexWriteIndex + 0;
@@ -48,7 +86,7 @@ pub fn PrimitiveBatcher(comptime T: type) type {
             return self.vertexBuffer[self.vertexWriteIndex - 3 .. self.vertexWriteIndex];
         }
 
-        pub inline fn GetQuad(self: *PrimitiveBatcher(T)) []T {
+        pub inline fn GetQuad(self: *Self) []T {
             self.checkCapacity(4, 6);
 
             self.indexBuffer[self.indexWriteIndex + 0] = self.vertexWriteIndex + 0;
@@ -65,14 +103,14 @@ pub fn PrimitiveBatcher(comptime T: type) type {
             return self.vertexBuffer[self.vertexWriteIndex - 4 .. self.vertexWriteIndex];
         }
 
-        pub inline fn GetTriangleStrip(self: *PrimitiveBatcher(T), pointCount: u16) ![]T {
+        pub inline fn GetTriangleStrip(self: *Self, pointCount: u16) ![]T {
             if (pointCount < 3)
                 return error.InvalidPointCount;
 
-            self.checkCapacity(pointCount, (pointCount - 2) * 3);
+            self.checkCapacity(pointCount, (@as(u32, pointCount) - 2) * 3);
 
             for (0..pointCount - 2) |idx| {
-                const i: u16 = @intCast(idx);
+                const i: I = @intCast(idx);
                 // use i
 
                 self.indexBuffer[self.indexWriteIndex + 0] = self.vertexWriteIndex + i;
@@ -85,14 +123,15 @@ pub fn PrimitiveBatcher(comptime T: type) type {
             return self.vertexBuffer[self.vertexWriteIndex - pointCount .. self.vertexWriteIndex];
         }
 
-        pub inline fn GetTriangleFan(self: *PrimitiveBatcher(T), pointCount: u16) ![]T {
+        pub inline fn GetTriangleFan(self: *Self, pointCount: u16) ![]T {
             if (pointCount < 3)
                 return error.InvalidPointCount;
 
-            self.checkCapacity(pointCount, (pointCount - 2) * 3);
+            self.checkCapacity(pointCount, (@as(u32, pointCount) - 2) * 3);
 
-            for (0..pointCount - 1) |idx| {
-                const i: u16 = @intCast(idx);
+            //Triangles (0, i, i + 1), starting at 1 so there's no degenerate (0, 0, 1) one
+            for (1..pointCount - 1) |idx| {
+                const i: I = @intCast(idx);
                 // use i
 
                 self.indexBuffer[self.indexWriteIndex + 0] = self.vertexWriteIndex;
@@ -105,23 +144,23 @@ pub fn PrimitiveBatcher(comptime T: type) type {
             return self.vertexBuffer[self.vertexWriteIndex - pointCount .. self.vertexWriteIndex];
         }
 
-        inline fn checkCapacity(self: *PrimitiveBatcher(T), vCount: u32, iCount: u32) void {
-            if (self.vertexWriteIndex + vCount > self.vertexBuffer.len) {
+        inline fn checkCapacity(self: *Self, vCount: u32, iCount: u32) void {
+            if (@as(usize, self.vertexWriteIndex) + vCount > self.vertexBuffer.len) {
                 if (self.OutOfSpaceCallback) |oomCallback| {
                     oomCallback(self);
                 }
 
-                if (self.vertexWriteIndex + vCount > self.vertexBuffer.len)
-                    std.debug.panic("Unhandled VertexBuffer capacity overflow {d} > {d}", .{ (self.vertexWriteIndex + vCount), self.vertexBuffer.len });
+                if (@as(usize, self.vertexWriteIndex) + vCount > self.vertexBuffer.len)
+                    std.debug.panic("Unhandled VertexBuffer capacity overflow {d} > {d}", .{ (@as(usize, self.vertexWriteIndex) + vCount), self.vertexBuffer.len });
             }
 
-            if (self.indexWriteIndex + iCount > self.indexBuffer.len) {
+            if (@as(usize, self.indexWriteIndex) + iCount > self.indexBuffer.len) {
                 if (self.OutOfSpaceCallback) |oomCallback| {
                     oomCallback(self);
                 }
 
-                if (self.indexWriteIndex + iCount > self.indexBuffer.len)
-                    std.debug.panic("Unhandled IndexBuffer capacity overflow {d} > {d}", .{ (self.indexWriteIndex + iCount), self.indexBuffer.len });
+                if (@as(usize, self.indexWriteIndex) + iCount > self.indexBuffer.len)
+                    std.debug.panic("Unhandled IndexBuffer capacity overflow {d} > {d}", .{ (@as(usize, self.indexWriteIndex) + iCount), self.indexBuffer.len });
             }
         }
     };
@@ -0,0 +1,180 @@
+//The animated border gradient of slider bodies, baked into small textures
+//slider_body.glsl used to evaluate effect() (gradient noise, a sin wave warp and three rotations) for every body
+//fragment every frame, most of a slider's fill cost on weak GPUs. The gradient is smooth over the body and changes
+//slowly, so it's computed here on the CPU at SIZE x SIZE texels for keyframes REFRESH_HZ apart. The shader
+//blends the two keyframes around the current time, a body fragment costs two fetches and a few mixes.
+
+const std = @import("std");
+
+const c = @import("../CImports.zig").c;
+const Texture = @import("Texture.zig").Texture;
+const Shader = @import("Shader.zig").Shader;
+
+pub const SliderGradient = struct {
+    //Over the whole body, the gradient has no features smaller than a few percent of it
+    const SIZE: usize = 64;
+    const REFRESH_HZ: f32 = 20.0;
+
+    //Keyframe m_Frame and the one after it
+    m_Keyframes: [2]Texture,
+    m_Frame: ?i64 = null,
+    //Between the two keyframes, 0 to 1
+    m_Blend: f32 = 0.0,
+    m_Pixels: [SIZE * SIZE * 3]u8 = undefined,
+
+    pub fn Init() !SliderGradient {
+        var first = try Texture.Init2(c.GL_TEXTURE_2D, SIZE, SIZE, c.GL_RGB, c.GL_RGB, c.GL_UNSIGNED_BYTE);
+        errdefer first.Deinit();
+
+        const second = try Texture.Init2(c.GL_TEXTURE_2D, SIZE, SIZE, c.GL_RGB, c.GL_RGB, c.GL_UNSIGNED_BYTE);
+
+        return .{
+            .m_Keyframes = .{ first, second },
+        };
+    }
+
+    pub fn Deinit(self: *SliderGradient) void {
+        self.m_Keyframes[0].Deinit();
+        self.m_Keyframes[1].Deinit();
+    }
+
+    ///Bakes the keyframes around _time_ (seconds) unless they already are
+    pub fn Update(self: *SliderGradient, time: f32) void {
+        const position = time * REFRESH_HZ;
+        const frame: i64 = @intFromFloat(@floor(position));
+
+        self.m_Blend = position - @floor(position);
+
+        if (self.m_Frame) |current| {
+            if (frame == current)
+                return;
+
+            //Moved on by one, the old second keyframe is still good
+            if (frame == current + 1) {
+                std.mem.swap(Texture, &self.m_Keyframes[0], &self.m_Keyframes[1]);
+                self.bake(1, frame + 1);
+                self.m_Frame = frame;
+                return;
+            }
+        }
+
+        self.bake(0, frame);
+        self.bake(1, frame + 1);
+        self.m_Frame = frame;
+    }
+
+    ///Binds the keyframes to texture units _first_unit_ and the one after it and points _shader_'s samplers at them,
+    ///_shader_ has to be in use
+    pub fn Bind(self: *const SliderGradient, shader: *Shader, first_unit: u8) void {
+        self.m_Keyframes[0].Bind(first_unit);
+        self.m_Keyframes[1].Bind(first_unit + 1);
+
+        shader.SetI32("u_Gradient0", first_unit);
+        shader.SetI32("u_Gradient1", first_unit + 1);
+        shader.SetFloat("u_GradientBlend", self.m_Blend);
+    }
+
+    fn bake(self: *SliderGradient, keyframe: usize, frame: i64) void {
+        const time = @as(f32, @floatFromInt(frame)) / REFRESH_HZ;
+        const size: f32 = @floatFromInt(SIZE);
+
+        for (0..SIZE) |y| {
+            for (0..SIZE) |x| {
+                //Texel centres, v goes down the body like the shader's diller
+                const uv = [2]f32{ (@as(f32, @floatFromInt(x)) + 0.5) / size, (@as(f32, @floatFromInt(y)) + 0.5) / size };
+                const color = effect(uv, time);
+
+                const pixel = self.m_Pixels[(y * SIZE + x) * 3 ..][0..3];
+                for (pixel, color) |*channel, value| {
+                    channel.* = @intFromFloat(@round(std.math.clamp(value, 0.0, 1.0) * 255.0));
+                }
+            }
+        }
+
+        self.m_Keyframes[keyframe].Bind(0);
+        c.glTexSubImage2D(c.GL_TEXTURE_2D, 0, 0, 0, SIZE, SIZE, c.GL_RGB, c.GL_UNSIGNED_BYTE, &self.m_Pixels);
+    }
+
+    //What slider_body.glsl's effect() was, line by line
+    fn effect(uv: [2]f32, time: f32) [3]f32 {
+        const ratio: f32 = 2.0;
+
+        var tuv = [2]f32{ uv[0] - 0.5, uv[1] - 0.5 };
+
+        //Rotate with noise
+        const degree = noise(.{ time * 0.1, tuv[0] * tuv[1] });
+
+        tuv[1] *= 1.0 / ratio;
+        tuv = rotate(tuv, std.math.degreesToRadians((degree - 0.5) * 720.0 + 180.0));
+        tuv[1] *= ratio;
+
+        //Wave warp with sin
+        const frequency: f32 = 5.0;
+        const amplitude: f32 = 10.0;
+        const speed = time * 5.0;
+        tuv[0] += @sin(tuv[1] * frequency + speed) / amplitude;
+        tuv[1] += @sin(tuv[0] * frequency * 1.5 + speed) / (amplitude * 0.5);
+
+        const color_yellow = [3]f32{ 0.957, 0.804, 0.623 };
+        const color_deep_blue = [3]f32{ 0.192, 0.384, 0.933 };
+        const color_red = [3]f32{ 0.910, 0.510, 0.8 };
+        const color_blue = [3]f32{ 0.350, 0.71, 0.953 };
+
+        const across = smoothstep(-0.3, 0.2, rotate(tuv, std.math.degreesToRadians(@as(f32, -5.0)))[0]);
+        const layer1 = mix3(color_yellow, color_deep_blue, across);
+        const layer2 = mix3(color_red, color_blue, across);
+
+        return mix3(layer1, layer2, smoothstep(0.5, -0.3, tuv[1]));
+    }
+
+    //tuv * Rot(a) in GLSL, mat2(c, -s, s, c) is column major
+    fn rotate(v: [2]f32, angle: f32) [2]f32 {
+        const s = @sin(angle);
+        const co = @cos(angle);
+        return .{ v[0] * co - v[1] * s, v[0] * s + v[1] * co };
+    }
+
+    //Created by inigo quilez - iq/2014
+    //License Creative Commons Attribution-NonCommercial-ShareAlike 3.0 Unported License.
+    fn noise(p: [2]f32) f32 {
+        const i = [2]f32{ @floor(p[0]), @floor(p[1]) };
+        const f = [2]f32{ p[0] - i[0], p[1] - i[1] };
+        const u = [2]f32{ f[0] * f[0] * (3.0 - 2.0 * f[0]), f[1] * f[1] * (3.0 - 2.0 * f[1]) };
+
+        const n = mix(
+            mix(corner(i, f, 0.0, 0.0), corner(i, f, 1.0, 0.0), u[0]),
+            mix(corner(i, f, 0.0, 1.0), corner(i, f, 1.0, 1.0), u[0]),
+            u[1],
+        );
+
+        return 0.5 + 0.5 * n;
+    }
+
+    //dot(-1.0 + 2.0 * hash(i + o), f - o)
+    fn corner(i: [2]f32, f: [2]f32, ox: f32, oy: f32) f32 {
+        const h = hash(.{ i[0] + ox, i[1] + oy });
+        return (-1.0 + 2.0 * h[0]) * (f[0] - ox) + (-1.0 + 2.0 * h[1]) * (f[1] - oy);
+    }
+
+    fn hash(p: [2]f32) [2]f32 {
+        const q = [2]f32{ p[0] * 2127.1 + p[1] * 81.17, p[0] * 1269.5 + p[1] * 283.37 };
+        return .{ fract(@sin(q[0]) * 43758.5453), fract(@sin(q[1]) * 43758.5453) };
+    }
+
+    fn fract(x: f32) f32 {
+        return x - @floor(x);
+    }
+
+    fn mix(a: f32, b: f32, t: f32) f32 {
+        return a + (b - a) * t;
+    }
+
+    fn mix3(a: [3]f32, b: [3]f32, t: f32) [3]f32 {
+        return .{ mix(a[0], b[0], t), mix(a[1], b[1], t), mix(a[2], b[2], t) };
+    }
+
+    fn smoothstep(edge0: f32, edge1: f32, x: f32) f32 {
+        const t = std.math.clamp((x - edge0) / (edge1 - edge0), 0.0, 1.0);
+        return t * t * (3.0 - 2.0 * t);
+    }
+};
@@ -1,4 +1,5 @@
 const std = @import("std");
+const zm = @import("zm");
 const c = @cImport({
     @cInclude("GLES2/gl2.h");
     @cInclude("stb_image.h");
@@ -73,6 +74,83 @@ pub const Texture = struct {
         return texture;
     }
 
+    ///Decodes every image in _file_datas_ and puts them side by side in one texture, so things that are drawn together
+    ///take a single texture slot. _texture_rects_ gets where each one ended up (x, y, width, height like Graphics takes).
+    pub fn InitSheet(allocator: std.mem.Allocator, file_datas: []const []const u8, texture_rects: []zm.Vec4f) !Texture {
+        //Transparent texels between images, enough that the smaller mip levels don't mix neighbours
+        const SHEET_PADDING: i32 = 16;
+
+        std.debug.assert(file_datas.len == texture_rects.len);
+
+        const images = try allocator.alloc([*c]u8, file_datas.len);
+        defer allocator.free(images);
+
+        const sizes = try allocator.alloc([2]i32, file_datas.len);
+        defer allocator.free(sizes);
+
+        var decoded: usize = 0;
+        defer {
+            for (images[0..decoded]) |image| {
+                c.stbi_image_free(image);
+            }
+        }
+
+        var sheet_width: i32 = 0;
+        var sheet_height: i32 = 0;
+
+        for (file_datas, 0..) |file_data, i| {
+            var channels: i32 = 0;
+            images[i] = c.stbi_load_from_memory(file_data.ptr, @intCast(file_data.len), &sizes[i][0], &sizes[i][1], &channels, 4);
+
+            if (images[i] == null)
+                return error.STBI_COULDNT_LOAD_FROM_MEMORY;
+
+            decoded += 1;
+
+            sheet_width += sizes[i][0] + if (i > 0) SHEET_PADDING else 0;
+            sheet_height = @max(sheet_height, sizes[i][1]);
+        }
+
+        const pixels = try allocator.alloc(u8, @intCast(sheet_width * sheet_height * 4));
+        defer allocator.free(pixels);
+
+        @memset(pixels, 0);
+
+        var x: i32 = 0;
+        for (images, sizes, texture_rects) |image, size, *texture_rect| {
+            const row_bytes: usize = @intCast(size[0] * 4);
+
+            for (0..@intCast(size[1])) |row| {
+                const destination: usize = (row * @as(usize, @intCast(sheet_width)) + @as(usize, @intCast(x))) * 4;
+                @memcpy(pixels[destination..][0..row_bytes], image[row * row_bytes ..][0..row_bytes]);
+            }
+
+            texture_rect.* = .{
+                @as(f32, @floatFromInt(x)) / @as(f32, @floatFromInt(sheet_width)),
+                0.0,
+                @as(f32, @floatFromInt(size[0])) / @as(f32, @floatFromInt(sheet_width)),
+                @as(f32, @floatFromInt(size[1])) / @as(f32, @floatFromInt(sheet_height)),
+            };
+
+            x += size[0] + SHEET_PADDING;
+        }
+
+        var texture = Texture{ .id = 0, .target = c.GL_TEXTURE_2D, .internalFormat = c.GL_RGBA, .format = c.GL_RGBA, .pixelType = c.GL_UNSIGNED_BYTE, .width = sheet_width, .height = sheet_height, .channels = 4 };
+        c.glGenTextures(1, &texture.id);
+
+        std.debug.print("Loaded Texture[{d}] {d}x{d} // sheet of {d} images\n", .{ texture.id, texture.width, texture.height, file_datas.len });
+
+        texture.Bind(0);
+        c.glTexParameteri(c.GL_TEXTURE_2D, c.GL_TEXTURE_MAG_FILTER, c.GL_LINEAR);
+        c.glTexParameteri(c.GL_TEXTURE_2D, c.GL_TEXTURE_WRAP_S, c.GL_CLAMP_TO_EDGE);
+        c.glTexParameteri(c.GL_TEXTURE_2D, c.GL_TEXTURE_WRAP_T, c.GL_CLAMP_TO_EDGE);
+        c.glTexImage2D(texture.target, 0, texture.internalFormat, texture.width, texture.height, 0, texture.format, texture.pixelType, pixels.ptr);
+        c.glTexParameteri(c.GL_TEXTURE_2D, c.GL_TEXTURE_MIN_FILTER, c.GL_LINEAR_MIPMAP_LINEAR);
+        c.glGenerateMipmap(texture.target);
+
+        return texture;
+    }
+
     pub fn Bind(self: *const Texture, slot: u8) void {
         if (self.id == 0)
             return;
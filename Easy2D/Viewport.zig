@@ -22,6 +22,10 @@ pub const Viewport = struct {
         _height = height;
     }
 
+    pub fn GetPosition() zm.vec.Vec(2, i32) {
+        return .{ _x, _y };
+    }
+
     pub fn GetSize() zm.vec.Vec(2, i32) {
         return .{ _width, _height };
     }
@@ -0,0 +1,157 @@
+//Song time for a whole frame
+//Asking BASS for the position is an FFI call and a bytes to seconds conversion, and the answer only moves when the
+//device's buffer gets refilled, so it advances in steps of a few milliseconds and stands still in between. Reading it
+//per object also gave every object a slightly different time within the same frame.
+//Update samples it once per frame. In between steps, time keeps running off std.time.Instant scaled by the playback
+//rate. The difference to the audio (extrapolated from when its position last moved) is worked off over
+//DRIFT_CORRECTION_MS instead of jumping, and time never runs backwards while playing. Only a seek or a stall bigger
+//than SNAP_MS, or the song being paused, makes it jump to the audio position.
+
+const std = @import("std");
+
+const Sound = @import("Sound.zig").Sound;
+
+pub const GameClock = struct {
+    //Drift is worked off exponentially with this time constant
+    const DRIFT_CORRECTION_MS: f64 = 100.0;
+    const SNAP_MS: f64 = 100.0;
+
+    m_Time: f64 = 0.0,
+    m_Rate: f64 = 1.0,
+
+    //Instants are kept as nanoseconds since the first Update, so the smoothing can be driven without a real clock
+    m_Epoch: ?std.time.Instant = null,
+    m_FrameNs: ?u64 = null,
+    //Last position the audio reported and when it did, to extrapolate from
+    m_AudioTime: f64 = 0.0,
+    m_AudioNs: ?u64 = null,
+
+    ///Song position in milliseconds as of the last Update
+    pub fn GetTimeMs(self: *const GameClock) f64 {
+        return self.m_Time;
+    }
+
+    pub fn GetRate(self: *const GameClock) f64 {
+        return self.m_Rate;
+    }
+
+    ///Has to follow every Sound.SetPlaybackRate on the song, otherwise the difference only gets corrected as drift
+    pub fn SetRate(self: *GameClock, rate: f64) void {
+        self.m_Rate = rate;
+    }
+
+    ///Jumps to the audio position on the next Update, after a seek
+    pub fn Snap(self: *GameClock) void {
+        self.m_FrameNs = null;
+        self.m_AudioNs = null;
+    }
+
+    ///Samples _song_ once, call at the start of every frame
+    pub fn Update(self: *GameClock, song: *const Sound) void {
+        const audio_time = song.GetPlaybackPositionInSeconds() * 1000.0;
+        const now = std.time.Instant.now() catch {
+            //No monotonic clock, just use the audio as is
+            self.m_Time = audio_time;
+            return;
+        };
+
+        if (self.m_Epoch == null)
+            self.m_Epoch = now;
+
+        self.advance(audio_time, song.IsPlaying(), now.since(self.m_Epoch.?));
+    }
+
+    //Update with the audio position, whether it's playing and the time of the frame in nanoseconds since m_Epoch
+    fn advance(self: *GameClock, audio_time: f64, playing: bool, now_ns: u64) void {
+        defer self.m_FrameNs = now_ns;
+
+        if (self.m_FrameNs == null or self.m_AudioNs == null or !playing)
+            return self.snapTo(audio_time, now_ns);
+
+        const previous_frame = self.m_FrameNs.?;
+
+        if (audio_time != self.m_AudioTime) {
+            self.m_AudioTime = audio_time;
+            self.m_AudioNs = now_ns;
+        }
+
+        const elapsed_ms = @as(f64, @floatFromInt(now_ns -| previous_frame)) / std.time.ns_per_ms;
+        const since_audio_ms = @as(f64, @floatFromInt(now_ns -| self.m_AudioNs.?)) / std.time.ns_per_ms;
+
+        const predicted = self.m_Time + elapsed_ms * self.m_Rate;
+        const audio_estimate = self.m_AudioTime + since_audio_ms * self.m_Rate;
+        const drift = audio_estimate - predicted;
+
+        if (@abs(drift) > SNAP_MS)
+            return self.snapTo(audio_time, now_ns);
+
+        const correction = drift * (1.0 - @exp(-elapsed_ms / DRIFT_CORRECTION_MS));
+
+        //Running ahead only slows it down
+        self.m_Time = @max(self.m_Time, predicted + correction);
+    }
+
+    fn snapTo(self: *GameClock, audio_time: f64, now_ns: u64) void {
+        self.m_Time = audio_time;
+        self.m_AudioTime = audio_time;
+        self.m_AudioNs = now_ns;
+    }
+};
+
+const MS = std.time.ns_per_ms;
+
+test "time runs on between audio steps and follows the audio when it moves" {
+    var clock = GameClock{};
+
+    clock.advance(1000.0, true, 0);
+    try std.testing.expectEqual(@as(f64, 1000.0), clock.GetTimeMs());
+
+    //The audio position stands still until the device buffer is refilled
+    clock.advance(1000.0, true, 5 * MS);
+    try std.testing.expectApproxEqAbs(@as(f64, 1005.0), clock.GetTimeMs(), 1e-9);
+
+    clock.advance(1010.0, true, 10 * MS);
+    try std.testing.expectApproxEqAbs(@as(f64, 1010.0), clock.GetTimeMs(), 1e-9);
+
+    clock.SetRate(2.0);
+    clock.advance(1010.0, true, 15 * MS);
+    try std.testing.expectApproxEqAbs(@as(f64, 1020.0), clock.GetTimeMs(), 1e-9);
+}
+
+test "drift is worked off gradually and never runs time backwards" {
+    var clock = GameClock{};
+
+    clock.advance(1000.0, true, 0);
+    clock.advance(1000.0, true, 5 * MS);
+
+    //20ms ahead of the prediction, only part of it is caught up this frame
+    clock.advance(1030.0, true, 10 * MS);
+    try std.testing.expect(clock.GetTimeMs() > 1010.0);
+    try std.testing.expect(clock.GetTimeMs() < 1030.0);
+
+    //Behind, time slows down but doesn't go back
+    const before = clock.GetTimeMs();
+    clock.advance(1000.0, true, 11 * MS);
+    try std.testing.expect(clock.GetTimeMs() >= before);
+    try std.testing.expect(clock.GetTimeMs() < before + 1.0);
+}
+
+test "seeks, pauses and Snap jump to the audio position" {
+    var clock = GameClock{};
+
+    clock.advance(1000.0, true, 0);
+    clock.advance(1000.0, true, 5 * MS);
+
+    //More than SNAP_MS off
+    clock.advance(5000.0, true, 10 * MS);
+    try std.testing.expectEqual(@as(f64, 5000.0), clock.GetTimeMs());
+
+    clock.advance(4000.0, false, 15 * MS);
+    try std.testing.expectEqual(@as(f64, 4000.0), clock.GetTimeMs());
+
+    //Would be smoothed towards without the Snap
+    clock.advance(4000.0, true, 20 * MS);
+    clock.Snap();
+    clock.advance(4030.0, true, 25 * MS);
+    try std.testing.expectEqual(@as(f64, 4030.0), clock.GetTimeMs());
+}
@@ -0,0 +1,115 @@
+//Minimal .lzma (LZMA-alone) encoder
+
+//std only has an lzma decoder and .osr replay data has to be lzma. This encoder never emits matches, every byte is
+//coded as a literal with the normal adaptive probability model, which is still a valid stream for any decoder.
+//Replay text is mostly digits and separators so the literal model alone already gets it to a fraction of its size,
+//and the encoder stays a single small pass with a fixed amount of state.
+
+const std = @import("std");
+
+//lc=3 lp=0 pb=2, the defaults everything uses
+const LC = 3;
+const PB_MASK: usize = (1 << 2) - 1;
+const PROPERTIES: u8 = (2 * 5 + 0) * 9 + LC;
+const DICTIONARY_SIZE: u32 = 1 << 21;
+
+const NUM_BIT_MODEL_TOTAL_BITS = 11;
+const BIT_MODEL_TOTAL: u16 = 1 << NUM_BIT_MODEL_TOTAL_BITS;
+const NUM_MOVE_BITS = 5;
+const TOP_VALUE: u32 = 1 << 24;
+
+const RangeEncoder = struct {
+    Low: u64 = 0,
+    Range: u32 = 0xFFFF_FFFF,
+    Cache: u8 = 0,
+    CacheSize: u64 = 1,
+    Output: *std.ArrayList(u8),
+
+    fn encodeBit(self: *RangeEncoder, prob: *u16, bit: u1) !void {
+        const bound = (self.Range >> NUM_BIT_MODEL_TOTAL_BITS) * prob.*;
+
+        if (bit == 0) {
+            self.Range = bound;
+            prob.* += (BIT_MODEL_TOTAL - prob.*) >> NUM_MOVE_BITS;
+        } else {
+            self.Low += bound;
+            self.Range -= bound;
+            prob.* -= prob.* >> NUM_MOVE_BITS;
+        }
+
+        while (self.Range < TOP_VALUE) {
+            self.Range <<= 8;
+            try self.shiftLow();
+        }
+    }
+
+    fn shiftLow(self: *RangeEncoder) !void {
+        if (self.Low < 0xFF00_0000 or self.Low >= (1 << 32)) {
+            const carry: u8 = @intCast(self.Low >> 32);
+            var temp = self.Cache;
+
+            while (true) {
+                try self.Output.append(temp +% carry);
+                temp = 0xFF;
+
+                self.CacheSize -= 1;
+                if (self.CacheSize == 0)
+                    break;
+            }
+
+            self.Cache = @intCast((self.Low >> 24) & 0xFF);
+        }
+
+        self.CacheSize += 1;
+        self.Low = (self.Low & 0x00FF_FFFF) << 8;
+    }
+
+    fn flush(self: *RangeEncoder) !void {
+        for (0..5) |_| {
+            try self.shiftLow();
+        }
+    }
+};
+
+///Compresses _data_ into a complete .lzma stream (13 byte header included), caller owns the returned slice
+pub fn Compress(allocator: std.mem.Allocator, data: []const u8) ![]u8 {
+    var output = std.ArrayList(u8).init(allocator);
+    errdefer output.deinit();
+
+    //Literals rarely compress worse than half
+    try output.ensureTotalCapacity(13 + data.len / 2 + 16);
+
+    //Header: properties, dictionary size, uncompressed size
+    try output.append(PROPERTIES);
+    try output.writer().writeInt(u32, DICTIONARY_SIZE, .little);
+    try output.writer().writeInt(u64, data.len, .little);
+
+    //Literals only ever happen in state 0, so only that row of is_match is needed
+    var is_match = [_]u16{BIT_MODEL_TOTAL / 2} ** (PB_MASK + 1);
+    var literal_probs = [_]u16{BIT_MODEL_TOTAL / 2} ** (0x300 << LC);
+
+    var encoder = RangeEncoder{ .Output = &output };
+
+    var prev_byte: u8 = 0;
+    for (data, 0..) |byte, position| {
+        try encoder.encodeBit(&is_match[position & PB_MASK], 0);
+
+        const probs = literal_probs[0x300 * @as(usize, prev_byte >> (8 - LC)) ..][0..0x300];
+
+        var symbol: usize = 1;
+        var i: u4 = 8;
+        while (i > 0) {
+            i -= 1;
+            const bit: u1 = @intCast((byte >> @as(u3, @intCast(i))) & 1);
+
+            try encoder.encodeBit(&probs[symbol], bit);
+            symbol = (symbol << 1) | bit;
+        }
+
+        prev_byte = byte;
+    }
+
+    try encoder.flush();
+
+    return try output.toOwnedSlice();
+}
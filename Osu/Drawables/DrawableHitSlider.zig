@@ -9,21 +9,27 @@ const Texture = @import("../../Easy2D/Texture.zig").Texture;
 const PlayableBeatmap = @import("../PlayableBeatmap.zig").PlayableBeatmap;
 const HitSlider = @import("../OsuParser.zig").HitSlider;
 const HitObject = @import("../OsuParser.zig").HitObject;
-const SliderType = @import("../OsuParser.zig").HitSliderType;
+const Path = @import("../SliderPath.zig").Path;
+const PathCursor = @import("../SliderPath.zig").PathCursor;
+const FlattenDetail = @import("../SliderPath.zig").FlattenDetail;
+const SliderCurveCache = @import("../SliderCurveCache.zig").SliderCurveCache;
+const SliderShape = @import("../SliderCurveCache.zig").SliderShape;
+const SliderLod = @import("../SliderLod.zig").SliderLod;
+const SliderAtlas = @import("../SliderAtlas.zig").SliderAtlas;
+const SliderDistanceField = @import("../SliderDistanceField.zig");
+const StaticSliderMesh = @import("../SliderMesh.zig").StaticSliderMesh;
+const SliderBatcher = @import("../SliderMesh.zig").SliderBatcher;
 
 const PlayScene = @import("../../Scenes/PlayScene.zig").PlayScene;
-const DrawableHitCircle = @import("DrawableHitCircle.zig").DrawableHitCircle;
+const HitCircleRenderer = @import("../HitCircleRenderer.zig").HitCircleRenderer;
 const Skin = @import("../Skin.zig").Skin;
+const SliderSheet = @import("../Skin.zig").SliderSheet;
 
 const Viewport = @import("../../Easy2D/Viewport.zig").Viewport;
 
-const CurveApproximator = @import("../../CurveApproximator.zig").CurveApproximator;
 const MathUtils = @import("../../MathUtils.zig").MathUtils;
 
 const Shader = @import("../../Easy2D/Shader.zig").Shader;
-const IndexBuffer = @import("../../Easy2D/GLBuffer.zig").GLBuffer(u16);
-const VertexBuffer = @import("../../Easy2D/GLBuffer.zig").GLBuffer(SliderVertex);
-const PrimitiveBatcher = @import("../../Easy2D/PrimitiveBatcher.zig").PrimitiveBatcher(SliderVertex);
 
 const Profiler = @import("../../Profiler.zig").Profiler;
 
@@ -32,116 +38,88 @@ const Graphics = @import("../../Easy2D/Graphics.zig").Graphics;
 const zm = @import("zm");
 const Input = @import("../../Input.zig").Input;
 
-const SliderVertex = extern struct {
-    X: f32,
-    Y: f32,
-    Depth: f32,
-
-    pub fn EnableVertexAttribs() void {
-        c.glEnableVertexAttribArray(0);
-        c.glVertexAttribPointer(0, 3, c.GL_FLOAT, c.GL_FALSE, 12, @ptrFromInt(0));
-    }
-
-    pub fn DisableVertexAttribs() void {
-        c.glDisableVertexAttribArray(0);
-    }
-};
-
-pub const Path = struct {
-    Points: []const zm.Vec2f,
-    Length: f32,
-    Bounds: zm.Vec4f,
-    Position: zm.Vec2f,
-    Width: i32,
-    Height: i32,
-    PointRadius: f32,
-
-    pub fn Init(points: []const zm.Vec2f, point_radius: f32) Path {
-        const length = CalculateLength(points);
-        var bounds = CalculateBounds(points);
-
-        bounds[0] -= point_radius;
-        bounds[1] -= point_radius;
-        bounds[2] += point_radius;
-        bounds[3] += point_radius;
-
-        return .{
-            .Points = points,
-            .Length = length,
-            .Bounds = bounds,
-            .Position = .{ bounds[0], bounds[1] },
-            .Width = @as(i32, @intFromFloat(bounds[2] - bounds[0])),
-            .Height = @as(i32, @intFromFloat(bounds[3] - bounds[1])),
-            .PointRadius = point_radius,
-        };
-    }
-
-    pub fn CalculatePositionAt(self: *const Path, l: f32) zm.Vec2f {
-        var length = l;
-        if (length <= 0)
-            return self.Points[0];
-
-        if (length >= self.Length)
-            return self.Points[self.Points.len - 1];
-
-        for (0..self.Points.len - 1) |i| {
-            const now = self.Points[i];
-            const next = self.Points[i + 1];
-
-            const dist = zm.vec.distance(now, next);
-
-            if (length - dist <= 0) {
-                const blend = length / dist;
-
-                return zm.vec.lerp(now, next, blend);
-            }
-
-            length -= dist;
-        }
-
-        return self.Points[self.Points.len - 1];
-    }
-
-    pub fn CalculateLength(points: []const zm.Vec2f) f32 {
-        var length: f32 = 0.0;
-        for (0..points.len - 1) |i| {
-            length += zm.vec.distance(points[i], points[i + 1]);
-        }
-
-        return length;
-    }
-
-    pub fn CalculateBounds(points: []const zm.Vec2f) zm.Vec4f {
-        var xmin = std.math.floatMax(f32);
-        var xmax: f32 = 0.0;
-        var ymin = std.math.floatMax(f32);
-        var ymax: f32 = 0.0;
-
-        for (points) |current| {
-            if (xmin > current[0])
-                xmin = current[0];
-
-            if (ymin > current[1])
-                ymin = current[1];
-
-            if (xmax < current[0])
-                xmax = current[0];
-
-            if (ymax < current[1])
-                ymax = current[1];
+const _SliderVertSrc = @embedFile("../../shaders/slider.vert");
+const _SliderFragSrc = @embedFile("../../shaders/slider.frag");
+const _SliderDirectVertSrc = @embedFile("../../shaders/slider_direct.vert");
+const _SliderDirectFragSrc = Graphics.SLIDER_BODY_SHADER_SRC ++ @embedFile("../../shaders/slider_direct.frag");
+const _SliderSnakeFragSrc = @embedFile("../../shaders/slider_snake.frag");
+
+///How slider bodies get on screen
+pub const SliderRenderMode = enum {
+    ///Rendered once into the slider atlas and drawn as a textured quad in the Graphics batch. While snaking the visible
+    ///part is rendered every frame into a region of its own instead, the shared body is always the whole slider.
+    Offscreen,
+    ///Drawn every frame straight into the main framebuffer, no render target switches but every body flushes the
+    ///Graphics batch. For tiled GPUs where an FBO switch costs more than redrawing the geometry.
+    Direct,
+    ///Like Offscreen, but the body is a distance field computed on the CPU at reduced resolution (see
+    ///SliderDistanceField), no depth textures. Offscreen falls back to it when OES_depth_texture is missing. Snaking
+    ///bodies are rendered like in Offscreen.
+    DistanceField,
+
+    pub fn FromString(name: []const u8) ?SliderRenderMode {
+        inline for (comptime std.enums.values(SliderRenderMode)) |mode| {
+            if (std.ascii.eqlIgnoreCase(name, @tagName(mode)))
+                return mode;
         }
 
-        return .{ xmin, ymin, xmax, ymax };
+        return null;
     }
 };
 
-const _SliderVertSrc = @embedFile("../../shaders/slider.vert");
-const _SliderFragSrc = @embedFile("../../shaders/slider.frag");
+//Direct mode gives every slider drawn in a frame its own slice of the depth range, later ones nearer, so one depth
+//clear per frame is enough
+const DIRECT_DEPTH_LAYERS: u32 = 64;
+
+//Sizes of the decorations relative to the circle size. The follow circle texture is twice the circle's in the default
+//skin, it grows to it when the slider starts and fades out at the end.
+const TICK_SCALE: f32 = 0.2;
+const FOLLOW_CIRCLE_SCALE: f32 = 2.0;
+const FOLLOW_CIRCLE_GROW_MS: f32 = 150.0;
+const FOLLOW_CIRCLE_FADE_MS: f32 = 200.0;
+
+//Bodies in the atlas are rendered at the playfield's screen pixels per osu pixel, so they're as sharp as the screen
+//and as big as it needs. A resize only changes that once the playfield kept its new size for a while, dragging a
+//window edge would re-render everything every frame otherwise. The bodies of sliders still on screen are then
+//re-rendered as they're drawn, a few per frame, the others are drawn stretched until their turn comes.
+const RESCALE_DEBOUNCE_NS: u64 = 250 * std.time.ns_per_ms;
+const RERENDER_BUDGET_NS: u64 = 2 * std.time.ns_per_ms;
+//Before the playfield is known its scale is 0
+const MIN_BODY_SCALE: f32 = 0.25;
+
+var _RenderMode: SliderRenderMode = .Offscreen;
+var _DirectLayer: u32 = 0;
+
+//0 until the first frame
+var _BodyScale: f32 = 0.0;
+//Playfield scale that differs from _BodyScale and since when, while it settles
+var _PendingScale: f32 = 0.0;
+var _PendingSince: ?std.time.Instant = null;
+//Spent on re-rendering stale bodies this frame
+var _RerenderNs: u64 = 0;
 
 var _SliderShader: ?Shader = null;
-var _SliderBatcher: ?PrimitiveBatcher = null;
-var _SliderVtxBuffer: ?VertexBuffer = null;
-var _SliderIdxBuffer: ?IndexBuffer = null;
+var _SliderDirectShader: ?Shader = null;
+var _SliderDepthShader: ?Shader = null;
+var _SliderSnakeShader: ?Shader = null;
+var _SliderBatcher: ?SliderBatcher = null;
+var _CurveCache: ?SliderCurveCache = null;
+var _SliderAtlas: ?SliderAtlas = null;
+var _DistanceAtlas: ?SliderAtlas = null;
+var _SnakeAtlas: ?SliderAtlas = null;
+var _DepthTextures: ?bool = null;
+
+//Part of the path the body covers, in osu pixels along it
+const SnakeRange = struct {
+    Start: f32,
+    End: f32,
+};
+
+const SliderTick = struct {
+    //Osu pixels along the path, on a reversed span it's passed the other way round
+    Distance: f32,
+    Position: zm.Vec2f,
+};
 
 pub const DrawableHitSlider = struct {
     Layer: i32 = 0,
@@ -149,9 +127,29 @@ pub const DrawableHitSlider = struct {
     Beatmap: *const PlayableBeatmap,
     StackingOffset: zm.Vec2f,
     HitObject: HitObject,
+    //Flattened at osu!'s detail, what the ball, ticks and arrows follow
     Path: Path,
-    SliderTexture: Texture,
-    FBO: c_uint,
+    //Flattened at the display's detail, what the body is drawn from. Path itself at the default detail, otherwise
+    //c_allocator and freed with the slider.
+    BodyPath: Path,
+    OwnsBodyPath: bool = false,
+    SliderBallCursor: PathCursor = .{},
+    //One per end of the body so snaking in and out never makes them search
+    SnakeStartCursor: PathCursor = .{},
+    SnakeEndCursor: PathCursor = .{},
+    Shape: *SliderShape,
+    //Body geometry for snaking and direct rendering, gone once the slider is dead
+    Mesh: StaticSliderMesh,
+    //The same on every span, c_allocator
+    Ticks: []SliderTick,
+    //Set once the atlas had no room for the body, so it isn't retried every frame
+    BodyUnavailable: bool = false,
+    DistanceBodyUnavailable: bool = false,
+    //Only this slider's, in _SnakeAtlas while snaking, with the range and scale it was last rendered at
+    SnakeBody: ?SliderAtlas.Region = null,
+    SnakeBodyRange: SnakeRange = .{ .Start = 0.0, .End = 0.0 },
+    SnakeBodyScale: f32 = 0.0,
+    SnakeBodyUnavailable: bool = false,
     pub fn GetData(self: *@This()) DrawableData {
         return .{
             .BaseObjectPtr = @constCast(@ptrCast(self)),
@@ -165,7 +163,8 @@ pub const DrawableHitSlider = struct {
         };
     }
 
-    pub fn New(allocator: std.mem.Allocator, hit_object: HitObject, beatmap: *const PlayableBeatmap, stacking_offset: zm.Vec2f, layer: i32) *DrawableHitSlider {
+    ///_object_index_ is _hit_object_'s index in the beatmap, used to pick up the path precomputed at load
+    pub fn New(allocator: std.mem.Allocator, hit_object: HitObject, object_index: usize, beatmap: *const PlayableBeatmap, stacking_offset: zm.Vec2f, layer: i32) *DrawableHitSlider {
         var drawable_slider = allocator.create(DrawableHitSlider) catch unreachable;
 
         drawable_slider.IsDead = false;
@@ -174,321 +173,596 @@ pub const DrawableHitSlider = struct {
         drawable_slider.Beatmap = beatmap;
         drawable_slider.HitObject = hit_object;
 
-        //todo make these global because theres no reason to recreate memory
+        if (_CurveCache == null) {
+            _CurveCache = SliderCurveCache.Init(std.heap.c_allocator);
+        }
+
         //Profiler.Start("Slider_Parse");
-        var cp_temp_buffer = std.ArrayList(zm.Vec2f).init(allocator);
-        defer cp_temp_buffer.deinit();
-        var full_path_buffer = std.ArrayList(zm.Vec2f).init(allocator);
+        //Picked per slider, so after a resize new sliders come out at the new detail
+        const lod = SliderLod.Current();
+
+        //Flattened on the load threads, always at the default detail so the display never changes gameplay
+        const precomputed = beatmap.GetSliderPath(object_index);
+
+        //The body comes from the load threads too: the gameplay path when it's already as fine as the LOD asks for,
+        //otherwise the one flattened at the LOD's detail. Only a resize since the load leaves it to the cache.
+        var body_detail = lod.Flatten;
+        var body = beatmap.GetSliderBodyPath(object_index, lod.Flatten);
+        if (precomputed != null and (FlattenDetail{}).Satisfies(lod.Flatten)) {
+            body_detail = .{};
+            body = precomputed;
+        }
 
-        //Add the start todo just do this in the parser lol.
-        cp_temp_buffer.append(zm.Vec2f{ @floatFromInt(hit_object.X), @floatFromInt(hit_object.Y) }) catch unreachable;
+        const shape = _CurveCache.?.Get(&hit_object, beatmap.CircleSizeOsuPixels, body_detail, if (body) |path| path.Points else null) catch unreachable;
 
-        const slider_points = drawable_slider.HitObject.HitSlider.?.CurvePoints.items;
+        drawable_slider.OwnsBodyPath = body == null;
 
-        const slider_type: SliderType = hit_object.HitSlider.?.Type;
+        if (drawable_slider.OwnsBodyPath) {
+            //Cached points are relative to the head, only moving them is left to do per slider
+            const head = zm.Vec2f{ @floatFromInt(hit_object.X), @floatFromInt(hit_object.Y) };
+            const path_slice = std.heap.c_allocator.alloc(zm.Vec2f, shape.Points.len) catch unreachable;
+            for (path_slice, shape.Points) |*point, relative| {
+                point.* = relative + head;
+            }
 
-        for (slider_points, 0..slider_points.len) |now, i| {
-            const next = slider_points[@min(i + 1, slider_points.len - 1)];
+            drawable_slider.BodyPath = Path.Init(std.heap.c_allocator, path_slice, beatmap.CircleSizeOsuPixels) catch unreachable;
+        } else {
+            //Owned by the beatmap, nothing to copy
+            drawable_slider.BodyPath = body.?.*;
+        }
 
-            cp_temp_buffer.append(zm.Vec2f{ @floatFromInt(now.X), @floatFromInt(now.Y) }) catch unreachable;
+        //Only missing if it failed to build at load, nothing is flattened again for it
+        drawable_slider.Path = if (precomputed) |path| path.* else drawable_slider.BodyPath;
 
-            if (now.X == next.X and now.Y == next.Y) {
-                if (cp_temp_buffer.items.len < 2) {
-                    //full_path_buffer.appendSlice(cp_temp_buffer.items) catch unreachable;
-                    continue;
-                    //@breakpoint();
-                }
+        drawable_slider.SliderBallCursor = .{};
+        drawable_slider.SnakeStartCursor = .{};
+        drawable_slider.SnakeEndCursor = .{};
 
-                switch (slider_type) {
-                    .Bezier => {
-                        if (cp_temp_buffer.items.len >= 3) {
-                            //@breakpoint();
-                            const bezier = CurveApproximator.approximateBezier(allocator, cp_temp_buffer.items) catch unreachable;
-                            defer allocator.free(bezier);
-                            full_path_buffer.appendSlice(bezier) catch unreachable;
-                        } else {
-                            //2 point path is just a straight one so just add the control points as-is
-                            full_path_buffer.appendSlice(cp_temp_buffer.items) catch unreachable;
-                        }
-                    },
-                    .Linear => {
-                        const linear = cp_temp_buffer.items;
-                        full_path_buffer.appendSlice(linear) catch unreachable;
-                    },
-                    .PerfectCircle => {
-                        if (cp_temp_buffer.items.len < 3)
-                            @breakpoint();
-
-                        const perfect_cirlce = CurveApproximator.approximateCircularArc(allocator, cp_temp_buffer.items) catch unreachable;
-                        defer allocator.free(perfect_cirlce);
-                        full_path_buffer.appendSlice(perfect_cirlce) catch unreachable;
-                    },
-                    .Catmull => {
-                        if (cp_temp_buffer.items.len < 3)
-                            @breakpoint();
-
-                        const catmull = CurveApproximator.approximateCatmull(allocator, cp_temp_buffer.items, 50) catch unreachable;
-                        defer allocator.free(catmull);
-                        full_path_buffer.appendSlice(catmull) catch unreachable;
-                    },
-                }
+        //std.debug.print("Target: {d} Actual: {d}\n", .{ hit_object.HitSlider.?.PixelLength, drawable_slider.Path.Length });
 
-                cp_temp_buffer.clearRetainingCapacity();
-            }
+        //Profiler.End("Slider_Parse");
+
+        drawable_slider.Shape = shape;
+
+        const ticks = beatmap.Beatmap.GetSliderTicks(&hit_object, drawable_slider.Path.Length);
+        drawable_slider.Ticks = std.heap.c_allocator.alloc(SliderTick, ticks.Count) catch unreachable;
+
+        for (drawable_slider.Ticks, 0..) |*tick, i| {
+            const distance = @as(f32, @floatFromInt(i + 1)) * ticks.Spacing;
+            tick.* = .{ .Distance = distance, .Position = drawable_slider.Path.CalculatePositionAt(distance) };
         }
 
-        //trim path
-        var target_length = hit_object.HitSlider.?.PixelLength;
-        const items = full_path_buffer.items;
-        for (0..items.len - 1) |i| {
-            const dist = zm.vec.distance(items[i], items[i + 1]);
+        drawable_slider.BodyUnavailable = false;
+        drawable_slider.DistanceBodyUnavailable = false;
+        drawable_slider.SnakeBody = null;
+        drawable_slider.SnakeBodyUnavailable = false;
 
-            if (target_length - dist <= 0) {
-                const blend = target_length / dist;
+        if (_SliderBatcher == null) {
+            _SliderBatcher = StaticSliderMesh.InitBatcher() catch unreachable;
+        }
 
-                const final_point_adjusted = zm.vec.lerp(items[i], items[i + 1], blend);
+        drawable_slider.Mesh = StaticSliderMesh.Init(std.heap.c_allocator, &_SliderBatcher.?, &drawable_slider.BodyPath, &lod) catch unreachable;
 
-                full_path_buffer.shrinkRetainingCapacity(i + 1);
-                full_path_buffer.append(final_point_adjusted) catch unreachable;
-                break;
-            }
+        switch (activeRenderMode()) {
+            .Offscreen => _ = drawable_slider.ensureBody(),
+            .DistanceField => _ = drawable_slider.ensureDistanceBody(),
+            .Direct => {},
+        }
+
+        return drawable_slider;
+    }
+
+    ///Frees what a slider that never got added holds on to (see SliderPrerenderer)
+    pub fn Discard(self: *DrawableHitSlider) void {
+        self.release();
+    }
 
-            target_length -= dist;
+    fn release(self: *DrawableHitSlider) void {
+        //Its body stays in the atlas until the room is needed, in case the same shape comes up again
+        _CurveCache.?.Release(self.Shape);
+        self.freeSnakeBody();
+        self.Mesh.Deinit(std.heap.c_allocator);
+        std.heap.c_allocator.free(self.Ticks);
+
+        if (self.OwnsBodyPath) {
+            std.heap.c_allocator.free(self.BodyPath.Points);
+            self.BodyPath.Deinit(std.heap.c_allocator);
         }
+    }
 
-        const path_slice = full_path_buffer.toOwnedSlice() catch unreachable;
+    pub fn SetRenderMode(mode: SliderRenderMode) void {
+        _RenderMode = mode;
+    }
 
-        drawable_slider.Path = Path.Init(path_slice, beatmap.CircleSizeOsuPixels);
+    ///The mode that was asked for, see activeRenderMode for the one that's used
+    pub fn GetRenderMode() SliderRenderMode {
+        return _RenderMode;
+    }
 
-        //std.debug.print("Target: {d} Actual: {d}\n", .{ hit_object.HitSlider.?.PixelLength, drawable_slider.Path.Length });
+    ///Prints the mode in use and what the bodies alive take up in every atlas, next to the frame times in main this is
+    ///what the render modes are compared by
+    pub fn PrintStats() void {
+        std.debug.print("Slider bodies: {s}", .{@tagName(activeRenderMode())});
+
+        inline for (.{ .{ "depth", &_SliderAtlas }, .{ "distance", &_DistanceAtlas }, .{ "snake", &_SnakeAtlas } }) |entry| {
+            if (entry[1].*) |*atlas| {
+                const bodies = atlas.GetLiveRegionCount();
+                const live_bytes = atlas.GetLiveBytes();
+
+                std.debug.print(", {s} {d} bodies {d} KB ({d} bytes/body, pages {d} KB)", .{
+                    entry[0],
+                    bodies,
+                    live_bytes / 1024,
+                    if (bodies > 0) live_bytes / bodies else 0,
+                    atlas.GetPageBytes() / 1024,
+                });
+            }
+        }
 
-        //Profiler.End("Slider_Parse");
-        const slider_texture = Texture.Init2(c.GL_TEXTURE_2D, drawable_slider.Path.Width, drawable_slider.Path.Height, c.GL_DEPTH_COMPONENT, c.GL_DEPTH_COMPONENT, c.GL_UNSIGNED_SHORT) catch unreachable;
+        std.debug.print("\n", .{});
+    }
+
+    fn activeRenderMode() SliderRenderMode {
+        if (_RenderMode == .Offscreen and !supportsDepthTextures())
+            return .DistanceField;
+
+        return _RenderMode;
+    }
 
-        //const before_fbo_size = Viewport.GetSize();
+    fn supportsDepthTextures() bool {
+        if (_DepthTextures == null) {
+            const extensions = c.glGetString(c.GL_EXTENSIONS);
+            const names = if (extensions != null) std.mem.span(@as([*:0]const u8, @ptrCast(extensions))) else "";
+            _DepthTextures = std.mem.indexOf(u8, names, "GL_OES_depth_texture") != null or std.mem.indexOf(u8, names, "GL_ANGLE_depth_texture") != null;
 
-        var fbo: c_uint = undefined;
-        c.glGenFramebuffers(1, &fbo);
-        c.glBindFramebuffer(c.GL_FRAMEBUFFER, fbo);
-        c.glFramebufferTexture2D(c.GL_FRAMEBUFFER, c.GL_DEPTH_ATTACHMENT, slider_texture.target, slider_texture.id, 0);
-        //c.glFramebufferTexture2D(slider_texture.target, attachment: GLenum, textarget: GLenum, texture: GLuint, level: GLint)
-        //c.glFramebufferTexture2D(target: GLenum, attachment: GLenum, textarget: GLenum, texture: GLuint, level: GLint)
+            if (!_DepthTextures.?)
+                std.debug.print("No depth textures, offscreen slider bodies are distance fields\n", .{});
+        }
+
+        return _DepthTextures.?;
+    }
 
-        const fbo_status = c.glCheckFramebufferStatus(c.GL_FRAMEBUFFER);
+    ///Call once per frame before any slider draws, with the depth buffer cleared
+    pub fn BeginFrame() void {
+        _DirectLayer = 0;
+        _RerenderNs = 0;
+        updateBodyScale();
+    }
 
-        if (fbo_status != c.GL_FRAMEBUFFER_COMPLETE) {
-            //get err xd
+    fn updateBodyScale() void {
+        const scale = @max(PlayableBeatmap.OsuToWorldScale(), MIN_BODY_SCALE);
 
-            std.debug.print("ERROR::FBO:: Framebuffer is not complete!\n", .{});
+        if (scale == _BodyScale) {
+            _PendingSince = null;
+            return;
         }
 
-        c.glBindFramebuffer(c.GL_FRAMEBUFFER, 0);
+        //Nothing rendered at the old scale worth waiting for
+        if (_BodyScale == 0.0) {
+            _BodyScale = scale;
+            return;
+        }
 
-        drawable_slider.FBO = fbo;
-        drawable_slider.SliderTexture = slider_texture;
+        const now = std.time.Instant.now() catch return;
 
-        OffScreenSliderRender(drawable_slider);
+        if (_PendingSince == null or scale != _PendingScale) {
+            _PendingScale = scale;
+            _PendingSince = now;
+            return;
+        }
 
-        return drawable_slider;
+        if (now.since(_PendingSince.?) < RESCALE_DEBOUNCE_NS)
+            return;
+
+        std.debug.print("Slider bodies: rescaling from {d:.2} to {d:.2}\n", .{ _BodyScale, scale });
+
+        _BodyScale = scale;
+        _PendingSince = null;
+
+        //Bodies nobody is using are at the old scale, drop them now so the atlases can shrink
+        if (_CurveCache) |*cache| {
+            inline for (.{ &_SliderAtlas, &_DistanceAtlas, &_SnakeAtlas }) |maybe_atlas| {
+                if (maybe_atlas.*) |*atlas| {
+                    _ = cache.EvictUnusedBodies(atlas);
+                    _ = atlas.ReleaseEmptyPages();
+                }
+            }
+        }
     }
 
-    fn OffScreenSliderRender(self: *DrawableHitSlider) void {
-        if (_SliderShader == null) {
-            _SliderShader = Shader.Init(_SliderVertSrc, _SliderFragSrc) catch unreachable;
+    fn currentBodyScale() f32 {
+        //Sliders created before the first frame (prerendered)
+        if (_BodyScale == 0.0)
+            return @max(PlayableBeatmap.OsuToWorldScale(), MIN_BODY_SCALE);
+
+        return _BodyScale;
+    }
+
+    ///Whether a body rendered at _scale_ should be rendered again, false once this frame's re-render budget is spent
+    fn shouldRerender(scale: f32) bool {
+        return scale != currentBodyScale() and _RerenderNs < RERENDER_BUDGET_NS;
+    }
+
+    ///Renders the body into the atlas unless a slider with the same shape already did at the current scale, null if
+    ///there's no room for it
+    fn ensureBody(self: *DrawableHitSlider) ?SliderAtlas.Region {
+        var replaced = false;
+
+        //The body is drawn relative to the path bounds, so a copy pasted slider can use the same region anywhere
+        if (self.Shape.Body) |body| {
+            if (!shouldRerender(self.Shape.BodyScale))
+                return body;
+
+            //Every slider with this shape picks up the new one
+            _SliderAtlas.?.Free(body);
+            self.Shape.Body = null;
+            replaced = true;
+        } else if (self.BodyUnavailable) {
+            return null;
         }
 
-        if (_SliderBatcher == null) {
-            _SliderBatcher = PrimitiveBatcher.Init(65000, 65000) catch unreachable;
+        if (_SliderAtlas == null) {
+            _SliderAtlas = SliderAtlas.Init(std.heap.c_allocator, .Depth);
         }
 
-        if (_SliderVtxBuffer == null) {
-            _SliderVtxBuffer = VertexBuffer.Init(c.GL_ARRAY_BUFFER) catch unreachable;
+        const start = std.time.Instant.now() catch null;
+        defer if (replaced) countRerender(start);
+
+        const scale = currentBodyScale();
+
+        if (allocateBody(&_SliderAtlas.?, scaledSize(&self.BodyPath, scale))) |region| {
+            OffScreenSliderRender(self, region);
+            self.Shape.Body = region;
+            self.Shape.BodyScale = scale;
+        } else {
+            self.BodyUnavailable = true;
         }
 
-        if (_SliderIdxBuffer == null) {
-            _SliderIdxBuffer = IndexBuffer.Init(c.GL_ELEMENT_ARRAY_BUFFER) catch unreachable;
+        return self.Shape.Body;
+    }
+
+    ///ensureBody for the distance field body
+    fn ensureDistanceBody(self: *DrawableHitSlider) ?SliderAtlas.Region {
+        var replaced = false;
+
+        if (self.Shape.DistanceBody) |body| {
+            if (!shouldRerender(self.Shape.DistanceBodyScale))
+                return body;
+
+            _DistanceAtlas.?.Free(body);
+            self.Shape.DistanceBody = null;
+            replaced = true;
+        } else if (self.DistanceBodyUnavailable) {
+            return null;
         }
 
-        const util = struct {
-            pub inline fn placeCircle(center: zm.Vec2f, radius: f32) void {
-                const SEGMENTS: u16 = 40;
-                const ANGLE_STEP: f32 = 2.0 * std.math.pi / @as(f32, @floatFromInt(SEGMENTS));
+        if (_DistanceAtlas == null) {
+            _DistanceAtlas = SliderAtlas.Init(std.heap.c_allocator, .Distance);
+        }
 
-                var circle_verts = _SliderBatcher.?.GetTriangleFan(SEGMENTS + 2) catch unreachable;
+        const atlas = &_DistanceAtlas.?;
 
-                circle_verts[0] = .{
-                    .X = center[0],
-                    .Y = center[1],
-                    .Depth = 0.0,
-                };
+        const start = std.time.Instant.now() catch null;
+        defer if (replaced) countRerender(start);
 
-                for (0..SEGMENTS + 1) |i| {
-                    const angle = @as(f32, @floatFromInt(i)) * ANGLE_STEP;
+        const scale = currentBodyScale();
 
-                    const x: f32 = center[0] + radius * @cos(angle);
-                    const y: f32 = center[1] + radius * @sin(angle);
+        const region = allocateBody(atlas, SliderDistanceField.GetSize(&self.BodyPath, scale)) orelse {
+            self.DistanceBodyUnavailable = true;
+            return null;
+        };
 
-                    circle_verts[i + 1] = .{
-                        .X = x,
-                        .Y = y,
-                        .Depth = -1.0,
-                    };
-                }
+        const width: usize = @intCast(region.Width);
+        const height: usize = @intCast(region.Height);
+
+        const pixels = std.heap.c_allocator.alloc(u8, width * height) catch unreachable;
+        defer std.heap.c_allocator.free(pixels);
+
+        SliderDistanceField.Render(std.heap.c_allocator, pixels, width, height, &self.BodyPath) catch unreachable;
+        atlas.Upload(region, pixels);
+
+        self.Shape.DistanceBody = region;
+        self.Shape.DistanceBodyScale = scale;
+        return region;
+    }
+
+    ///The _snake_ part of the body in this slider's own region of the snake atlas, rendered again whenever the range
+    ///moved. Null if there's no room for it.
+    fn ensureSnakeBody(self: *DrawableHitSlider, snake: SnakeRange) ?SliderAtlas.Region {
+        if (self.SnakeBodyUnavailable)
+            return null;
+
+        const scale = currentBodyScale();
+
+        if (self.SnakeBody != null and self.SnakeBodyScale != scale)
+            self.freeSnakeBody();
+
+        if (self.SnakeBody == null) {
+            if (_SnakeAtlas == null) {
+                _SnakeAtlas = SliderAtlas.Init(std.heap.c_allocator, .Color);
             }
 
-            pub inline fn drawLineSegment(start: zm.Vec2f, end: zm.Vec2f, perpendicular: zm.Vec2f, half_thickness: zm.Vec2f) void {
-                const offset = perpendicular * half_thickness;
+            self.SnakeBody = allocateBody(&_SnakeAtlas.?, scaledSize(&self.BodyPath, scale)) orelse {
+                self.SnakeBodyUnavailable = true;
+                return null;
+            };
+            self.SnakeBodyScale = scale;
+        } else if (std.meta.eql(self.SnakeBodyRange, snake)) {
+            return self.SnakeBody;
+        }
+
+        self.snakeRender(self.SnakeBody.?, snake);
+        self.SnakeBodyRange = snake;
 
-                const top_side = _SliderBatcher.?.GetQuad();
+        return self.SnakeBody;
+    }
 
-                top_side[0].X = start[0] + offset[0];
-                top_side[0].Y = start[1] + offset[1];
-                top_side[0].Depth = -1.0;
+    fn freeSnakeBody(self: *DrawableHitSlider) void {
+        if (self.SnakeBody) |body| {
+            _SnakeAtlas.?.Free(body);
+            self.SnakeBody = null;
+        }
+    }
 
-                top_side[1].X = start[0];
-                top_side[1].Y = start[1];
-                top_side[1].Depth = 0.0;
+    ///Adds the time since _start_ to this frame's re-render budget. Bodies rendered for the first time aren't counted,
+    ///they can't wait.
+    fn countRerender(start: ?std.time.Instant) void {
+        const begin = start orelse return;
+        const now = std.time.Instant.now() catch return;
+        _RerenderNs += now.since(begin);
+    }
 
-                top_side[2].X = end[0];
-                top_side[2].Y = end[1];
-                top_side[2].Depth = 0.0;
+    ///_path_'s size in texels at _scale_ texels per osu pixel
+    fn scaledSize(path: *const Path, scale: f32) [2]i32 {
+        return .{
+            @max(1, @as(i32, @intFromFloat(@ceil(@as(f32, @floatFromInt(@max(path.Width, 1))) * scale)))),
+            @max(1, @as(i32, @intFromFloat(@ceil(@as(f32, @floatFromInt(@max(path.Height, 1))) * scale)))),
+        };
+    }
 
-                top_side[3].X = end[0] + offset[0];
-                top_side[3].Y = end[1] + offset[1];
-                top_side[3].Depth = -1.0;
+    ///A _size_ region in _atlas_, smaller if it doesn't fit on a page (it's stretched back when drawn). Null if the
+    ///atlas is out of room even after evicting the bodies of sliders that are gone.
+    fn allocateBody(atlas: *SliderAtlas, size: [2]i32) ?SliderAtlas.Region {
+        const max_size: f32 = @floatFromInt(atlas.GetMaxRegionSize());
+        const body_width: f32 = @floatFromInt(size[0]);
+        const body_height: f32 = @floatFromInt(size[1]);
+        const fit = @min(1.0, max_size / body_width, max_size / body_height);
 
-                const bottom_size = _SliderBatcher.?.GetQuad();
+        const width: i32 = @max(1, @as(i32, @intFromFloat(body_width * fit)));
+        const height: i32 = @max(1, @as(i32, @intFromFloat(body_height * fit)));
 
-                bottom_size[0].X = start[0] - offset[0];
-                bottom_size[0].Y = start[1] - offset[1];
-                bottom_size[0].Depth = -1.0;
+        if (atlas.Allocate(width, height)) |region|
+            return region;
 
-                bottom_size[1].X = start[0];
-                bottom_size[1].Y = start[1];
-                bottom_size[1].Depth = 0.0;
+        //Bodies kept around for copy pasted sliders are the first to go
+        if (_CurveCache.?.EvictUnusedBodies(atlas) > 0) {
+            if (atlas.Allocate(width, height)) |region|
+                return region;
+        }
 
-                bottom_size[2].X = end[0];
-                bottom_size[2].Y = end[1];
-                bottom_size[2].Depth = 0.0;
+        atlas.AddPage() catch |err| {
+            std.debug.print("Slider atlas is out of room for a {d}x{d} body: {}\n", .{ width, height, err });
+            return null;
+        };
 
-                bottom_size[3].X = end[0] - offset[0];
-                bottom_size[3].Y = end[1] - offset[1];
-                bottom_size[3].Depth = -1.0;
-            }
+        return atlas.Allocate(width, height);
+    }
 
-            pub inline fn drawCornerJointDynamic(center: zm.Vec2f, prev_perpendicular: zm.Vec2f, curr_perpendicular: zm.Vec2f, half_thickness: zm.Vec2f) void {
-                const cross = prev_perpendicular[0] * curr_perpendicular[1] - prev_perpendicular[1] * curr_perpendicular[0];
+    fn OffScreenSliderRender(self: *DrawableHitSlider, region: SliderAtlas.Region) void {
+        if (_SliderShader == null) {
+            _SliderShader = Shader.Init(_SliderVertSrc, _SliderFragSrc) catch unreachable;
+        }
 
-                const is_left_turn = if (cross > 0.0) true else false;
+        _SliderAtlas.?.BeginRender(region);
 
-                var start_offset = if (is_left_turn) prev_perpendicular else -prev_perpendicular;
-                start_offset *= half_thickness;
-                var end_offset = if (is_left_turn) curr_perpendicular else -curr_perpendicular;
-                end_offset *= half_thickness;
+        c.glEnable(c.GL_DEPTH_TEST);
 
-                const start_angle = std.math.atan2(start_offset[1], start_offset[0]);
-                const end_angle = std.math.atan2(end_offset[1], end_offset[0]);
+        self.Mesh.Begin();
 
-                var angle_diff = end_angle - start_angle;
+        //In osu pixels, the region may be smaller than the path
+        const projection = zm.Mat4f.orthographic(0.0, @floatFromInt(self.BodyPath.Width), 0.0, @floatFromInt(self.BodyPath.Height), -1.0, 1.0);
 
-                if (angle_diff > std.math.pi) {
-                    angle_diff -= 2.0 * std.math.pi;
-                } else if (angle_diff < -std.math.pi) {
-                    angle_diff += 2.0 * std.math.pi;
-                }
+        _SliderShader.?.Use();
+        _SliderShader.?.SetMat4f("u_Projection", &projection);
 
-                const abs_angle_diff = @abs(angle_diff);
+        self.Mesh.DrawAll();
 
-                const MIN_RESOLUTION: comptime_float = 3.0;
-                const MAX_RESOLUTION: comptime_float = 32.0;
-                const RESOLUTION_SCALE: comptime_float = 8.0;
+        //i should be zigging and using defer
+        self.Mesh.End();
+        c.glDisable(c.GL_DEPTH_TEST);
+        _SliderAtlas.?.EndRender();
+    }
 
-                const resolution = @max(MIN_RESOLUTION, @min(MAX_RESOLUTION, abs_angle_diff * RESOLUTION_SCALE));
+    ///The _snake_ part of the body into _region_ of the snake atlas, the same geometry as directSliderRender's and the
+    ///same depth as OffScreenSliderRender's. Nothing batched in Graphics has to be flushed for it.
+    fn snakeRender(self: *DrawableHitSlider, region: SliderAtlas.Region, snake: SnakeRange) void {
+        if (_SliderSnakeShader == null) {
+            _SliderSnakeShader = Shader.Init(_SliderDirectVertSrc, _SliderSnakeFragSrc) catch unreachable;
+        }
 
-                const resolutionInt: u16 = @intFromFloat(resolution);
+        _SnakeAtlas.?.BeginRender(region);
 
-                var triangle_fan = _SliderBatcher.?.GetTriangleFan(resolutionInt + 2) catch unreachable;
-                triangle_fan[0].X = center[0];
-                triangle_fan[0].Y = center[1];
-                triangle_fan[0].Depth = 0.0;
+        c.glEnable(c.GL_DEPTH_TEST);
 
-                const clockwise: bool = angle_diff < 0.0;
+        self.Mesh.Begin();
 
-                for (0..resolutionInt + 1) |i| {
-                    const t: f32 = @as(f32, @floatFromInt(i)) / @as(f32, @floatFromInt(resolutionInt));
-                    const angle = if (clockwise) start_angle - t * abs_angle_diff else start_angle + t * angle_diff;
+        const size = zm.Vec2f{ @floatFromInt(@max(self.BodyPath.Width, 1)), @floatFromInt(@max(self.BodyPath.Height, 1)) };
+        const projection = zm.Mat4f.orthographic(0.0, size[0], 0.0, size[1], -1.0, 1.0);
 
-                    const offset = zm.Vec2f{ @cos(angle), @sin(angle) } * half_thickness;
+        _SliderSnakeShader.?.Use();
+        _SliderSnakeShader.?.SetMat4f("u_Projection", &projection);
+        //All of the depth range, 0.5 on the path and 1.0 at the edge like the depth body
+        _SliderSnakeShader.?.SetVec2f("u_DepthRange", .{ 0.0, 1.0 });
+        _SliderSnakeShader.?.SetVec2f("u_Size", size);
 
-                    triangle_fan[i + 1].X = center[0] + offset[0];
-                    triangle_fan[i + 1].Y = center[1] + offset[1];
-                    triangle_fan[i + 1].Depth = -1.0;
-                }
-            }
-        };
+        self.drawSnake(&_SliderSnakeShader.?, snake);
+
+        self.Mesh.End();
+        c.glDisable(c.GL_DEPTH_TEST);
+        _SnakeAtlas.?.EndRender();
+    }
 
-        const default_viewport = Viewport.GetSize();
+    ///Draws the _snake_ part of the body straight into the bound framebuffer. A depth only pass leaves the distance to
+    ///the path in the depth buffer, then the colour pass only shades the fragments that won it, so overlapping parts of
+    ///the body blend once.
+    fn directSliderRender(self: *DrawableHitSlider, g: *Graphics, alpha: f32, snake: SnakeRange) void {
+        if (_SliderDirectShader == null) {
+            _SliderDirectShader = Shader.Init(_SliderDirectVertSrc, _SliderDirectFragSrc) catch unreachable;
+        }
+
+        if (_SliderDepthShader == null) {
+            _SliderDepthShader = Shader.Init(_SliderDirectVertSrc, _SliderFragSrc) catch unreachable;
+        }
+
+        //Everything batched so far goes under the body
+        g.EndDraw();
+
+        if (_DirectLayer == DIRECT_DEPTH_LAYERS) {
+            c.glClear(c.GL_DEPTH_BUFFER_BIT);
+            _DirectLayer = 0;
+        }
 
-        c.glBindFramebuffer(c.GL_FRAMEBUFFER, self.FBO);
+        const layer_size = 2.0 / @as(f32, @floatFromInt(DIRECT_DEPTH_LAYERS));
+        const depth_range = zm.Vec2f{ 1.0 - @as(f32, @floatFromInt(_DirectLayer + 1)) * layer_size, layer_size * 0.99 };
+        _DirectLayer += 1;
 
-        Viewport.SetViewportSize(self.SliderTexture.width, self.SliderTexture.height);
+        const projection = PlayableBeatmap.OsuProjection(self.BodyPath.Position);
+        const size = zm.Vec2f{ @floatFromInt(@max(self.BodyPath.Width, 1)), @floatFromInt(@max(self.BodyPath.Height, 1)) };
 
+        self.Mesh.Begin();
         c.glEnable(c.GL_DEPTH_TEST);
 
-        c.glClear(c.GL_DEPTH_BUFFER_BIT);
+        _SliderDepthShader.?.Use();
+        _SliderDepthShader.?.SetMat4f("u_Projection", &projection);
+        _SliderDepthShader.?.SetVec2f("u_DepthRange", depth_range);
 
-        //const thickness = zm.Vec2f{ self.Path.PointRadius, self.Path.PointRadius };
-        const points = self.Path.Points;
-        const half_thickness: zm.Vec2f = .{ self.Path.PointRadius, self.Path.PointRadius };
-
-        var prev_perpendicular: zm.Vec2f = .{ 0.0, 0.0 };
-        //Profiler.Start("Slider_Geometry");
-        //start cap
-        util.placeCircle(points[0] - self.Path.Position, half_thickness[0]);
-        //end cap
-        util.placeCircle(points[points.len - 1] - self.Path.Position, half_thickness[0]);
-        for (0..points.len - 1) |i| {
-            const current = points[i] - self.Path.Position;
-            var next = points[i + 1] - self.Path.Position;
-
-            if (@reduce(.And, current == next)) {
-                //nudge hax
-                next[0] += 0.1;
-                next[1] += 0.1;
+        c.glColorMask(c.GL_FALSE, c.GL_FALSE, c.GL_FALSE, c.GL_FALSE);
+        c.glDepthFunc(c.GL_LESS);
+        self.drawSnake(&_SliderDepthShader.?, snake);
+
+        _SliderDirectShader.?.Use();
+        _SliderDirectShader.?.SetMat4f("u_Projection", &projection);
+        _SliderDirectShader.?.SetVec2f("u_DepthRange", depth_range);
+        _SliderDirectShader.?.SetVec2f("u_Size", size);
+        _SliderDirectShader.?.SetFloat("u_Alpha", alpha);
+        g.SetSliderBodyUniforms(&_SliderDirectShader.?);
+
+        c.glColorMask(c.GL_TRUE, c.GL_TRUE, c.GL_TRUE, c.GL_TRUE);
+        c.glDepthMask(c.GL_FALSE);
+        c.glDepthFunc(c.GL_EQUAL);
+        self.drawSnake(&_SliderDirectShader.?, snake);
+
+        c.glDepthFunc(c.GL_LESS);
+        c.glDepthMask(c.GL_TRUE);
+        c.glDisable(c.GL_DEPTH_TEST);
+
+        self.Mesh.End();
+    }
+
+    ///The segments under _snake_ with the caps moved to its ends, all from the static mesh
+    fn drawSnake(self: *DrawableHitSlider, shader: *Shader, snake: SnakeRange) void {
+        const points = self.BodyPath.Points;
+
+        shader.SetVec2f("u_Range", .{ snake.Start, snake.End });
+
+        shader.SetVec2f("u_Offset", self.SnakeStartCursor.PositionAt(&self.BodyPath, snake.Start) - points[0]);
+        self.Mesh.DrawStartCap();
+
+        shader.SetVec2f("u_Offset", self.SnakeEndCursor.PositionAt(&self.BodyPath, snake.End) - points[points.len - 1]);
+        self.Mesh.DrawEndCap();
+
+        shader.SetVec2f("u_Offset", .{ 0.0, 0.0 });
+        if (snake.Start < snake.End) {
+            self.Mesh.DrawSegments(self.SnakeStartCursor.SegmentAt(&self.BodyPath, snake.Start), self.SnakeEndCursor.SegmentAt(&self.BodyPath, snake.End));
+        }
+    }
+
+    ///How much of the body shows _time_ ms after the slider's start: it grows from the head while fading in and shrinks
+    ///behind the ball on the last slide
+    fn calculateSnake(self: *DrawableHitSlider, time: f32, fade_in_progress: f32) SnakeRange {
+        const length = self.BodyPath.Length;
+
+        var snake = SnakeRange{ .Start = 0.0, .End = length * fade_in_progress };
+
+        const slider = &self.HitObject.HitSlider.?;
+        const slider_end: f32 = @floatFromInt(slider.EndTime - self.HitObject.StartTime);
+        const slide_duration = slider_end / @as(f32, @floatFromInt(slider.Slides));
+        const last_slide_start = slider_end - slide_duration;
+
+        if (time > last_slide_start) {
+            const progress = std.math.clamp(MathUtils.Map(time, last_slide_start, slider_end, 0.0, 1.0), 0.0, 1.0);
+
+            //An odd slide count ends at the tail
+            if (@mod(slider.Slides, 2) == 1) {
+                snake.Start = length * progress;
+            } else {
+                snake.End = @min(snake.End, length * (1.0 - progress));
             }
+        }
+
+        return snake;
+    }
 
-            const direction = zm.vec.normalize(next - current);
-            const perpendicular: zm.Vec2f = .{ direction[1], -direction[0] };
+    ///Ticks the ball hasn't passed yet on _span_ (all of them before the slider starts, _ball_distance_ null) that the
+    ///body already reached
+    fn drawTicks(self: *DrawableHitSlider, g: *Graphics, sheet: *const SliderSheet, span: usize, ball_distance: ?f32, snake: SnakeRange, alpha: f32) void {
+        const size = self.Beatmap.GetWorldCircleSize() * zm.Vec2f{ TICK_SCALE, TICK_SCALE };
+        const reversed = span % 2 == 1;
 
-            //draw line segment
-            util.drawLineSegment(current, next, perpendicular, half_thickness);
-            if (i > 0) {
-                //draw corner
-                util.drawCornerJointDynamic(current, prev_perpendicular, perpendicular, half_thickness);
+        for (self.Ticks) |tick| {
+            if (tick.Distance < snake.Start or tick.Distance > snake.End)
+                continue;
+
+            if (ball_distance) |ball| {
+                const passed = if (reversed) tick.Distance >= ball else tick.Distance <= ball;
+                if (passed)
+                    continue;
             }
 
-            prev_perpendicular = perpendicular;
+            const draw_pos = PlayableBeatmap.MapToPlayfield2(tick.Position[0], tick.Position[1]);
+            g.DrawRectangleCentered(draw_pos, size, .{ 1.0, 1.0, 1.0, alpha }, &sheet.Texture, sheet.Tick);
         }
-        //Profiler.End("Slider_Geometry");
-        const upload_data = _SliderBatcher.?.GetUploadData();
+    }
 
-        _SliderIdxBuffer.?.OrphanUpload(upload_data.IndexSlice, c.GL_STATIC_DRAW);
-        _SliderVtxBuffer.?.OrphanUpload(upload_data.VertexSlice, c.GL_STATIC_DRAW);
-        SliderVertex.EnableVertexAttribs();
+    ///The arrow at the end of _span_ if the ball turns around there, pointing back along the path
+    fn drawReverseArrow(self: *DrawableHitSlider, g: *Graphics, sheet: *const SliderSheet, span: usize, snake: SnakeRange, alpha: f32) void {
+        const slides: usize = @intCast(@max(self.HitObject.HitSlider.?.Slides, 1));
+        if (span + 1 >= slides)
+            return;
 
-        const projection = zm.Mat4f.orthographic(0.0, @floatFromInt(self.SliderTexture.width), 0.0, @floatFromInt(self.SliderTexture.height), -1.0, 1.0);
+        const points = self.Path.Points;
+        const at_tail = span % 2 == 0;
 
-        _SliderShader.?.Use();
-        _SliderShader.?.SetMat4f("u_Projection", &projection);
+        //Not before the body got there
+        if ((at_tail and snake.End < self.BodyPath.Length) or (!at_tail and snake.Start > 0.0))
+            return;
 
-        c.glDrawElements(c.GL_TRIANGLES, @intCast(upload_data.IndexSlice.len), c.GL_UNSIGNED_SHORT, @ptrFromInt(0));
+        const position = if (at_tail) points[points.len - 1] else points[0];
+        const direction = if (at_tail) -self.Path.CalculateTangentAt(self.Path.Length) else self.Path.CalculateTangentAt(0.0);
 
-        //i should be zigging and using defer
-        _SliderBatcher.?.ResetWritePosition();
-        SliderVertex.DisableVertexAttribs();
-        c.glDisable(c.GL_DEPTH_TEST);
-        c.glBindFramebuffer(c.GL_FRAMEBUFFER, 0);
-        Viewport.SetViewportSize(default_viewport[0], default_viewport[1]);
+        //The texture points along +x, its y axis goes to the right of that
+        const half_size = self.Beatmap.GetWorldCircleSize() * zm.Vec2f{ 0.5, 0.5 };
+        const along = direction * half_size;
+        const across = zm.Vec2f{ -direction[1], direction[0] } * half_size;
+        const center = PlayableBeatmap.MapToPlayfield2(position[0], position[1]);
+
+        g.DrawQuad(center - along - across, center + along - across, center + along + across, center - along + across, .{ 1.0, 1.0, 1.0, alpha }, &sheet.Texture, sheet.ReverseArrow);
+    }
+
+    ///Around the ball at _ball_pos_ (screen) while the slider runs, fading out where the ball stopped after it ends.
+    ///_time_ is in ms since the slider's start.
+    fn drawFollowCircle(self: *DrawableHitSlider, g: *Graphics, sheet: *const SliderSheet, time: f32, ball_pos: zm.Vec2f) void {
+        const slider_end: f32 = @floatFromInt(self.HitObject.HitSlider.?.EndTime - self.HitObject.StartTime);
+
+        if (time < 0.0 or time > slider_end + FOLLOW_CIRCLE_FADE_MS)
+            return;
+
+        const grow = std.math.clamp(time / FOLLOW_CIRCLE_GROW_MS, 0.0, 1.0);
+        const scale = MathUtils.Map(grow, 0.0, 1.0, 1.0, FOLLOW_CIRCLE_SCALE);
+        const alpha = 1.0 - std.math.clamp((time - slider_end) / FOLLOW_CIRCLE_FADE_MS, 0.0, 1.0);
+
+        const size = self.Beatmap.GetWorldCircleSize() * zm.Vec2f{ scale, scale };
+        g.DrawRectangleCentered(ball_pos, size, .{ 1.0, 1.0, 1.0, alpha }, &sheet.Texture, sheet.FollowCircle);
     }
 
     fn OnAdd(selfP: *anyopaque, _: *DrawableManager) void {
@@ -511,24 +785,25 @@ pub const DrawableHitSlider = struct {
         _ = delta;
     }
 
-    fn calculateAlpha(self: *DrawableHitSlider, song_pos: f32) f32 {
+    ///_time_ is in ms since the slider's start
+    fn calculateAlpha(self: *DrawableHitSlider, time: f32) f32 {
         const FADEOUT: f32 = 241.0;
 
-        const fade_in_start: f32 = @floatFromInt(self.HitObject.StartTime - self.Beatmap.Preempt);
+        const fade_in_start: f32 = @floatFromInt(-self.Beatmap.Preempt);
         const fade_in_duration: f32 = @floatFromInt(self.Beatmap.FadeIn);
         const fade_in_end: f32 = fade_in_start + fade_in_duration;
 
-        const slider_end: f32 = @floatFromInt(self.HitObject.HitSlider.?.EndTime);
+        const slider_end: f32 = @floatFromInt(self.HitObject.HitSlider.?.EndTime - self.HitObject.StartTime);
 
         const fade_out_start = slider_end;
         const fade_out_end = slider_end + FADEOUT;
 
         var alpha: f32 = 1.0;
 
-        if (song_pos <= fade_in_end) {
-            alpha = MathUtils.Map(song_pos, fade_in_start, fade_in_end, 0.0, 1.0);
-        } else if (song_pos >= fade_out_start) {
-            alpha = MathUtils.Map(song_pos, fade_out_start, fade_out_end, 1.0, 0.0);
+        if (time <= fade_in_end) {
+            alpha = MathUtils.Map(time, fade_in_start, fade_in_end, 0.0, 1.0);
+        } else if (time >= fade_out_start) {
+            alpha = MathUtils.Map(time, fade_out_start, fade_out_end, 1.0, 0.0);
         }
 
         return alpha;
@@ -537,38 +812,38 @@ pub const DrawableHitSlider = struct {
     pub fn Draw(selfP: *anyopaque, g: *Graphics) void {
         const self: *@This() = @ptrCast(@alignCast(selfP));
 
-        const FADEOUT: f32 = 241.0;
+        //Its mesh is gone, it only hangs around until the manager's next update
+        if (self.IsDead)
+            return;
 
-        //todo add snaking sometime, it's pretty easy
-        //self.OffScreenSliderRender();
+        const FADEOUT: f32 = 241.0;
 
-        const song_pos: f32 = @floatCast(self.Beatmap.Song.GetPlaybackPositionInSeconds() * 1000.0);
+        const song_pos = PlayScene.GetClock().GetTimeMs();
+        //Everything below is relative to the start time, only that difference goes down to f32
+        const time: f32 = @floatCast(song_pos - @as(f64, @floatFromInt(self.HitObject.StartTime)));
 
-        const fade_in_start: f32 = @floatFromInt(self.HitObject.StartTime - self.Beatmap.Preempt);
+        const fade_in_start: f32 = @floatFromInt(-self.Beatmap.Preempt);
         const fade_in_duration: f32 = @floatFromInt(self.Beatmap.FadeIn);
         const fade_in_end: f32 = fade_in_start + fade_in_duration;
 
-        var fade_in_progress = MathUtils.Map(song_pos, fade_in_start, fade_in_end, 0.0, 1.0);
+        var fade_in_progress = MathUtils.Map(time, fade_in_start, fade_in_end, 0.0, 1.0);
         fade_in_progress = std.math.clamp(fade_in_progress, 0.0, 1.0);
 
-        const slider_start: f32 = @floatFromInt(self.HitObject.StartTime);
-        const slider_end: f32 = @floatFromInt(self.HitObject.HitSlider.?.EndTime);
+        const slider_start: f32 = 0.0;
+        const slider_end: f32 = @floatFromInt(self.HitObject.HitSlider.?.EndTime - self.HitObject.StartTime);
 
         const fade_out_start = slider_end;
         const fade_out_end = slider_end + FADEOUT;
 
-        var fade_out_progress = MathUtils.Map(song_pos, fade_out_start, fade_out_end, 0.0, 1.0);
+        var fade_out_progress = MathUtils.Map(time, fade_out_start, fade_out_end, 0.0, 1.0);
         fade_out_progress = std.math.clamp(fade_out_progress, 0.0, 1.0);
-        const sliderbody_alpha = calculateAlpha(self, song_pos);
-
-        if (song_pos >= fade_out_end)
-            self.IsDead = true;
+        const sliderbody_alpha = calculateAlpha(self, time);
 
         const slide_count: f32 = @floatFromInt(self.HitObject.HitSlider.?.Slides);
         const slide_duration = (slider_end - slider_start) / slide_count;
-        const sliderball_progress = MathUtils.Oscillate01(MathUtils.Map(song_pos, slider_start, slider_start + slide_duration, 0.0, 1.0));
+        const sliderball_progress = MathUtils.Oscillate01(MathUtils.Map(time, slider_start, slider_start + slide_duration, 0.0, 1.0));
 
-        const slider_texture_draw_pos = PlayableBeatmap.MapSliderToPlayfield(self.Path.Bounds);
+        const slider_texture_draw_pos = PlayableBeatmap.MapSliderToPlayfield(self.BodyPath.Bounds);
 
         const stacking_count = zm.Vec2f{ @floatFromInt(self.HitObject.StackCount), @floatFromInt(self.HitObject.StackCount) };
 
@@ -577,9 +852,53 @@ pub const DrawableHitSlider = struct {
         //slider_texture_draw_pos[0] += stacking_vector[0];
         //slider_texture_draw_pos[1] += stacking_vector[0];
 
-        g.DrawRect(slider_texture_draw_pos, .{ 10.0, 1.0, 1.0, sliderbody_alpha }, &self.SliderTexture, .{ 0.0, 0.0, 1.0, 1.0 });
+        const snake = self.calculateSnake(time, fade_in_progress);
+        const whole_body = snake.Start <= 0.0 and snake.End >= self.BodyPath.Length;
+
+        const render_mode = activeRenderMode();
+
+        switch (render_mode) {
+            .Offscreen, .DistanceField => {
+                //Spawned while in another mode
+                const maybe_body = if (render_mode == .Offscreen) self.ensureBody() else self.ensureDistanceBody();
+
+                //The atlas body is shared and always whole, a snaking one gets its own region. Only bodies there was no
+                //room for are drawn directly.
+                if (whole_body) {
+                    self.freeSnakeBody();
+
+                    if (maybe_body) |body| {
+                        const atlas = if (render_mode == .Offscreen) &_SliderAtlas.? else &_DistanceAtlas.?;
+                        g.DrawSliderBody(slider_texture_draw_pos, sliderbody_alpha, atlas.GetPageTexture(body.Page), body.GetTextureRect(atlas.GetPageSize()));
+                    } else {
+                        self.directSliderRender(g, sliderbody_alpha, snake);
+                    }
+                } else if (self.ensureSnakeBody(snake)) |body| {
+                    g.DrawSliderBody(slider_texture_draw_pos, sliderbody_alpha, _SnakeAtlas.?.GetPageTexture(body.Page), body.GetTextureRect(_SnakeAtlas.?.GetPageSize()));
+                } else {
+                    self.directSliderRender(g, sliderbody_alpha, snake);
+                }
+            },
+            .Direct => self.directSliderRender(g, sliderbody_alpha, snake),
+        }
+
+        //Every decoration comes out of the one sheet texture, they batch with the body and the circle without a flush
+        const sheet = &PlayScene.GetSkin().Slider;
+
+        //Span the ball is on, the last one once it has ended
+        const slides: usize = @intCast(@max(self.HitObject.HitSlider.?.Slides, 1));
+        const span_position = @floor((time - slider_start) / slide_duration);
+        const span: usize = @intFromFloat(std.math.clamp(span_position, 0.0, @as(f32, @floatFromInt(slides - 1))));
 
-        DrawableHitCircle.DrawHitCircle(g, self.Beatmap, &self.HitObject, stacking_offset, song_pos);
+        if (time < slider_start) {
+            self.drawTicks(g, sheet, span, null, snake, sliderbody_alpha);
+        } else if (time <= slider_end) {
+            self.drawTicks(g, sheet, span, sliderball_progress * self.Path.Length, snake, sliderbody_alpha);
+        }
+
+        self.drawReverseArrow(g, sheet, span, snake, sliderbody_alpha);
+
+        HitCircleRenderer.DrawHitCircle(g, self.Beatmap, &self.HitObject, stacking_offset, song_pos);
 
         //for (self.Path.Points) |curve_point| {
         //    const draw_pos = PlayableBeatmap.MapToPlayfield2(curve_point[0], curve_point[1]);
@@ -587,13 +906,24 @@ pub const DrawableHitSlider = struct {
         //    g.DrawRectangleCentered(draw_pos, .{ 8.0, 8.0 }, .{ 1.0, 0.0, 0.5, 1.0 }, PlayScene.GetSkin().DotTexture, .{ 0.0, 0.0, 1.0, 1.0 });
         //}
 
-        if (song_pos >= slider_start and song_pos <= slider_end) {
-            var sliderball_pos = self.Path.CalculatePositionAt(self.Path.Length * sliderball_progress);
+        if (time >= slider_start and time <= slider_end) {
+            var sliderball_pos = self.SliderBallCursor.PositionAtProgress(&self.Path, sliderball_progress);
             sliderball_pos = PlayableBeatmap.MapToPlayfield2(sliderball_pos[0], sliderball_pos[1]);
 
             const sliderball_size = self.Beatmap.GetWorldCircleSize();
 
-            g.DrawRectangleCentered(sliderball_pos, sliderball_size, .{ 1.0, 1.0, 1.0, 1.0 }, &PlayScene.GetSkin().SliderBall.BackingTexture, .{ 0.0, 0.0, 1.0, 1.0 });
+            g.DrawRectangleCentered(sliderball_pos, sliderball_size, .{ 1.0, 1.0, 1.0, 1.0 }, &sheet.Texture, sheet.Ball);
+            self.drawFollowCircle(g, sheet, time, sliderball_pos);
+        } else if (time > slider_end) {
+            //Where the ball stopped, the tail after an odd number of slides
+            const points = self.Path.Points;
+            const end_point = if (slides % 2 == 1) points[points.len - 1] else points[0];
+            self.drawFollowCircle(g, sheet, time, PlayableBeatmap.MapToPlayfield2(end_point[0], end_point[1]));
+        }
+
+        if (time >= fade_out_end) {
+            self.IsDead = true;
+            self.release();
         }
     }
 };
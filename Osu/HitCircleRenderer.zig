@@ -0,0 +1,221 @@
+//Hit circles without a drawable per circle
+//Every alive circle used to be its own DrawableHitCircle, drawn through a function pointer that worked out its fade,
+//approach and explode scale on its own with Map and clamps. Here the alive circles are kept in one struct of arrays in
+//spawn order. Animate works out all of them LANES at a time once per frame, and the draw writes their quads straight
+//into the batcher with the slots of the three skin textures fetched once per run of circles.
+//Sliders still draw their head circle themselves, through DrawHitCircle which runs the same math one lane wide.
+
+const std = @import("std");
+const zm = @import("zm");
+
+const Graphics = @import("../Easy2D/Graphics.zig").Graphics;
+const PlayableBeatmap = @import("PlayableBeatmap.zig").PlayableBeatmap;
+const HitObject = @import("OsuParser.zig").HitObject;
+const PlayScene = @import("../Scenes/PlayScene.zig").PlayScene;
+
+const LANES = 8;
+const Lanes = @Vector(LANES, f32);
+const TimeLanes = @Vector(LANES, f64);
+
+const TEXTURE_RECT: zm.Vec4f = .{ 0.0, 0.0, 1.0, 1.0 };
+const APPROACH_START_SCALE: f32 = 4.0;
+const EXPLODE_SCALE: f32 = 1.5;
+const FADE_OUT_MS: f32 = 241.0;
+
+fn Animation(comptime N: usize) type {
+    return struct {
+        Alpha: @Vector(N, f32),
+        ApproachScale: @Vector(N, f32),
+        ExplodeScale: @Vector(N, f32),
+    };
+}
+
+//The approach circle shrinks from 4x over the preempt, the circle fades in over _fade_in_ and explodes to 1.5x while
+//fading out for FADE_OUT_MS after its start time. An explode scale at EXPLODE_SCALE means the circle is gone.
+//Times stay f64 and only the milliseconds since each start time go down to f32, a song time in f32 only has 1/32 ms
+//steps five minutes in.
+fn animate(comptime N: usize, start_times: @Vector(N, f64), song_pos: f64, preempt: f32, fade_in: f32) Animation(N) {
+    const V = @Vector(N, f32);
+    const zero: V = @splat(0.0);
+    const one: V = @splat(1.0);
+
+    const since_start: V = @floatCast(@as(@Vector(N, f64), @splat(song_pos)) - start_times);
+    const since_fade_in = since_start + @as(V, @splat(preempt));
+
+    const approach = @as(V, @splat(APPROACH_START_SCALE)) - since_fade_in * @as(V, @splat((APPROACH_START_SCALE - 1.0) / preempt));
+    const explode_progress = @min(@max(since_start * @as(V, @splat(1.0 / FADE_OUT_MS)), zero), one);
+    const fade_in_progress = since_fade_in * @as(V, @splat(1.0 / fade_in));
+
+    return .{
+        .Alpha = @min(@max(fade_in_progress * (one - explode_progress), zero), one),
+        .ApproachScale = @min(@max(approach, one), @as(V, @splat(APPROACH_START_SCALE))),
+        .ExplodeScale = one + explode_progress * @as(V, @splat(EXPLODE_SCALE - 1.0)),
+    };
+}
+
+//_slots_ from GetTextureSlots: hit circle, overlay, approach circle
+fn drawCircle(g: *Graphics, slots: [3]f32, position: zm.Vec2f, size: f32, alpha: f32, approach_scale: f32, explode_scale: f32, song_pos: f64) void {
+    const color = zm.Vec4f{ @floatCast(@sin(song_pos * 0.002)), 0.5, 1.0, alpha };
+    const color_white = zm.Vec4f{ 1.0, 1.0, 1.0, alpha };
+
+    const explode_size: zm.Vec2f = @splat(size * explode_scale);
+    const explode_pos = position - explode_size * zm.Vec2f{ 0.5, 0.5 };
+
+    g.DrawRectangleInSlot(explode_pos, explode_size, color, slots[0], TEXTURE_RECT);
+    g.DrawRectangleInSlot(explode_pos, explode_size, color_white, slots[1], TEXTURE_RECT);
+
+    if (approach_scale > 1.0) {
+        const approach_size: zm.Vec2f = @splat(size * approach_scale);
+        g.DrawRectangleInSlot(position - approach_size * zm.Vec2f{ 0.5, 0.5 }, approach_size, color, slots[2], TEXTURE_RECT);
+    }
+}
+
+fn getSkinSlots(g: *Graphics) [3]f32 {
+    const skin = PlayScene.GetSkin();
+    return g.GetTextureSlots(3, .{ &skin.HitCircle.BackingTexture, &skin.HitCircleOverlay.BackingTexture, &skin.ApproachCircle.BackingTexture });
+}
+
+pub const HitCircleRenderer = struct {
+    const Circle = struct {
+        StartTime: f64,
+        //Osu pixels
+        X: f32,
+        Y: f32,
+        StackCount: f32,
+        Layer: i32,
+
+        //Written by Animate
+        ScreenX: f32 = 0.0,
+        ScreenY: f32 = 0.0,
+        Alpha: f32 = 0.0,
+        ApproachScale: f32 = 0.0,
+        ExplodeScale: f32 = 0.0,
+    };
+
+    m_Allocator: std.mem.Allocator,
+    //Spawn order, so the earliest circle is at the front
+    m_Circles: std.MultiArrayList(Circle) = .{},
+    //Circles from the front not drawn yet this frame
+    m_Undrawn: usize = 0,
+    m_CircleSize: f32 = 0.0,
+    m_SongPos: f64 = 0.0,
+
+    pub fn Init(allocator: std.mem.Allocator) HitCircleRenderer {
+        return .{ .m_Allocator = allocator };
+    }
+
+    pub fn Deinit(self: *HitCircleRenderer) void {
+        self.m_Circles.deinit(self.m_Allocator);
+    }
+
+    ///_hit_object_ has to spawn after every circle added before it
+    pub fn Add(self: *HitCircleRenderer, hit_object: *const HitObject, layer: i32) void {
+        //Animate reads and writes whole vectors, the lanes past the end only need to be there. The capacity is kept a
+        //multiple of LANES, ensureTotalCapacity could grow it to anything.
+        const needed = std.mem.alignForward(usize, self.m_Circles.len + 1, LANES);
+        if (needed > self.m_Circles.capacity) {
+            self.m_Circles.setCapacity(self.m_Allocator, @max(needed, self.m_Circles.capacity * 2)) catch unreachable;
+        }
+
+        self.m_Circles.appendAssumeCapacity(.{
+            .StartTime = @floatFromInt(hit_object.StartTime),
+            .X = @floatFromInt(hit_object.X),
+            .Y = @floatFromInt(hit_object.Y),
+            .StackCount = @floatFromInt(hit_object.StackCount),
+            .Layer = layer,
+        });
+    }
+
+    ///Works out every circle's position, fade and scales at _song_pos_ and drops the ones that finished exploding
+    pub fn Animate(self: *HitCircleRenderer, beatmap: *const PlayableBeatmap, song_pos: f64) void {
+        var slice = self.m_Circles.slice();
+
+        //Whole vectors up to the capacity, Add keeps it a multiple of LANES
+        const capacity = self.m_Circles.capacity;
+        const start_times = slice.items(.StartTime).ptr[0..capacity];
+        const xs = slice.items(.X).ptr[0..capacity];
+        const ys = slice.items(.Y).ptr[0..capacity];
+        const stack_counts = slice.items(.StackCount).ptr[0..capacity];
+        const screen_xs = slice.items(.ScreenX).ptr[0..capacity];
+        const screen_ys = slice.items(.ScreenY).ptr[0..capacity];
+        const alphas = slice.items(.Alpha).ptr[0..capacity];
+        const approach_scales = slice.items(.ApproachScale).ptr[0..capacity];
+        const explode_scales = slice.items(.ExplodeScale).ptr[0..capacity];
+
+        const preempt: f32 = @floatFromInt(beatmap.Preempt);
+        const fade_in: f32 = @floatFromInt(beatmap.FadeIn);
+
+        //The playfield mapping is a scale and an offset, the stack vector goes on top in screen space
+        const origin = PlayableBeatmap.MapToPlayfield2(0.0, 0.0);
+        const scale = (PlayableBeatmap.MapToPlayfield2(512.0, 384.0) - origin) / zm.Vec2f{ 512.0, 384.0 };
+        const stack = beatmap.GetStackVector();
+
+        var i: usize = 0;
+        while (i < slice.len) : (i += LANES) {
+            const animation = animate(LANES, @as(TimeLanes, start_times[i..][0..LANES].*), song_pos, preempt, fade_in);
+            alphas[i..][0..LANES].* = animation.Alpha;
+            approach_scales[i..][0..LANES].* = animation.ApproachScale;
+            explode_scales[i..][0..LANES].* = animation.ExplodeScale;
+
+            const stack_counts_lanes: Lanes = stack_counts[i..][0..LANES].*;
+            screen_xs[i..][0..LANES].* = @as(Lanes, @splat(origin[0])) + @as(Lanes, xs[i..][0..LANES].*) * @as(Lanes, @splat(scale[0])) + stack_counts_lanes * @as(Lanes, @splat(stack[0]));
+            screen_ys[i..][0..LANES].* = @as(Lanes, @splat(origin[1])) + @as(Lanes, ys[i..][0..LANES].*) * @as(Lanes, @splat(scale[1])) + stack_counts_lanes * @as(Lanes, @splat(stack[1]));
+        }
+
+        //Keeping the order, usually it's just a few at the front
+        var alive: usize = 0;
+        for (0..slice.len) |read| {
+            if (explode_scales[read] >= EXPLODE_SCALE)
+                continue;
+
+            if (alive != read)
+                slice.set(alive, slice.get(read));
+
+            alive += 1;
+        }
+
+        self.m_Circles.shrinkRetainingCapacity(alive);
+
+        self.m_Undrawn = alive;
+        self.m_CircleSize = beatmap.GetWorldCircleSize()[0];
+        self.m_SongPos = song_pos;
+    }
+
+    ///Draws the circles below _layer_ that haven't been drawn since Animate, later ones first so earlier circles end up
+    ///on top. For DrawableManager.DrawInterleaved.
+    pub fn DrawBelowLayer(self: *HitCircleRenderer, g: *Graphics, layer: i32) void {
+        const slice = self.m_Circles.slice();
+        const layers = slice.items(.Layer);
+
+        if (self.m_Undrawn == 0 or layers[self.m_Undrawn - 1] >= layer)
+            return;
+
+        const slots = getSkinSlots(g);
+
+        const screen_xs = slice.items(.ScreenX);
+        const screen_ys = slice.items(.ScreenY);
+        const alphas = slice.items(.Alpha);
+        const approach_scales = slice.items(.ApproachScale);
+        const explode_scales = slice.items(.ExplodeScale);
+
+        while (self.m_Undrawn > 0 and layers[self.m_Undrawn - 1] < layer) {
+            self.m_Undrawn -= 1;
+            const i = self.m_Undrawn;
+
+            drawCircle(g, slots, .{ screen_xs[i], screen_ys[i] }, self.m_CircleSize, alphas[i], approach_scales[i], explode_scales[i], self.m_SongPos);
+        }
+    }
+
+    ///A single circle outside the renderer, a slider's head
+    pub fn DrawHitCircle(g: *Graphics, beatmap: *const PlayableBeatmap, hit_object: *const HitObject, stacking_offset: zm.Vec2f, song_pos: f64) void {
+        const start_time: @Vector(1, f64) = @splat(@floatFromInt(hit_object.StartTime));
+        const animation = animate(1, start_time, song_pos, @floatFromInt(beatmap.Preempt), @floatFromInt(beatmap.FadeIn));
+
+        if (animation.ExplodeScale[0] >= EXPLODE_SCALE)
+            return;
+
+        const draw_pos = PlayableBeatmap.MapToPlayfield(hit_object.X, hit_object.Y) + stacking_offset;
+
+        drawCircle(g, getSkinSlots(g), draw_pos, beatmap.GetWorldCircleSize()[0], animation.Alpha[0], animation.ApproachScale[0], animation.ExplodeScale[0], song_pos);
+    }
+};
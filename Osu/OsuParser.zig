@@ -144,6 +144,14 @@ pub const HitSlider = struct {
     EndTime: i32,
 };
 
+///Where a slider's ticks are, see Beatmap.GetSliderTicks
+pub const SliderTicks = struct {
+    ///Osu pixels along the path from one tick to the next, the first one is this far from the head
+    Spacing: f32,
+    ///Ticks on every span, a reversed span has them the other way round
+    Count: usize,
+};
+
 const Profiler = @import("../Profiler.zig").Profiler;
 
 pub const Beatmap = struct {
@@ -154,6 +162,9 @@ pub const Beatmap = struct {
     TimingPoints: std.ArrayList(TimingPoint),
     HitObjects: std.ArrayList(HitObject),
 
+    ///Lowercase hex md5 of the .osu file, this is what replays and scores reference the map by
+    MD5Hash: [32]u8,
+
     m_Allocator: std.mem.Allocator,
 
     pub fn FromString(allocator: std.mem.Allocator, string: []const u8) Beatmap {
@@ -219,12 +230,17 @@ pub const Beatmap = struct {
             }
         }
         Profiler.End("parse_beatmap");
+
+        var md5_digest: [std.crypto.hash.Md5.digest_length]u8 = undefined;
+        std.crypto.hash.Md5.hash(string, &md5_digest, .{});
+
         return Beatmap{
             .General = generalSection,
             .Metadata = metadataSection,
             .Difficulty = difficultySection,
             .TimingPoints = timingPoints,
             .HitObjects = hitObjects,
+            .MD5Hash = std.fmt.bytesToHex(md5_digest, .lower),
             .m_Allocator = allocator,
         };
     }
@@ -341,6 +357,28 @@ pub const Beatmap = struct {
         };
     }
 
+    ///Ticks of _hit_object_ (a slider), _path_length_ stands in for a missing pixel length
+    pub fn GetSliderTicks(self: *const Beatmap, hit_object: *const HitObject, path_length: f32) SliderTicks {
+        const slider = &hit_object.HitSlider.?;
+        const timing_point = GetTimingPointAt(&self.TimingPoints, hit_object.StartTime);
+
+        const pixel_length: f32 = if (slider.PixelLength > 0.0) slider.PixelLength else path_length;
+        const pixels_per_beat = self.Difficulty.SliderMultiplier * 100.0 * timing_point.BeatMultiplier;
+        const spacing: f32 = if (self.Difficulty.SliderTickRate > 0.0) pixels_per_beat / self.Difficulty.SliderTickRate else 0.0;
+        //Ticks closer than 10ms to the end of a span are skipped
+        const min_distance_from_end: f32 = pixels_per_beat / timing_point.BeatLength * 10.0;
+
+        var count: usize = 0;
+        if (spacing > 1.0 and pixel_length > 0.0) {
+            var distance = spacing;
+            while (distance < pixel_length - min_distance_from_end) : (distance += spacing) {
+                count += 1;
+            }
+        }
+
+        return .{ .Spacing = spacing, .Count = count };
+    }
+
     pub fn GetTimingPointAt(timingPoints: *const std.ArrayList(TimingPoint), offset: i32) TimingPoint {
         var samplingPointIndex: usize = 0;
 
@@ -10,17 +10,28 @@
 const std = @import("std");
 const Sound = @import("../Sound.zig").Sound;
 const Beatmap = @import("OsuParser.zig").Beatmap;
+const HitObject = @import("OsuParser.zig").HitObject;
 const zm = @import("zm");
 const MathUtils = @import("../MathUtils.zig").MathUtils;
+const SliderPath = @import("SliderPath.zig");
+const Path = SliderPath.Path;
+const FlattenDetail = SliderPath.FlattenDetail;
+const SliderLod = @import("SliderLod.zig").SliderLod;
 
 var _playfield = zm.Vec4f{ 0.0, 0.0, 0.0, 0.0 };
 var _osu_to_world_scale: f32 = 0.0;
+var _viewport_size = zm.Vec2f{ 0.0, 0.0 };
 pub const PlayableBeatmap = struct {
     Beatmap: Beatmap,
     Song: Sound,
     Preempt: i32 = 0,
     FadeIn: i32 = 0,
     CircleSizeOsuPixels: f32 = 0,
+    ///Flattened and trimmed path of every slider, indexed like Beatmap.HitObjects (null for circles and spinners)
+    SliderPaths: []?Path = &.{},
+    ///Same again at SliderBodyDetail for the drawn bodies, empty when the gameplay paths are already fine enough
+    SliderBodyPaths: []?Path = &.{},
+    SliderBodyDetail: FlattenDetail = .{},
     pub fn Load(allocator: std.mem.Allocator, folderPath_1: []const u8, osuMapName: []const u8) !PlayableBeatmap {
         //Load beatmap file
 
@@ -53,9 +64,92 @@ pub const PlayableBeatmap = struct {
 
         final_bm.ApplyMods();
 
+        //Gameplay follows osu!'s flattening whatever the display, the slider LOD only applies to the drawn body
+        try final_bm.PrecomputeSliderPaths(allocator, SliderLod.Current().Flatten);
+
         return final_bm;
     }
 
+    ///Flattens every slider on a thread pool with osu!'s detail, so spawning one never has to. Nothing depends on the
+    ///display, so the paths stay valid for as long as the beatmap. When osu!'s detail is coarser than _body_detail_
+    ///the bodies get flattened again at _body_detail_ in the same jobs. Does nothing the second time.
+    pub fn PrecomputeSliderPaths(self: *PlayableBeatmap, allocator: std.mem.Allocator, body_detail: FlattenDetail) !void {
+        if (self.SliderPaths.len != 0)
+            return;
+
+        const hit_objects = self.Beatmap.HitObjects.items;
+
+        const paths = try allocator.alloc(?Path, hit_objects.len);
+        errdefer allocator.free(paths);
+        @memset(paths, null);
+
+        const body_paths: []?Path = if ((FlattenDetail{}).Satisfies(body_detail)) &.{} else try allocator.alloc(?Path, hit_objects.len);
+        errdefer if (body_paths.len != 0) allocator.free(body_paths);
+        @memset(body_paths, null);
+
+        var pool: std.Thread.Pool = undefined;
+        try pool.init(.{ .allocator = allocator });
+        defer pool.deinit();
+
+        var wait_group: std.Thread.WaitGroup = .{};
+        for (hit_objects, 0..) |hit_object, i| {
+            if (!hit_object.IsHitSlider())
+                continue;
+
+            pool.spawnWg(&wait_group, buildSliderPathJob, .{ allocator, hit_objects, paths, body_paths, body_detail, i, self.CircleSizeOsuPixels });
+        }
+        pool.waitAndWork(&wait_group);
+
+        self.SliderPaths = paths;
+        self.SliderBodyPaths = body_paths;
+        self.SliderBodyDetail = body_detail;
+    }
+
+    ///Precomputed path of the slider at _object_index_, null if it isn't a slider or failed to build
+    pub fn GetSliderPath(self: *const PlayableBeatmap, object_index: usize) ?*const Path {
+        if (object_index >= self.SliderPaths.len)
+            return null;
+
+        if (self.SliderPaths[object_index]) |*path|
+            return path;
+
+        return null;
+    }
+
+    ///Precomputed body of the slider at _object_index_ flattened at _detail_, null if there's none at that detail
+    pub fn GetSliderBodyPath(self: *const PlayableBeatmap, object_index: usize, detail: FlattenDetail) ?*const Path {
+        if (object_index >= self.SliderBodyPaths.len or !std.meta.eql(detail, self.SliderBodyDetail))
+            return null;
+
+        if (self.SliderBodyPaths[object_index]) |*path|
+            return path;
+
+        return null;
+    }
+
+    fn buildSliderPathJob(allocator: std.mem.Allocator, hit_objects: []const HitObject, paths: []?Path, body_paths: []?Path, body_detail: FlattenDetail, index: usize, circle_size: f32) void {
+        paths[index] = buildSliderPath(allocator, hit_objects[index], .{}, circle_size) catch |err| {
+            std.debug.print("Couldn't build slider path {d}: {}\n", .{ index, err });
+            return;
+        };
+
+        if (body_paths.len == 0)
+            return;
+
+        //Not fatal, the slider flattens its body itself when it spawns
+        body_paths[index] = buildSliderPath(allocator, hit_objects[index], body_detail, circle_size) catch |err| {
+            std.debug.print("Couldn't build slider body {d}: {}\n", .{ index, err });
+            return;
+        };
+    }
+
+    fn buildSliderPath(allocator: std.mem.Allocator, hit_object: HitObject, detail: FlattenDetail, circle_size: f32) !Path {
+        const points = try SliderPath.BuildPointsDetailed(allocator, hit_object, detail);
+        errdefer allocator.free(points);
+
+        return Path.Init(allocator, points, circle_size);
+    }
+
     ///If _path_ starts with a "./" it's asumed to be a relative-to-exe path and will resolve the path and return a view into buffer, otherwise returns null if not detected or there was an error
     fn tryGetAbsolutePath(buffer: []u8, path: []const u8) ?[]const u8 {
         if (path.len < 2)
@@ -117,6 +211,13 @@ pub const PlayableBeatmap = struct {
         return .{ new_x, new_y };
     }
 
+    ///Inverse of MapToPlayfield2, screen position to osu pixels
+    pub fn MapFromPlayfield(position: zm.Vec2f) zm.Vec2f {
+        const osu_x = MathUtils.Map(position[0], _playfield[0], _playfield[0] + _playfield[2], 0.0, 512.0);
+        const osu_y = MathUtils.Map(position[1], _playfield[1], _playfield[1] + _playfield[3], 0.0, 384.0);
+        return .{ osu_x, osu_y };
+    }
+
     pub fn MapSliderToPlayfield(sliderBounds: zm.Vec4f) zm.Vec4f {
         var out = zm.Vec4f{ 0.0, 0.0, 0.0, 0.0 };
 
@@ -129,6 +230,20 @@ pub const PlayableBeatmap = struct {
         return out;
     }
 
+    ///Projection for geometry in osu pixels relative to _origin_ straight onto the screen, same orientation as
+    ///Graphics.ProjectionMatrix
+    pub fn OsuProjection(origin: zm.Vec2f) zm.Mat4f {
+        const scale_x = _playfield[2] / 512.0;
+        const scale_y = _playfield[3] / 384.0;
+
+        const left = -_playfield[0] / scale_x - origin[0];
+        const right = (_viewport_size[0] - _playfield[0]) / scale_x - origin[0];
+        const top = -_playfield[1] / scale_y - origin[1];
+        const bottom = (_viewport_size[1] - _playfield[1]) / scale_y - origin[1];
+
+        return zm.Mat4f.orthographic(left, right, bottom, top, -1.0, 1.0);
+    }
+
     pub fn UpdatePlayfield(viewport_width: f32, viewport_height: f32) void {
         const ASPECTRATIO = 4.0 / 3.0;
 
@@ -151,5 +266,6 @@ pub const PlayableBeatmap = struct {
         _playfield[1] += playfieldYOffset;
 
         _osu_to_world_scale = playfieldHeight / 384.0;
+        _viewport_size = .{ viewport_width, viewport_height };
     }
 };
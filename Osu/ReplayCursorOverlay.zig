@@ -0,0 +1,269 @@
+const std = @import("std");
+const zm = @import("zm");
+
+const Graphics = @import("../Easy2D/Graphics.zig").Graphics;
+const Texture = @import("../Easy2D/Texture.zig").Texture;
+
+const ReplayFrame = @import("ReplayParser.zig").ReplayFrame;
+const PlayableBeatmap = @import("PlayableBeatmap.zig").PlayableBeatmap;
+
+const LANES = 8;
+const Lane = @Vector(LANES, f32);
+
+//Lane columns, each one is m_LaneStride floats long inside m_Lanes
+const LANE_T0 = 0;
+const LANE_T1 = 1;
+const LANE_X0 = 2;
+const LANE_X1 = 3;
+const LANE_Y0 = 4;
+const LANE_Y1 = 5;
+const LANE_OUT_X = 6;
+const LANE_OUT_Y = 7;
+const LANE_COLUMNS = 8;
+
+///Draws the cursors (and trails) of many replays of the same map at once.
+///Frames of every replay are stored as flat time/x/y columns. Each update a scalar pass only moves every replay's frame
+///index and gathers the two surrounding frames into lane columns, then all cursors are interpolated 8 at a time with
+///vector math. Drawing is one loop of quads with two textures, so everything ends up in the same batch.
+pub const ReplayCursorOverlay = struct {
+    const TRAIL_LENGTH: usize = 16;
+    //Trail points are sampled in map time so the trail looks the same at any framerate/playback rate
+    const TRAIL_INTERVAL_MS: f32 = 8.0;
+    const SEEK_WALK_LIMIT_MS: f32 = 1000.0;
+    const TEXT_RECT: zm.Vec4f = .{ 0.0, 0.0, 1.0, 1.0 };
+
+    //Frame columns of every replay back to back, replay r owns [m_FrameStart[r], m_FrameStart[r + 1])
+    m_Times: std.ArrayList(f32),
+    m_X: std.ArrayList(f32),
+    m_Y: std.ArrayList(f32),
+    m_FrameStart: std.ArrayList(usize),
+
+    //Per replay
+    m_FrameIndex: std.ArrayList(usize),
+    m_Colors: std.ArrayList(zm.Vec4f),
+
+    m_Lanes: std.ArrayList(f32),
+    m_LaneStride: usize = 0,
+
+    //Trail ring in osu pixels, slot major: [slot * count + replay]
+    m_TrailX: std.ArrayList(f32),
+    m_TrailY: std.ArrayList(f32),
+    m_TrailHead: usize = 0,
+    m_TrailFilled: usize = 0,
+    m_LastTrailTime: f32 = 0.0,
+    m_LastTime: f32 = 0.0,
+
+    pub fn Init(allocator: std.mem.Allocator) ReplayCursorOverlay {
+        var frame_start = std.ArrayList(usize).init(allocator);
+        frame_start.append(0) catch unreachable;
+
+        return .{
+            .m_Times = std.ArrayList(f32).init(allocator),
+            .m_X = std.ArrayList(f32).init(allocator),
+            .m_Y = std.ArrayList(f32).init(allocator),
+            .m_FrameStart = frame_start,
+            .m_FrameIndex = std.ArrayList(usize).init(allocator),
+            .m_Colors = std.ArrayList(zm.Vec4f).init(allocator),
+            .m_Lanes = std.ArrayList(f32).init(allocator),
+            .m_TrailX = std.ArrayList(f32).init(allocator),
+            .m_TrailY = std.ArrayList(f32).init(allocator),
+        };
+    }
+
+    pub fn Deinit(self: *ReplayCursorOverlay) void {
+        self.m_Times.deinit();
+        self.m_X.deinit();
+        self.m_Y.deinit();
+        self.m_FrameStart.deinit();
+        self.m_FrameIndex.deinit();
+        self.m_Colors.deinit();
+        self.m_Lanes.deinit();
+        self.m_TrailX.deinit();
+        self.m_TrailY.deinit();
+    }
+
+    pub fn GetCount(self: *const ReplayCursorOverlay) usize {
+        return self.m_FrameIndex.items.len;
+    }
+
+    ///Copies _frames_ into the columns, the replay itself isn't referenced afterwards. A replay without frames has no
+    ///cursor to draw and is rejected.
+    pub fn Add(self: *ReplayCursorOverlay, frames: []const ReplayFrame) !void {
+        if (frames.len == 0)
+            return error.EmptyReplay;
+
+        try self.m_Times.ensureUnusedCapacity(frames.len);
+        try self.m_X.ensureUnusedCapacity(frames.len);
+        try self.m_Y.ensureUnusedCapacity(frames.len);
+
+        for (frames) |frame| {
+            self.m_Times.appendAssumeCapacity(@floatFromInt(frame.Time));
+            self.m_X.appendAssumeCapacity(frame.X);
+            self.m_Y.appendAssumeCapacity(frame.Y);
+        }
+
+        try self.m_FrameStart.append(self.m_Times.items.len);
+        try self.m_FrameIndex.append(self.m_FrameStart.items[self.m_FrameStart.items.len - 2]);
+
+        //Golden ratio hue steps keep neighbouring cursors apart however many there are
+        const hue = @mod(@as(f32, @floatFromInt(self.m_Colors.items.len)) * 0.618034, 1.0);
+        try self.m_Colors.append(hueToColor(hue));
+
+        const count = self.GetCount();
+        self.m_LaneStride = std.mem.alignForward(usize, count, LANES);
+
+        try self.m_Lanes.resize(self.m_LaneStride * LANE_COLUMNS);
+        @memset(self.m_Lanes.items, 0.0);
+
+        try self.m_TrailX.resize(TRAIL_LENGTH * count);
+        try self.m_TrailY.resize(TRAIL_LENGTH * count);
+        self.m_TrailFilled = 0;
+        self.m_TrailHead = 0;
+    }
+
+    inline fn lane(self: *ReplayCursorOverlay, column: usize) []f32 {
+        return self.m_Lanes.items[column * self.m_LaneStride ..][0..self.m_LaneStride];
+    }
+
+    pub fn Update(self: *ReplayCursorOverlay, time_ms: f64) void {
+        const count = self.GetCount();
+        if (count == 0)
+            return;
+
+        const time: f32 = @floatCast(time_ms);
+
+        //Seeking makes the old trail meaningless
+        if (time < self.m_LastTime or time - self.m_LastTime > SEEK_WALK_LIMIT_MS) {
+            self.m_TrailFilled = 0;
+            self.m_LastTrailTime = time;
+        }
+        self.m_LastTime = time;
+
+        const t0 = self.lane(LANE_T0);
+        const t1 = self.lane(LANE_T1);
+        const x0 = self.lane(LANE_X0);
+        const x1 = self.lane(LANE_X1);
+        const y0 = self.lane(LANE_Y0);
+        const y1 = self.lane(LANE_Y1);
+
+        const times = self.m_Times.items;
+
+        //Scalar part: advance each replay's index and gather the frames around _time_
+        for (0..count) |r| {
+            const start = self.m_FrameStart.items[r];
+            const end = self.m_FrameStart.items[r + 1];
+
+            var index = self.m_FrameIndex.items[r];
+
+            if (@abs(time - times[index]) > SEEK_WALK_LIMIT_MS) {
+                index = start + findFrame(times[start..end], time);
+            } else {
+                while (index + 1 < end and times[index + 1] <= time) index += 1;
+                while (index > start and times[index] > time) index -= 1;
+            }
+
+            self.m_FrameIndex.items[r] = index;
+
+            const next = @min(index + 1, end - 1);
+
+            t0[r] = times[index];
+            t1[r] = times[next];
+            x0[r] = self.m_X.items[index];
+            x1[r] = self.m_X.items[next];
+            y0[r] = self.m_Y.items[index];
+            y1[r] = self.m_Y.items[next];
+        }
+
+        //Vector part: interpolate every cursor, 8 at a time
+        const out_x = self.lane(LANE_OUT_X);
+        const out_y = self.lane(LANE_OUT_Y);
+
+        const now: Lane = @splat(time);
+        const zero: Lane = @splat(0.0);
+        const one: Lane = @splat(1.0);
+        const min_span: Lane = @splat(0.0001);
+
+        var i: usize = 0;
+        while (i < self.m_LaneStride) : (i += LANES) {
+            const lane_t0: Lane = t0[i..][0..LANES].*;
+            const lane_t1: Lane = t1[i..][0..LANES].*;
+            const lane_x0: Lane = x0[i..][0..LANES].*;
+            const lane_x1: Lane = x1[i..][0..LANES].*;
+            const lane_y0: Lane = y0[i..][0..LANES].*;
+            const lane_y1: Lane = y1[i..][0..LANES].*;
+
+            //Zero length spans clamp to 1 and the two frames are the same anyway
+            const blend = @min(@max((now - lane_t0) / @max(lane_t1 - lane_t0, min_span), zero), one);
+
+            out_x[i..][0..LANES].* = lane_x0 + (lane_x1 - lane_x0) * blend;
+            out_y[i..][0..LANES].* = lane_y0 + (lane_y1 - lane_y0) * blend;
+        }
+
+        if (self.m_TrailFilled == 0 or time - self.m_LastTrailTime >= TRAIL_INTERVAL_MS) {
+            const slot = self.m_TrailHead * count;
+            @memcpy(self.m_TrailX.items[slot..][0..count], out_x[0..count]);
+            @memcpy(self.m_TrailY.items[slot..][0..count], out_y[0..count]);
+
+            self.m_TrailHead = (self.m_TrailHead + 1) % TRAIL_LENGTH;
+            self.m_TrailFilled = @min(self.m_TrailFilled + 1, TRAIL_LENGTH);
+            self.m_LastTrailTime = time;
+        }
+    }
+
+    pub fn Draw(self: *ReplayCursorOverlay, g: *Graphics, cursor_texture: *const Texture, trail_texture: *const Texture, cursor_size: zm.Vec2f) void {
+        const count = self.GetCount();
+        if (count == 0)
+            return;
+
+        const colors = self.m_Colors.items;
+        const trail_size = cursor_size * zm.Vec2f{ 0.5, 0.5 };
+
+        //Oldest first so the newer points end up on top
+        for (0..self.m_TrailFilled) |age| {
+            const slot = (self.m_TrailHead + TRAIL_LENGTH - self.m_TrailFilled + age) % TRAIL_LENGTH;
+            const alpha = 0.5 * @as(f32, @floatFromInt(age + 1)) / @as(f32, @floatFromInt(self.m_TrailFilled + 1));
+
+            const trail_x = self.m_TrailX.items[slot * count ..][0..count];
+            const trail_y = self.m_TrailY.items[slot * count ..][0..count];
+
+            for (trail_x, trail_y, colors) |x, y, color| {
+                const position = PlayableBeatmap.MapToPlayfield2(x, y);
+                g.DrawRectangleCentered(position, trail_size, .{ color[0], color[1], color[2], alpha }, trail_texture, TEXT_RECT);
+            }
+        }
+
+        const out_x = self.lane(LANE_OUT_X)[0..count];
+        const out_y = self.lane(LANE_OUT_Y)[0..count];
+
+        for (out_x, out_y, colors) |x, y, color| {
+            const position = PlayableBeatmap.MapToPlayfield2(x, y);
+            g.DrawRectangleCentered(position, cursor_size, color, cursor_texture, TEXT_RECT);
+        }
+    }
+
+    ///Last frame with time <= _time_ in _times_ (or 0)
+    fn findFrame(times: []const f32, time: f32) usize {
+        var low: usize = 0;
+        var high: usize = times.len;
+
+        while (low < high) {
+            const mid = low + (high - low) / 2;
+
+            if (times[mid] <= time) {
+                low = mid + 1;
+            } else {
+                high = mid;
+            }
+        }
+
+        return if (low == 0) 0 else low - 1;
+    }
+
+    fn hueToColor(hue: f32) zm.Vec4f {
+        const r = std.math.clamp(@abs(hue * 6.0 - 3.0) - 1.0, 0.0, 1.0);
+        const g = std.math.clamp(2.0 - @abs(hue * 6.0 - 2.0), 0.0, 1.0);
+        const b = std.math.clamp(2.0 - @abs(hue * 6.0 - 4.0), 0.0, 1.0);
+
+        return .{ r, g, b, 1.0 };
+    }
+};
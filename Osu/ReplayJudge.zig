@@ -0,0 +1,644 @@
+//Headless osu!standard judgement simulation
+
+//Replays a frame list against a beatmap on a virtual clock (no window, GL or audio) and produces hit counts, combo and
+//score that can be compared with what the replay file says it got. JudgeBeatmap holds everything that only depends on
+//the map (slider checkpoints etc) and is read only, so one instance can be shared by every thread judging replays of it.
+
+const std = @import("std");
+const zm = @import("zm");
+
+const Beatmap = @import("OsuParser.zig").Beatmap;
+const HitObject = @import("OsuParser.zig").HitObject;
+const ReplayFrame = @import("ReplayParser.zig").ReplayFrame;
+const ReplayInfo = @import("ReplayParser.zig").ReplayInfo;
+const ButtonMask = @import("ReplayPlayer.zig").ButtonMask;
+const Path = @import("SliderPath.zig").Path;
+const PathCursor = @import("SliderPath.zig").PathCursor;
+const SliderPath = @import("SliderPath.zig");
+
+pub const Mods = struct {
+    pub const NoFail: u32 = 1;
+    pub const Easy: u32 = 2;
+    pub const Hidden: u32 = 8;
+    pub const HardRock: u32 = 16;
+    pub const DoubleTime: u32 = 64;
+    pub const Relax: u32 = 128;
+    pub const HalfTime: u32 = 256;
+    pub const Nightcore: u32 = 512;
+    pub const Flashlight: u32 = 1024;
+    pub const SpunOut: u32 = 4096;
+    pub const Autopilot: u32 = 8192;
+
+    pub fn ScoreMultiplier(mods: u32) f64 {
+        var multiplier: f64 = 1.0;
+
+        if (mods & Easy != 0) multiplier *= 0.5;
+        if (mods & NoFail != 0) multiplier *= 0.5;
+        if (mods & HalfTime != 0) multiplier *= 0.3;
+        if (mods & Hidden != 0) multiplier *= 1.06;
+        if (mods & HardRock != 0) multiplier *= 1.06;
+        if (mods & (DoubleTime | Nightcore) != 0) multiplier *= 1.12;
+        if (mods & Flashlight != 0) multiplier *= 1.12;
+        if (mods & SpunOut != 0) multiplier *= 0.9;
+
+        return multiplier;
+    }
+};
+
+pub const CheckpointKind = enum { Tick, Repeat, End };
+
+pub const Checkpoint = struct {
+    Time: f64,
+    ///Unstacked, osu pixels
+    Position: zm.Vec2f,
+    Kind: CheckpointKind,
+};
+
+pub const JudgeObjectKind = enum { Circle, Slider, Spinner };
+
+pub const JudgeObject = struct {
+    Kind: JudgeObjectKind,
+    StartTime: f64,
+    EndTime: f64,
+    ///Unstacked, osu pixels
+    Position: zm.Vec2f,
+    StackCount: f32,
+    FirstCheckpoint: usize = 0,
+    CheckpointCount: usize = 0,
+};
+
+pub const HitResult = enum {
+    Great,
+    Ok,
+    Meh,
+    Miss,
+
+    pub fn Value(self: HitResult) u32 {
+        return switch (self) {
+            .Great => 300,
+            .Ok => 100,
+            .Meh => 50,
+            .Miss => 0,
+        };
+    }
+};
+
+pub const JudgeResult = struct {
+    Count300: u32 = 0,
+    Count100: u32 = 0,
+    Count50: u32 = 0,
+    CountMiss: u32 = 0,
+    MaxCombo: u32 = 0,
+    TotalScore: u64 = 0,
+
+    ///Whether the simulated hit counts and combo agree with what the replay recorded
+    pub fn Matches(self: *const JudgeResult, info: *const ReplayInfo) bool {
+        return self.Count300 == info.Count300 and
+            self.Count100 == info.Count100 and
+            self.Count50 == info.Count50 and
+            self.CountMiss == info.CountMiss and
+            self.MaxCombo == info.HighestCombo;
+    }
+};
+
+pub const JudgeBeatmap = struct {
+    Objects: []JudgeObject,
+    Checkpoints: []Checkpoint,
+    CircleSize: f32,
+    OverallDifficulty: f32,
+    DifficultyMultiplier: f64,
+    m_Allocator: std.mem.Allocator,
+
+    pub fn Init(allocator: std.mem.Allocator, beatmap: *const Beatmap) !JudgeBeatmap {
+        const hit_objects = beatmap.HitObjects.items;
+
+        const objects = try allocator.alloc(JudgeObject, hit_objects.len);
+        errdefer allocator.free(objects);
+
+        var checkpoints = std.ArrayList(Checkpoint).init(allocator);
+        errdefer checkpoints.deinit();
+
+        for (hit_objects, 0..) |hit_object, i| {
+            objects[i] = .{
+                .Kind = .Circle,
+                .StartTime = @floatFromInt(hit_object.StartTime),
+                .EndTime = @floatFromInt(hit_object.GetEndTime()),
+                .Position = .{ @floatFromInt(hit_object.X), @floatFromInt(hit_object.Y) },
+                .StackCount = @floatFromInt(hit_object.StackCount),
+            };
+
+            if (hit_object.IsSpinner()) {
+                objects[i].Kind = .Spinner;
+                objects[i].Position = .{ 256.0, 192.0 };
+            } else if (hit_object.IsHitSlider()) {
+                objects[i].Kind = .Slider;
+                objects[i].FirstCheckpoint = checkpoints.items.len;
+
+                try appendSliderCheckpoints(allocator, beatmap, &hit_object, &checkpoints);
+
+                objects[i].CheckpointCount = checkpoints.items.len - objects[i].FirstCheckpoint;
+            }
+        }
+
+        //ScoreV1 difficulty multiplier, uses the nominal (unmodded) difficulty
+        const difficulty = beatmap.Difficulty;
+        var drain_seconds: f64 = 1.0;
+        if (objects.len > 0) {
+            drain_seconds = @max(1.0, (objects[objects.len - 1].EndTime - objects[0].StartTime) / 1000.0);
+        }
+
+        const object_density = std.math.clamp(@as(f64, @floatFromInt(objects.len)) / drain_seconds * 8.0, 0.0, 16.0);
+        const difficulty_points = @as(f64, difficulty.HPDrainRate + difficulty.CircleSize + difficulty.OverallDifficulty) + object_density;
+
+        return .{
+            .Objects = objects,
+            .Checkpoints = try checkpoints.toOwnedSlice(),
+            .CircleSize = difficulty.CircleSize,
+            .OverallDifficulty = difficulty.OverallDifficulty,
+            .DifficultyMultiplier = @round(difficulty_points / 38.0 * 5.0),
+            .m_Allocator = allocator,
+        };
+    }
+
+    pub fn Deinit(self: *JudgeBeatmap) void {
+        self.m_Allocator.free(self.Objects);
+        self.m_Allocator.free(self.Checkpoints);
+    }
+
+    fn appendSliderCheckpoints(allocator: std.mem.Allocator, beatmap: *const Beatmap, hit_object: *const HitObject, checkpoints: *std.ArrayList(Checkpoint)) !void {
+        const slider = hit_object.HitSlider.?;
+
+        const points = try SliderPath.BuildPoints(allocator, hit_object.*);
+        defer allocator.free(points);
+
+        var path = try Path.Init(allocator, points, 0.0);
+        defer path.Deinit(allocator);
+
+        //Ticks go forwards along the path, then backwards on reversed spans
+        var cursor = PathCursor{};
+
+        const start_time: f64 = @floatFromInt(hit_object.StartTime);
+        const end_time: f64 = @floatFromInt(slider.EndTime);
+        const slides: usize = @intCast(@max(1, slider.Slides));
+        const span_duration = (end_time - start_time) / @as(f64, @floatFromInt(slides));
+
+        const pixel_length: f32 = if (slider.PixelLength > 0.0) slider.PixelLength else path.Length;
+        const ticks = beatmap.GetSliderTicks(hit_object, path.Length);
+        const tick_distance = ticks.Spacing;
+        const tick_count = ticks.Count;
+
+        const head = points[0];
+        const tail = points[points.len - 1];
+
+        const first_checkpoint = checkpoints.items.len;
+
+        for (0..slides) |span| {
+            const span_start = start_time + @as(f64, @floatFromInt(span)) * span_duration;
+            const reversed = span % 2 == 1;
+
+            for (0..tick_count) |j| {
+                const k = if (reversed) tick_count - 1 - j else j;
+                const distance = @as(f32, @floatFromInt(k + 1)) * tick_distance;
+                const progress: f64 = @floatCast(distance / pixel_length);
+                const span_progress = if (reversed) 1.0 - progress else progress;
+
+                try checkpoints.append(.{
+                    .Time = span_start + span_progress * span_duration,
+                    .Position = cursor.PositionAt(&path, distance),
+                    .Kind = .Tick,
+                });
+            }
+
+            if (span + 1 < slides) {
+                try checkpoints.append(.{
+                    .Time = span_start + span_duration,
+                    .Position = if (reversed) head else tail,
+                    .Kind = .Repeat,
+                });
+            }
+        }
+
+        //Legacy tail leniency, the end is checked up to 36ms early
+        try checkpoints.append(.{
+            .Time = @max(start_time + (end_time - start_time) / 2.0, end_time - 36.0),
+            .Position = if (slides % 2 == 1) tail else head,
+            .Kind = .End,
+        });
+
+        std.mem.sort(Checkpoint, checkpoints.items[first_checkpoint..], {}, checkpointLessThan);
+    }
+
+    fn checkpointLessThan(_: void, left: Checkpoint, right: Checkpoint) bool {
+        return left.Time < right.Time;
+    }
+};
+
+///Simulates _frames_ against _beatmap_ and returns the judgement totals
+pub fn JudgeReplay(allocator: std.mem.Allocator, beatmap: *const JudgeBeatmap, frames: []const ReplayFrame, mods: u32) !JudgeResult {
+    var judge = try Judge.init(allocator, beatmap, mods);
+    defer judge.deinit();
+
+    judge.run(frames);
+
+    return judge.result;
+}
+
+///Same as JudgeReplay but also appends the timing offset (ms, negative is early) of every hit circle/slider head that was hit
+pub fn JudgeReplayWithHitErrors(allocator: std.mem.Allocator, beatmap: *const JudgeBeatmap, frames: []const ReplayFrame, mods: u32, hit_errors: *std.ArrayList(f32)) !JudgeResult {
+    var judge = try Judge.init(allocator, beatmap, mods);
+    defer judge.deinit();
+
+    judge.hit_errors = hit_errors;
+    judge.run(frames);
+
+    return judge.result;
+}
+
+const ObjectState = struct {
+    HeadJudged: bool = false,
+    Finished: bool = false,
+    NextCheckpoint: usize = 0,
+    Hits: u32 = 0,
+    Tracking: bool = false,
+    SpinAngle: f64 = 0.0,
+};
+
+const Judge = struct {
+    //Clicking earlier than this before an object does nothing, between this and the 50 window it's a miss
+    const MISS_WINDOW: f64 = 400.0;
+    const FOLLOW_RADIUS_SCALE: f32 = 2.4;
+    //~477rpm, the spinner cap
+    const MAX_SPIN_RADIANS_PER_MS: f64 = 0.05;
+
+    const KEY_A: u32 = ButtonMask.M1 | ButtonMask.K1;
+    const KEY_B: u32 = ButtonMask.M2 | ButtonMask.K2;
+
+    beatmap: *const JudgeBeatmap,
+    states: []ObjectState,
+    allocator: std.mem.Allocator,
+    result: JudgeResult = .{},
+    hit_errors: ?*std.ArrayList(f32) = null,
+
+    combo: u32 = 0,
+    next_head: usize = 0,
+    first_active: usize = 0,
+
+    flip_y: bool,
+    radius: f32,
+    stack_offset: f32,
+    window_300: f64,
+    window_100: f64,
+    window_50: f64,
+    spins_per_second: f64,
+    score_multiplier: f64,
+
+    fn init(allocator: std.mem.Allocator, beatmap: *const JudgeBeatmap, mods: u32) !Judge {
+        const states = try allocator.alloc(ObjectState, beatmap.Objects.len);
+
+        for (states, beatmap.Objects) |*state, object| {
+            state.* = .{ .HeadJudged = object.Kind == .Spinner };
+        }
+
+        var cs = beatmap.CircleSize;
+        var od = beatmap.OverallDifficulty;
+
+        if (mods & Mods.HardRock != 0) {
+            cs = @min(cs * 1.3, 10.0);
+            od = @min(od * 1.4, 10.0);
+        } else if (mods & Mods.Easy != 0) {
+            cs *= 0.5;
+            od *= 0.5;
+        }
+
+        const radius = 54.4 - 4.48 * cs;
+        const od_f64: f64 = od;
+
+        return .{
+            .beatmap = beatmap,
+            .states = states,
+            .allocator = allocator,
+            //Flipping the cursor is the same as flipping the whole map
+            .flip_y = mods & Mods.HardRock != 0,
+            .radius = radius,
+            .stack_offset = radius / 10.0,
+            .window_300 = 80.0 - 6.0 * od_f64,
+            .window_100 = 140.0 - 8.0 * od_f64,
+            .window_50 = 200.0 - 10.0 * od_f64,
+            .spins_per_second = Beatmap.MapDifficultyRange(od, 3.0, 5.0, 7.5),
+            .score_multiplier = beatmap.DifficultyMultiplier * Mods.ScoreMultiplier(mods),
+        };
+    }
+
+    fn deinit(self: *Judge) void {
+        self.allocator.free(self.states);
+    }
+
+    fn run(self: *Judge, frames: []const ReplayFrame) void {
+        if (frames.len == 0) {
+            self.finish();
+            return;
+        }
+
+        var prev = frames[0];
+
+        for (frames[1..]) |frame| {
+            if (frame.Time < prev.Time)
+                continue;
+
+            self.advance(prev, frame);
+            self.handlePresses(prev.ButtonMask, frame);
+
+            prev = frame;
+        }
+
+        self.finish();
+    }
+
+    inline fn framePosition(self: *const Judge, frame: ReplayFrame) zm.Vec2f {
+        return .{ frame.X, if (self.flip_y) 384.0 - frame.Y else frame.Y };
+    }
+
+    inline fn stacked(self: *const Judge, position: zm.Vec2f, stack_count: f32) zm.Vec2f {
+        const offset = self.stack_offset * stack_count;
+        return position - zm.Vec2f{ offset, offset };
+    }
+
+    inline fn isHeld(mask: u32) bool {
+        return (mask & (KEY_A | KEY_B)) != 0;
+    }
+
+    ///Everything that happens in the time between _prev_ and _frame_: checkpoints, spinner rotation and expired objects
+    fn advance(self: *Judge, prev: ReplayFrame, frame: ReplayFrame) void {
+        const objects = self.beatmap.Objects;
+        const t0: f64 = @floatFromInt(prev.Time);
+        const t1: f64 = @floatFromInt(frame.Time);
+        const prev_pos = self.framePosition(prev);
+        const frame_pos = self.framePosition(frame);
+        const held = isHeld(prev.ButtonMask);
+
+        var i = self.first_active;
+        while (i < objects.len and objects[i].StartTime <= t1 + self.window_50) : (i += 1) {
+            const object = &objects[i];
+            const state = &self.states[i];
+
+            if (state.Finished)
+                continue;
+
+            if (!state.HeadJudged and object.StartTime + self.window_50 < t1) {
+                self.judgeHead(i, .Miss);
+            }
+
+            switch (object.Kind) {
+                .Circle => {},
+                .Slider => {
+                    const checkpoints = self.beatmap.Checkpoints[object.FirstCheckpoint .. object.FirstCheckpoint + object.CheckpointCount];
+
+                    while (state.NextCheckpoint < checkpoints.len and checkpoints[state.NextCheckpoint].Time <= t1) {
+                        const checkpoint = checkpoints[state.NextCheckpoint];
+
+                        var blend: f32 = 1.0;
+                        if (t1 > t0) {
+                            blend = @floatCast(std.math.clamp((checkpoint.Time - t0) / (t1 - t0), 0.0, 1.0));
+                        }
+
+                        const cursor = zm.vec.lerp(prev_pos, frame_pos, blend);
+                        const follow_radius = if (state.Tracking) self.radius * FOLLOW_RADIUS_SCALE else self.radius;
+                        const target = self.stacked(checkpoint.Position, object.StackCount);
+
+                        state.Tracking = held and zm.vec.distance(cursor, target) <= follow_radius;
+                        self.judgeCheckpoint(i, checkpoint.Kind, state.Tracking);
+                    }
+                },
+                .Spinner => {
+                    const from = @max(t0, object.StartTime);
+                    const to = @min(t1, object.EndTime);
+
+                    if (held and to > from) {
+                        const prev_angle = std.math.atan2(prev_pos[1] - object.Position[1], prev_pos[0] - object.Position[0]);
+                        const frame_angle = std.math.atan2(frame_pos[1] - object.Position[1], frame_pos[0] - object.Position[0]);
+
+                        var delta: f64 = @floatCast(frame_angle - prev_angle);
+                        if (delta > std.math.pi) delta -= 2.0 * std.math.pi;
+                        if (delta < -std.math.pi) delta += 2.0 * std.math.pi;
+
+                        const max_delta = MAX_SPIN_RADIANS_PER_MS * (to - from);
+                        state.SpinAngle += std.math.clamp(delta, -max_delta, max_delta);
+                    }
+
+                    if (t1 >= object.EndTime) {
+                        self.finishSpinner(i);
+                    }
+                },
+            }
+        }
+
+        while (self.first_active < objects.len and self.states[self.first_active].Finished) {
+            self.first_active += 1;
+        }
+    }
+
+    fn handlePresses(self: *Judge, prev_mask: u32, frame: ReplayFrame) void {
+        const pressed_a = (frame.ButtonMask & KEY_A) != 0 and (prev_mask & KEY_A) == 0;
+        const pressed_b = (frame.ButtonMask & KEY_B) != 0 and (prev_mask & KEY_B) == 0;
+
+        const time: f64 = @floatFromInt(frame.Time);
+        const position = self.framePosition(frame);
+
+        if (pressed_a) self.press(time, position);
+        if (pressed_b) self.press(time, position);
+    }
+
+    fn press(self: *Judge, time: f64, position: zm.Vec2f) void {
+        const objects = self.beatmap.Objects;
+
+        while (self.next_head < objects.len and self.states[self.next_head].HeadJudged) {
+            self.next_head += 1;
+        }
+
+        if (self.next_head >= objects.len)
+            return;
+
+        //Only the earliest unjudged object can be hit (note lock)
+        const object = objects[self.next_head];
+        const offset = time - object.StartTime;
+
+        if (offset < -MISS_WINDOW or offset > self.window_50)
+            return;
+
+        if (zm.vec.distance(position, self.stacked(object.Position, object.StackCount)) > self.radius)
+            return;
+
+        const abs_offset = @abs(offset);
+        const result: HitResult = if (abs_offset <= self.window_300)
+            .Great
+        else if (abs_offset <= self.window_100)
+            .Ok
+        else if (abs_offset <= self.window_50)
+            .Meh
+        else
+            .Miss;
+
+        if (result != .Miss) {
+            if (self.hit_errors) |hit_errors| {
+                hit_errors.append(@floatCast(offset)) catch {};
+            }
+        }
+
+        self.judgeHead(self.next_head, result);
+    }
+
+    fn judgeHead(self: *Judge, index: usize, result: HitResult) void {
+        const state = &self.states[index];
+        state.HeadJudged = true;
+
+        switch (self.beatmap.Objects[index].Kind) {
+            .Circle => {
+                self.applyResult(result);
+                state.Finished = true;
+            },
+            .Slider => {
+                if (result == .Miss) {
+                    self.breakCombo();
+                } else {
+                    state.Hits += 1;
+                    state.Tracking = true;
+                    self.addRaw(30);
+                }
+            },
+            .Spinner => {},
+        }
+    }
+
+    fn judgeCheckpoint(self: *Judge, index: usize, kind: CheckpointKind, hit: bool) void {
+        const state = &self.states[index];
+        state.NextCheckpoint += 1;
+
+        if (hit) {
+            state.Hits += 1;
+            self.addRaw(if (kind == .Tick) 10 else 30);
+        } else if (kind != .End) {
+            //Missing the end only costs accuracy
+            self.breakCombo();
+        }
+
+        if (kind == .End) {
+            self.finishSlider(index);
+        }
+    }
+
+    fn finishSlider(self: *Judge, index: usize) void {
+        const state = &self.states[index];
+
+        if (!state.HeadJudged) {
+            state.HeadJudged = true;
+            self.breakCombo();
+        }
+
+        const total: u32 = @intCast(self.beatmap.Objects[index].CheckpointCount + 1);
+
+        const result: HitResult = if (state.Hits == total)
+            .Great
+        else if (state.Hits * 2 >= total)
+            .Ok
+        else if (state.Hits > 0)
+            .Meh
+        else
+            .Miss;
+
+        self.countResult(result);
+        if (result != .Miss) {
+            self.addScore(result.Value());
+        }
+
+        state.Finished = true;
+    }
+
+    fn finishSpinner(self: *Judge, index: usize) void {
+        const object = self.beatmap.Objects[index];
+        const state = &self.states[index];
+
+        const required_spins = (object.EndTime - object.StartTime) / 1000.0 * self.spins_per_second;
+        const spins = @abs(state.SpinAngle) / (2.0 * std.math.pi);
+        const progress = if (required_spins > 0.0) spins / required_spins else 1.0;
+
+        const result: HitResult = if (progress >= 1.0)
+            .Great
+        else if (progress > 0.9)
+            .Ok
+        else if (progress > 0.75)
+            .Meh
+        else
+            .Miss;
+
+        self.applyResult(result);
+        state.Finished = true;
+    }
+
+    ///Judges whatever the replay never got to
+    fn finish(self: *Judge) void {
+        const objects = self.beatmap.Objects;
+
+        for (self.first_active..objects.len) |i| {
+            const state = &self.states[i];
+            if (state.Finished)
+                continue;
+
+            switch (objects[i].Kind) {
+                .Circle => self.judgeHead(i, .Miss),
+                .Slider => {
+                    if (!state.HeadJudged)
+                        self.judgeHead(i, .Miss);
+
+                    const checkpoints = self.beatmap.Checkpoints[objects[i].FirstCheckpoint .. objects[i].FirstCheckpoint + objects[i].CheckpointCount];
+                    while (state.NextCheckpoint < checkpoints.len) {
+                        self.judgeCheckpoint(i, checkpoints[state.NextCheckpoint].Kind, false);
+                    }
+                },
+                .Spinner => self.finishSpinner(i),
+            }
+        }
+    }
+
+    fn applyResult(self: *Judge, result: HitResult) void {
+        self.countResult(result);
+
+        if (result == .Miss) {
+            self.breakCombo();
+        } else {
+            self.addScore(result.Value());
+            self.incrementCombo();
+        }
+    }
+
+    fn countResult(self: *Judge, result: HitResult) void {
+        switch (result) {
+            .Great => self.result.Count300 += 1,
+            .Ok => self.result.Count100 += 1,
+            .Meh => self.result.Count50 += 1,
+            .Miss => self.result.CountMiss += 1,
+        }
+    }
+
+    ///ScoreV1: hit value scaled by combo, difficulty and mods
+    fn addScore(self: *Judge, value: u32) void {
+        const combo_multiplier: f64 = @floatFromInt(if (self.combo > 0) self.combo - 1 else 0);
+        const hit_value: f64 = @floatFromInt(value);
+
+        self.result.TotalScore += @intFromFloat(hit_value + @floor(hit_value * combo_multiplier * self.score_multiplier / 25.0));
+    }
+
+    ///Slider parts give a flat amount and a combo
+    fn addRaw(self: *Judge, value: u32) void {
+        self.result.TotalScore += value;
+        self.incrementCombo();
+    }
+
+    fn incrementCombo(self: *Judge) void {
+        self.combo += 1;
+        self.result.MaxCombo = @max(self.result.MaxCombo, self.combo);
+    }
+
+    fn breakCombo(self: *Judge) void {
+        self.combo = 0;
+    }
+};
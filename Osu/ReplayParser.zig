@@ -1,5 +1,7 @@
 const std = @import("std");
 
+const LzmaEncoder = @import("../LzmaEncoder.zig");
+
 pub const ButtonMaskStruct = packed struct {
     M1: u1,
     M2: u1,
@@ -8,6 +10,9 @@ pub const ButtonMaskStruct = packed struct {
     Smoke: u1,
 };
 
+///Time of the frame that carries the rng seed instead of a position
+pub const SEED_FRAME_TIME: i64 = -12345;
+
 pub const ReplayFrame = struct {
     Time: u64,
     Delta: u64,
@@ -36,6 +41,8 @@ pub const ReplayInfo = struct {
     Lifebar: []const u8,
     Timestamp: u64,
     OnlineScoreID: u64,
+    ///From the frame data's seed frame
+    RngSeed: u32 = 0,
 };
 
 pub const Replay = struct {
@@ -52,57 +59,62 @@ pub const Replay = struct {
         const data = try file.readToEndAlloc(allocator, 1024 * 1000);
         defer allocator.free(data);
 
+        return FromData(allocator, data);
+    }
+
+    ///Parses an in-memory .osr file, _data_ isn't referenced after this returns
+    pub fn FromData(allocator: std.mem.Allocator, data: []const u8) !Replay {
         var read_pos: usize = 0;
 
-        const game_mode = readu8(data, &read_pos);
+        const game_mode = try readu8(data, &read_pos);
 
-        const game_version = readu32(data, &read_pos); //std.mem.readInt(i32, @ptrCast(&data[read_pos]), .little);
+        const game_version = try readu32(data, &read_pos); //std.mem.readInt(i32, @ptrCast(&data[read_pos]), .little);
 
         const md5_hash = try readString(data, &read_pos);
         const player_name = try readString(data, &read_pos);
         const replay_md5 = try readString(data, &read_pos);
 
-        const count_300 = readu16(data, &read_pos);
-        const count_100 = readu16(data, &read_pos);
-        const count_50 = readu16(data, &read_pos);
+        const count_300 = try readu16(data, &read_pos);
+        const count_100 = try readu16(data, &read_pos);
+        const count_50 = try readu16(data, &read_pos);
 
-        const count_geki = readu16(data, &read_pos);
-        const count_katu = readu16(data, &read_pos);
+        const count_geki = try readu16(data, &read_pos);
+        const count_katu = try readu16(data, &read_pos);
 
-        const count_miss = readu16(data, &read_pos);
+        const count_miss = try readu16(data, &read_pos);
 
-        const total_score = readu32(data, &read_pos);
-        const highest_combo = readu16(data, &read_pos);
+        const total_score = try readu32(data, &read_pos);
+        const highest_combo = try readu16(data, &read_pos);
 
-        const full_combo = readu8(data, &read_pos);
+        const full_combo = try readu8(data, &read_pos);
 
-        const mods = readu32(data, &read_pos);
+        const mods = try readu32(data, &read_pos);
 
         const lifebar = try readString(data, &read_pos);
 
-        const timestamp = readu64(data, &read_pos);
+        const timestamp = try readu64(data, &read_pos);
 
-        const replay_data_len: usize = @intCast(readu32(data, &read_pos));
-        //this is really dangerous lol
+        const replay_data_len: usize = @intCast(try readu32(data, &read_pos));
 
-        if (replay_data_len + read_pos >= data.len)
-            return error.InvalidReplayLengthBufferOverflow;
+        if (replay_data_len > data.len - read_pos)
+            return error.EndOfStream;
 
         const replay_data = data[read_pos .. read_pos + replay_data_len];
         read_pos += replay_data_len;
 
         var reader = std.io.fixedBufferStream(replay_data);
         var lzma_stream = try std.compress.lzma.decompress(allocator, reader.reader());
+        defer lzma_stream.deinit();
 
         const replay_data_decom = try lzma_stream.reader().readAllAlloc(allocator, 5_000_000);
-
-        defer lzma_stream.deinit();
         defer allocator.free(replay_data_decom);
 
-        const replay_frames = parseReplayData(allocator, replay_data_decom);
+        var rng_seed: u32 = 0;
+        const replay_frames = parseReplayData(allocator, replay_data_decom, &rng_seed);
+        errdefer replay_frames.deinit();
         //_ = replay_data_decom;
 
-        const online_score_id = readu64(data, &read_pos);
+        const online_score_id = try readu64(data, &read_pos);
 
         //Only in the data if mods has target practice
         //const additional_mod_info: f64 = std.mem.bytesToValue(f64, &data[read_pos]);
@@ -153,10 +165,80 @@ pub const Replay = struct {
                 .Lifebar = allocator.dupe(u8, lifebar) catch unreachable,
                 .Timestamp = timestamp,
                 .OnlineScoreID = online_score_id,
+                .RngSeed = rng_seed,
             },
         };
     }
 
+    ///Serializes into the same .osr layout FromData reads, caller owns the returned slice
+    pub fn ToData(self: *const Replay, allocator: std.mem.Allocator) ![]u8 {
+        var frame_text = std.ArrayList(u8).init(allocator);
+        defer frame_text.deinit();
+
+        //Frames store absolute time, the file wants the delta to the previous one
+        var prev_time: u64 = 0;
+        for (self.ReplayFrames.items) |frame| {
+            try frame_text.writer().print("{d}|{d}|{d}|{d},", .{ frame.Time - prev_time, frame.X, frame.Y, frame.ButtonMask });
+            prev_time = frame.Time;
+        }
+
+        //osu! writes the rng seed as one more frame after the last one
+        try frame_text.writer().print("{d}|0|0|{d},", .{ SEED_FRAME_TIME, self.ReplayInfo.RngSeed });
+
+        const compressed = try LzmaEncoder.Compress(allocator, frame_text.items);
+        defer allocator.free(compressed);
+
+        var data = std.ArrayList(u8).init(allocator);
+        errdefer data.deinit();
+
+        const info = &self.ReplayInfo;
+        const writer = data.writer();
+
+        try writer.writeInt(u8, info.GameMode, .little);
+        try writer.writeInt(u32, info.GameVersion, .little);
+
+        try writeString(writer, info.BeatmapMD5Hash);
+        try writeString(writer, info.PlayerName);
+        try writeString(writer, info.ReplayMD5Hash);
+
+        try writer.writeInt(u16, info.Count300, .little);
+        try writer.writeInt(u16, info.Count100, .little);
+        try writer.writeInt(u16, info.Count50, .little);
+
+        try writer.writeInt(u16, info.CountGeki, .little);
+        try writer.writeInt(u16, info.CountKatu, .little);
+
+        try writer.writeInt(u16, info.CountMiss, .little);
+
+        try writer.writeInt(u32, info.TotalScore, .little);
+        try writer.writeInt(u16, info.HighestCombo, .little);
+
+        try writer.writeInt(u8, @intFromBool(info.FullCombo), .little);
+
+        try writer.writeInt(u32, info.Mods, .little);
+
+        try writeString(writer, info.Lifebar);
+
+        try writer.writeInt(u64, info.Timestamp, .little);
+
+        try writer.writeInt(u32, @intCast(compressed.len), .little);
+        try writer.writeAll(compressed);
+
+        try writer.writeInt(u64, info.OnlineScoreID, .little);
+
+        return try data.toOwnedSlice();
+    }
+
+    pub fn SaveToFile(self: *const Replay, allocator: std.mem.Allocator, file_path: []const u8) !void {
+        const data = try self.ToData(allocator);
+        defer allocator.free(data);
+
+        const file = try std.fs.cwd().createFile(file_path, .{});
+        defer file.close();
+
+        try file.writeAll(data);
+    }
+
     pub fn Deinit(self: *Replay) void {
         self.ReplayFrames.deinit();
         self.m_Allocator.free(self.ReplayInfo.BeatmapMD5Hash);
@@ -165,29 +247,45 @@ pub const Replay = struct {
         self.m_Allocator.free(self.ReplayInfo.Lifebar);
     }
 
-    fn parseReplayData(allocator: std.mem.Allocator, data: []const u8) std.ArrayList(ReplayFrame) {
+    ///_rng_seed_ is set from the seed frame if there is one
+    fn parseReplayData(allocator: std.mem.Allocator, data: []const u8, rng_seed: *u32) std.ArrayList(ReplayFrame) {
         var replay_frames = std.ArrayList(ReplayFrame).initCapacity(allocator, 10) catch unreachable;
 
         var frames = std.mem.splitScalar(u8, data, ',');
 
-        var total_time: u64 = 0;
+        var total_time: i64 = 0;
 
         while (frames.next()) |next_frame| {
+            //The data ends with a comma
+            if (next_frame.len == 0)
+                continue;
+
             var frame_data = std.mem.splitScalar(u8, next_frame, '|');
 
-            var time: u64 = 0;
+            var time: i64 = 0;
             var x: f32 = 0.0;
             var y: f32 = 0.0;
             var button_mask: u32 = 0;
 
             if (frame_data.next()) |time_str| {
-                time = std.fmt.parseInt(u64, time_str, 10) catch 0;
+                time = std.fmt.parseInt(i64, time_str, 10) catch 0;
+
+                //The rng seed, not a frame
+                if (time == SEED_FRAME_TIME) {
+                    _ = frame_data.next();
+                    _ = frame_data.next();
+                    if (frame_data.next()) |seed_str| {
+                        rng_seed.* = std.fmt.parseInt(u32, seed_str, 10) catch 0;
+                    }
 
-                //ignore negative frametimes for that rng seed thing
-                if (time < 0)
                     continue;
+                }
 
                 total_time += time;
+
+                //Like osu!, frames going back in time still move the clock but aren't played
+                if (time < 0)
+                    continue;
             }
 
             if (frame_data.next()) |x_str| {
@@ -203,8 +301,8 @@ pub const Replay = struct {
             }
 
             replay_frames.append(.{
-                .Time = total_time,
-                .Delta = time,
+                .Time = @intCast(@max(total_time, 0)),
+                .Delta = @intCast(time),
                 .X = x,
                 .Y = y,
                 .ButtonMask = button_mask,
@@ -217,63 +315,72 @@ pub const Replay = struct {
         return replay_frames;
     }
 
-    fn readu8(buffer: []const u8, read_pos: *usize) u8 {
-        const value = buffer[read_pos.*];
-        read_pos.* += 1;
-        return value;
+    fn readu8(buffer: []const u8, read_pos: *usize) !u8 {
+        return readInt(u8, buffer, read_pos);
     }
 
-    fn readu16(buffer: []const u8, read_pos: *usize) u16 {
-        const value: u16 = std.mem.readInt(u16, @ptrCast(&buffer[read_pos.*]), .little);
-        read_pos.* += 2;
-
-        return value;
+    fn readu16(buffer: []const u8, read_pos: *usize) !u16 {
+        return readInt(u16, buffer, read_pos);
     }
 
-    fn readu32(buffer: []const u8, read_pos: *usize) u32 {
-        const value: u32 = std.mem.readInt(u32, @ptrCast(&buffer[read_pos.*]), .little);
-        read_pos.* += 4;
+    fn readu32(buffer: []const u8, read_pos: *usize) !u32 {
+        return readInt(u32, buffer, read_pos);
+    }
 
-        return value;
+    fn readu64(buffer: []const u8, read_pos: *usize) !u64 {
+        return readInt(u64, buffer, read_pos);
     }
 
-    fn readu64(buffer: []const u8, read_pos: *usize) u64 {
-        const value: u64 = std.mem.readInt(u64, @ptrCast(&buffer[read_pos.*]), .little);
-        read_pos.* += 8;
+    fn readInt(comptime T: type, buffer: []const u8, read_pos: *usize) !T {
+        const size = @sizeOf(T);
+        if (read_pos.* > buffer.len or size > buffer.len - read_pos.*)
+            return error.EndOfStream;
+
+        const value = std.mem.readInt(T, buffer[read_pos.*..][0..size], .little);
+        read_pos.* += size;
 
         return value;
     }
 
     fn readString(buffer: []const u8, read_pos: *usize) ![]const u8 {
-        const status = buffer[read_pos.*];
-        read_pos.* += 1;
+        const status = try readu8(buffer, read_pos);
 
         if (status == 0)
             return "";
 
         const str_len = try readVarInt(buffer, read_pos);
-        if (str_len >= (read_pos.* + str_len))
-            return error.InvalidStrLenBufferOverflow;
+        if (str_len > buffer.len - read_pos.*)
+            return error.EndOfStream;
 
         const str = buffer[read_pos.*..(read_pos.* + str_len)];
         read_pos.* += str_len;
         return str;
     }
 
+    fn writeString(writer: anytype, str: []const u8) !void {
+        if (str.len == 0) {
+            try writer.writeByte(0);
+            return;
+        }
+
+        try writer.writeByte(0x0b);
+        try std.leb.writeUleb128(writer, str.len);
+        try writer.writeAll(str);
+    }
+
     fn readVarInt(buffer: []const u8, read_pos: *usize) !usize {
         var result: usize = 0;
         var shift: u6 = 0;
 
         var i = read_pos.*;
-        defer read_pos.* = i + 1;
         while (i < buffer.len) : (i += 1) {
             const byte = buffer[i];
             const payload = byte & 0x7F;
             result |= (@as(usize, payload) << shift);
 
             if ((byte & 0x80) == 0) {
-                //return result;
-                break;
+                read_pos.* = i + 1;
+                return result;
             }
 
             shift += 7;
@@ -282,8 +389,77 @@ pub const Replay = struct {
             }
         }
 
-        return result;
+        //Ran out before the last byte
+        return error.EndOfStream;
     }
-
-    //pub fn FromData() Replay {}
 };
+
+test "parseReplayData skips the rng seed and frames going back in time" {
+    var rng_seed: u32 = 0;
+    const frames = Replay.parseReplayData(std.testing.allocator, "16|100|200|1,-1|256|-500|0,17|110|210|0,-12345|0|0|7777,", &rng_seed);
+    defer frames.deinit();
+
+    try std.testing.expectEqual(@as(u32, 7777), rng_seed);
+
+    try std.testing.expectEqual(@as(usize, 2), frames.items.len);
+
+    try std.testing.expectEqual(@as(u64, 16), frames.items[0].Time);
+    try std.testing.expectEqual(@as(f32, 100.0), frames.items[0].X);
+    try std.testing.expectEqual(@as(u32, 1), frames.items[0].ButtonMask);
+
+    //The skipped frame still moved the clock back
+    try std.testing.expectEqual(@as(u64, 32), frames.items[1].Time);
+    try std.testing.expectEqual(@as(u64, 17), frames.items[1].Delta);
+}
+
+test "FromData fails with EndOfStream instead of reading past a truncated replay" {
+    const allocator = std.testing.allocator;
+
+    var frames = std.ArrayList(ReplayFrame).init(allocator);
+    defer frames.deinit();
+    try frames.append(.{ .Time = 16, .Delta = 16, .X = 100.0, .Y = 200.0, .ButtonMask = 5 });
+    try frames.append(.{ .Time = 33, .Delta = 17, .X = 110.0, .Y = 210.0, .ButtonMask = 0 });
+
+    //Not deinited, nothing in it is owned
+    const replay = Replay{
+        .m_Allocator = allocator,
+        .ReplayFrames = frames,
+        .ReplayInfo = .{
+            .GameMode = 0,
+            .GameVersion = 20250101,
+            .BeatmapMD5Hash = "0123456789abcdef0123456789abcdef",
+            .PlayerName = "player",
+            .ReplayMD5Hash = "",
+            .Count300 = 2,
+            .Count100 = 0,
+            .Count50 = 0,
+            .CountGeki = 0,
+            .CountKatu = 0,
+            .CountMiss = 0,
+            .TotalScore = 600,
+            .HighestCombo = 2,
+            .FullCombo = true,
+            .Mods = 0,
+            .Lifebar = "",
+            .Timestamp = 0,
+            .OnlineScoreID = 0,
+            .RngSeed = 1234,
+        },
+    };
+
+    const data = try replay.ToData(allocator);
+    defer allocator.free(data);
+
+    var parsed = try Replay.FromData(allocator, data);
+    defer parsed.Deinit();
+
+    //The seed frame went out with the data and came back as the seed, not as a frame
+    try std.testing.expectEqual(frames.items.len, parsed.ReplayFrames.items.len);
+    try std.testing.expectEqual(@as(u64, 33), parsed.ReplayFrames.items[1].Time);
+    try std.testing.expectEqual(@as(u32, 1234), parsed.ReplayInfo.RngSeed);
+
+    //Cut in the header, in the middle of the hash and in the online score id at the very end
+    for ([_]usize{ 0, 3, 20, data.len - 4 }) |len| {
+        try std.testing.expectError(error.EndOfStream, Replay.FromData(allocator, data[0..len]));
+    }
+}
@@ -0,0 +1,99 @@
+const std = @import("std");
+const zm = @import("zm");
+
+const ReplayFrame = @import("ReplayParser.zig").ReplayFrame;
+
+pub const ButtonMask = struct {
+    pub const M1: u32 = 1;
+    pub const M2: u32 = 2;
+    pub const K1: u32 = 4;
+    pub const K2: u32 = 8;
+    pub const Smoke: u32 = 16;
+};
+
+///Walks a replay's frame list in step with a clock, keeping the current frame index between calls so that
+///normal playback, pausing and small seeks only move a couple of frames instead of searching from the start.
+pub const ReplayPlayer = struct {
+    //Anything further away than this from the current frame gets a binary search instead of a linear walk
+    const SEEK_WALK_LIMIT_MS: f64 = 1000.0;
+
+    Frames: []const ReplayFrame,
+    ///Interpolated cursor position in osu pixels
+    Position: zm.Vec2f = .{ 0.0, 0.0 },
+    ButtonMask: u32 = 0,
+
+    m_FrameIndex: usize = 0,
+
+    pub fn Init(frames: []const ReplayFrame) ReplayPlayer {
+        var player = ReplayPlayer{ .Frames = frames };
+        player.Update(0.0);
+        return player;
+    }
+
+    ///Moves the playhead to _time_ms_ (map time) and updates Position and ButtonMask
+    pub fn Update(self: *ReplayPlayer, time_ms: f64) void {
+        const frames = self.Frames;
+        if (frames.len == 0)
+            return;
+
+        const current_time: f64 = @floatFromInt(frames[self.m_FrameIndex].Time);
+
+        if (@abs(time_ms - current_time) > SEEK_WALK_LIMIT_MS) {
+            self.m_FrameIndex = findFrameIndex(frames, time_ms);
+        } else {
+            //Walk forwards or backwards from where we left off
+            while (self.m_FrameIndex + 1 < frames.len and @as(f64, @floatFromInt(frames[self.m_FrameIndex + 1].Time)) <= time_ms) {
+                self.m_FrameIndex += 1;
+            }
+
+            while (self.m_FrameIndex > 0 and @as(f64, @floatFromInt(frames[self.m_FrameIndex].Time)) > time_ms) {
+                self.m_FrameIndex -= 1;
+            }
+        }
+
+        const now = frames[self.m_FrameIndex];
+        self.ButtonMask = now.ButtonMask;
+
+        if (self.m_FrameIndex + 1 >= frames.len) {
+            self.Position = .{ now.X, now.Y };
+            return;
+        }
+
+        const next = frames[self.m_FrameIndex + 1];
+        const now_time: f64 = @floatFromInt(now.Time);
+        const next_time: f64 = @floatFromInt(next.Time);
+
+        var blend: f32 = 0.0;
+        if (next_time > now_time) {
+            blend = @floatCast(std.math.clamp((time_ms - now_time) / (next_time - now_time), 0.0, 1.0));
+        }
+
+        self.Position = zm.vec.lerp(zm.Vec2f{ now.X, now.Y }, zm.Vec2f{ next.X, next.Y }, blend);
+    }
+
+    pub fn IsDown(self: *const ReplayPlayer, mask: u32) bool {
+        return (self.ButtonMask & mask) != 0;
+    }
+
+    pub fn GetFrameIndex(self: *const ReplayPlayer) usize {
+        return self.m_FrameIndex;
+    }
+
+    ///Returns the index of the last frame with Time <= _time_ms_ (or 0)
+    pub fn findFrameIndex(frames: []const ReplayFrame, time_ms: f64) usize {
+        var low: usize = 0;
+        var high: usize = frames.len;
+
+        while (low < high) {
+            const mid = low + (high - low) / 2;
+
+            if (@as(f64, @floatFromInt(frames[mid].Time)) <= time_ms) {
+                low = mid + 1;
+            } else {
+                high = mid;
+            }
+        }
+
+        return if (low == 0) 0 else low - 1;
+    }
+};
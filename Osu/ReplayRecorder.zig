@@ -0,0 +1,195 @@
+//Records gameplay input into a replay
+
+//The game loop only ever pushes fixed size samples into a preallocated SPSC ring, that's a couple of atomic ops and a
+//copy and never allocates or blocks. A background thread drains the ring into the frame list, and once the map is over
+//Finish turns the frames into a Replay that can be written out as .osr.
+
+const std = @import("std");
+
+const SpscRing = @import("../RingBuffer.zig").SpscRing;
+
+const Beatmap = @import("OsuParser.zig").Beatmap;
+const Replay = @import("ReplayParser.zig").Replay;
+const ReplayFrame = @import("ReplayParser.zig").ReplayFrame;
+const ReplayJudge = @import("ReplayJudge.zig");
+
+pub const InputSample = struct {
+    ///Map time in ms
+    Time: f64,
+    ///osu pixels
+    X: f32,
+    Y: f32,
+    ButtonMask: u32,
+};
+
+///Gets every batch of new frames on the recorder's consumer thread (never the game thread).
+///_frames_ is everything recorded so far, the new ones start at _new_from_.
+pub const FrameSink = struct {
+    Context: *anyopaque,
+    OnFrames: *const fn (context: *anyopaque, frames: []const ReplayFrame, new_from: usize) void,
+};
+
+pub const ReplayRecorder = struct {
+    //A few seconds of 1000hz mouse input even if the consumer thread gets starved
+    const RING_CAPACITY: usize = 8192;
+    const DRAIN_INTERVAL_NS: u64 = 2 * std.time.ns_per_ms;
+    //Roughly what a high polling rate mouse produces, the list can still grow but shouldn't need to
+    const RESERVED_FRAMES_PER_SECOND: u64 = 1000;
+
+    //Shows up as the game version in the .osr, new enough that osu! reads it as a modern replay
+    const GAME_VERSION: u32 = 20250101;
+    //.NET ticks at the unix epoch, .osr timestamps are windows ticks
+    const UNIX_EPOCH_TICKS: u64 = 621_355_968_000_000_000;
+
+    m_Ring: SpscRing(InputSample),
+    m_Frames: std.ArrayList(ReplayFrame),
+    m_Thread: ?std.Thread = null,
+    m_Running: std.atomic.Value(bool) = std.atomic.Value(bool).init(true),
+    m_Dropped: std.atomic.Value(u32) = std.atomic.Value(u32).init(0),
+    m_LastTime: u64 = 0,
+    m_Sink: ?FrameSink = null,
+    m_Allocator: std.mem.Allocator,
+
+    ///Starts the consumer thread, _expected_duration_ms_ is used to size the frame list up front
+    pub fn Start(allocator: std.mem.Allocator, expected_duration_ms: u64, sink: ?FrameSink) !*ReplayRecorder {
+        const self = try allocator.create(ReplayRecorder);
+        errdefer allocator.destroy(self);
+
+        var ring = try SpscRing(InputSample).Init(allocator, RING_CAPACITY);
+        errdefer ring.Deinit();
+
+        var frames = try std.ArrayList(ReplayFrame).initCapacity(allocator, expected_duration_ms * RESERVED_FRAMES_PER_SECOND / 1000);
+        errdefer frames.deinit();
+
+        //The thread gets _self_, so it has to be filled in first. Nothing else has it if spawning fails.
+        self.* = .{
+            .m_Ring = ring,
+            .m_Frames = frames,
+            .m_Sink = sink,
+            .m_Allocator = allocator,
+        };
+
+        self.m_Thread = try std.Thread.spawn(.{}, consumerLoop, .{self});
+
+        return self;
+    }
+
+    ///Game thread only. Never blocks, if the ring is full the sample is dropped and counted
+    pub inline fn Push(self: *ReplayRecorder, sample: InputSample) void {
+        if (!self.m_Ring.Push(sample)) {
+            _ = self.m_Dropped.fetchAdd(1, .monotonic);
+        }
+    }
+
+    pub fn GetDroppedCount(self: *const ReplayRecorder) u32 {
+        return self.m_Dropped.load(.monotonic);
+    }
+
+    ///Stops recording and builds the replay, filling in the hit counts by judging the recorded input against _beatmap_.
+    ///The replay is allocated with the recorder's allocator and owned by the caller.
+    pub fn Finish(self: *ReplayRecorder, beatmap: *const Beatmap, mods: u32, player_name: []const u8) !Replay {
+        self.stop();
+
+        const allocator = self.m_Allocator;
+
+        const frames = self.m_Frames;
+        self.m_Frames = std.ArrayList(ReplayFrame).init(allocator);
+        errdefer frames.deinit();
+
+        var judge_beatmap = try ReplayJudge.JudgeBeatmap.Init(allocator, beatmap);
+        defer judge_beatmap.Deinit();
+
+        const result = try ReplayJudge.JudgeReplay(allocator, &judge_beatmap, frames.items, mods);
+
+        var replay_md5_digest: [std.crypto.hash.Md5.digest_length]u8 = undefined;
+        std.crypto.hash.Md5.hash(std.mem.sliceAsBytes(frames.items), &replay_md5_digest, .{});
+        const replay_md5 = std.fmt.bytesToHex(replay_md5_digest, .lower);
+
+        const unix_ms: u64 = @intCast(@max(0, std.time.milliTimestamp()));
+
+        if (self.GetDroppedCount() > 0) {
+            std.debug.print("ReplayRecorder: dropped {d} input samples\n", .{self.GetDroppedCount()});
+        }
+
+        return .{
+            .m_Allocator = allocator,
+            .ReplayFrames = frames,
+            .ReplayInfo = .{
+                .GameMode = 0,
+                .GameVersion = GAME_VERSION,
+                .BeatmapMD5Hash = try allocator.dupe(u8, &beatmap.MD5Hash),
+                .PlayerName = try allocator.dupe(u8, player_name),
+                .ReplayMD5Hash = try allocator.dupe(u8, &replay_md5),
+                .Count300 = @intCast(@min(result.Count300, std.math.maxInt(u16))),
+                .Count100 = @intCast(@min(result.Count100, std.math.maxInt(u16))),
+                .Count50 = @intCast(@min(result.Count50, std.math.maxInt(u16))),
+                .CountGeki = 0,
+                .CountKatu = 0,
+                .CountMiss = @intCast(@min(result.CountMiss, std.math.maxInt(u16))),
+                .TotalScore = @intCast(@min(result.TotalScore, std.math.maxInt(u32))),
+                .HighestCombo = @intCast(@min(result.MaxCombo, std.math.maxInt(u16))),
+                .FullCombo = result.CountMiss == 0,
+                .Mods = mods,
+                .Lifebar = try allocator.dupe(u8, ""),
+                .Timestamp = unix_ms * 10_000 + UNIX_EPOCH_TICKS,
+                .OnlineScoreID = 0,
+            },
+        };
+    }
+
+    ///Stops the thread if it's still running and frees the recorder itself
+    pub fn Deinit(self: *ReplayRecorder) void {
+        self.stop();
+
+        self.m_Frames.deinit();
+        self.m_Ring.Deinit();
+        self.m_Allocator.destroy(self);
+    }
+
+    fn stop(self: *ReplayRecorder) void {
+        if (self.m_Thread) |thread| {
+            self.m_Running.store(false, .release);
+            thread.join();
+            self.m_Thread = null;
+        }
+    }
+
+    fn consumerLoop(self: *ReplayRecorder) void {
+        while (self.m_Running.load(.acquire)) {
+            self.drain();
+            std.Thread.sleep(DRAIN_INTERVAL_NS);
+        }
+
+        //Whatever got pushed before the stop
+        self.drain();
+    }
+
+    fn drain(self: *ReplayRecorder) void {
+        const first_new = self.m_Frames.items.len;
+
+        while (self.m_Ring.Pop()) |sample| {
+            //.osr frame times are whole ms and can't go backwards
+            const sample_time: u64 = if (sample.Time > 0.0) @intFromFloat(sample.Time) else 0;
+            const time = @max(sample_time, self.m_LastTime);
+
+            self.m_Frames.append(.{
+                .Time = time,
+                .Delta = time - self.m_LastTime,
+                .X = sample.X,
+                .Y = sample.Y,
+                .ButtonMask = sample.ButtonMask,
+            }) catch {
+                _ = self.m_Dropped.fetchAdd(1, .monotonic);
+                continue;
+            };
+
+            self.m_LastTime = time;
+        }
+
+        if (self.m_Sink) |sink| {
+            if (self.m_Frames.items.len > first_new) {
+                sink.OnFrames(sink.Context, self.m_Frames.items, first_new);
+            }
+        }
+    }
+};
@@ -1,6 +1,7 @@
 const std = @import("std");
 
 const Texture = @import("../Easy2D/Texture.zig").Texture;
+const zm = @import("zm");
 
 pub const OsuTexture = struct {
     BackingTexture: Texture,
@@ -16,20 +17,35 @@ pub const SUPPORTED_EXTENSIONS = [_][]const u8{
     ".jpeg",
 };
 
+///The slider ball and everything drawn along a slider, packed in one texture so a slider's decorations share a
+///texture slot in the Graphics batch. The rects are texture rects in it.
+pub const SliderSheet = struct {
+    Texture: Texture,
+    Ball: zm.Vec4f,
+    ReverseArrow: zm.Vec4f,
+    FollowCircle: zm.Vec4f,
+    //No sliderscorepoint in the default skin, ticks are the dot texture
+    Tick: zm.Vec4f,
+};
+
 var _dotTexture: ?Texture = null;
 const _dotTextureData = @embedFile("../textures/circle.png");
 pub const Skin = struct {
     ApproachCircle: OsuTexture,
     HitCircle: OsuTexture,
     HitCircleOverlay: OsuTexture,
-    SliderBall: OsuTexture,
+    Slider: SliderSheet,
+    Cursor: OsuTexture,
+    CursorTrail: OsuTexture,
     DotTexture: *const Texture,
 
     pub fn LoadFromFolder(folder_path: []const u8) Skin {
         const approach_circle = loadOsuTexture(folder_path, "approachcircle") catch unreachable;
         const hit_circle = loadOsuTexture(folder_path, "hitcircle") catch unreachable;
         const hit_circle_overlay = loadOsuTexture(folder_path, "hitcircleoverlay") catch unreachable;
-        const sliderball = loadOsuTexture(folder_path, "sliderb0") catch unreachable;
+        const slider_sheet = loadSliderSheet(folder_path) catch unreachable;
+        const cursor = loadOsuTexture(folder_path, "cursor") catch unreachable;
+        const cursor_trail = loadOsuTexture(folder_path, "cursortrail") catch unreachable;
 
         if (_dotTexture == null) {
             _dotTexture = Texture.Init(_dotTextureData) catch unreachable;
@@ -40,11 +56,60 @@ pub const Skin = struct {
             .HitCircle = hit_circle,
             .HitCircleOverlay = hit_circle_overlay,
             .DotTexture = &_dotTexture.?,
-            .SliderBall = sliderball,
+            .Slider = slider_sheet,
+            .Cursor = cursor,
+            .CursorTrail = cursor_trail,
         };
     }
 
     fn loadOsuTexture(folder_path: []const u8, name_no_extension: []const u8) !OsuTexture {
+        const skin_file = try loadSkinFile(folder_path, name_no_extension);
+        defer std.heap.c_allocator.free(skin_file.Data);
+
+        return .{
+            .BackingTexture = try Texture.Init(skin_file.Data),
+            .Is2X = skin_file.Is2X,
+        };
+    }
+
+    fn loadSliderSheet(folder_path: []const u8) !SliderSheet {
+        const names = [_][]const u8{ "sliderb0", "reversearrow", "sliderfollowcircle" };
+
+        var file_datas: [names.len + 1][]const u8 = undefined;
+        var loaded: usize = 0;
+        defer {
+            for (file_datas[0..loaded]) |file_data| {
+                std.heap.c_allocator.free(file_data);
+            }
+        }
+
+        for (names, 0..) |name, i| {
+            file_datas[i] = (try loadSkinFile(folder_path, name)).Data;
+            loaded += 1;
+        }
+
+        //Embedded, not ours to free
+        file_datas[names.len] = _dotTextureData;
+
+        var rects: [names.len + 1]zm.Vec4f = undefined;
+        const texture = try Texture.InitSheet(std.heap.c_allocator, &file_datas, &rects);
+
+        return .{
+            .Texture = texture,
+            .Ball = rects[0],
+            .ReverseArrow = rects[1],
+            .FollowCircle = rects[2],
+            .Tick = rects[3],
+        };
+    }
+
+    const SkinFile = struct {
+        ///Owned by the caller, c_allocator
+        Data: []u8,
+        Is2X: bool,
+    };
+
+    fn loadSkinFile(folder_path: []const u8, name_no_extension: []const u8) !SkinFile {
         //First loop through all files looking for each extension with the 2X tag, after that do the same but without
         //TODO: if texture can't be found load some kind of error texture.
 
@@ -79,12 +144,11 @@ pub const Skin = struct {
             //const file = std.fs.openFileAbsolute(file_path, .{}) catch continue;
             //how about not allocating this everytime a file is loaded xd
             const fileData = try file.readToEndAlloc(std.heap.c_allocator, 50000000);
-            defer std.heap.c_allocator.free(fileData);
 
             const is_2x = extension[0] == '@';
 
             return .{
-                .BackingTexture = try Texture.Init(fileData),
+                .Data = fileData,
                 .Is2X = is_2x,
             };
         }
@@ -0,0 +1,531 @@
+//Slider bodies packed into a few big depth textures, or luminance textures for distance field bodies, or colour
+//textures for bodies that are snaking
+//Every slider used to get its own texture and FBO which were never deleted, and every body drawn was a texture switch
+//for Graphics. Here bodies are regions of shared pages handed out by a shelf allocator: a page is split into horizontal
+//shelves, a region goes on the shortest shelf it fits on or opens a new one at the bottom. Freed regions are reclaimed
+//from the end of their shelf, an empty shelf can be reused by any region that fits and empty shelves at the bottom of a
+//page are given back to it.
+//Depth and colour pages are rendered into through an FBO, distance pages are only ever uploaded to (see
+//SliderDistanceField).
+
+const std = @import("std");
+
+const c = @import("../CImports.zig").c;
+const Texture = @import("../Easy2D/Texture.zig").Texture;
+const Viewport = @import("../Easy2D/Viewport.zig").Viewport;
+const zm = @import("zm");
+
+pub const SliderAtlas = struct {
+    const MAX_PAGE_SIZE: i32 = 2048;
+    const MAX_PAGES: usize = 3;
+    //Empty texels between regions so linear filtering never picks up a neighbour
+    const PADDING: i32 = 2;
+    //Shelf heights are rounded up to this so bodies of similar size can share shelves
+    const SHELF_GRANULARITY: i32 = 16;
+    //A region only goes on a shelf up to this many times its own height, unless nothing else fits
+    const MAX_SHELF_WASTE: i32 = 2;
+    //Written around a distance region on upload, see Upload
+    const OUTSIDE_ROW = [_]u8{255} ** MAX_PAGE_SIZE;
+
+    pub const Format = enum {
+        ///GL_DEPTH_COMPONENT pages with an FBO each, needs OES_depth_texture
+        Depth,
+        ///GL_LUMINANCE pages filled from the CPU
+        Distance,
+        ///GL_RGBA pages with an FBO and a depth renderbuffer each, the body's depth is written out as colour. Works
+        ///without OES_depth_texture.
+        Color,
+    };
+
+    pub const Region = struct {
+        Page: u8,
+        X: i32,
+        Y: i32,
+        Width: i32,
+        Height: i32,
+        m_Shelf: u16,
+
+        ///Texture coordinates of the region in its page, as x, y, width, height for Graphics
+        pub fn GetTextureRect(self: *const Region, page_size: i32) zm.Vec4f {
+            const size: f32 = @floatFromInt(page_size);
+            return .{
+                @as(f32, @floatFromInt(self.X)) / size,
+                @as(f32, @floatFromInt(self.Y)) / size,
+                @as(f32, @floatFromInt(self.Width)) / size,
+                @as(f32, @floatFromInt(self.Height)) / size,
+            };
+        }
+    };
+
+    const Shelf = struct {
+        Y: i32,
+        Height: i32,
+        //Next free x
+        Used: i32 = 0,
+        Live: u32 = 0,
+    };
+
+    const Page = struct {
+        Texture: Texture,
+        //0 for distance pages
+        FBO: c_uint,
+        //Only colour pages have one
+        DepthBuffer: c_uint = 0,
+        Shelves: std.ArrayList(Shelf),
+        //Where the next shelf opens
+        Top: i32 = 0,
+    };
+
+    m_Pages: std.ArrayList(Page),
+    m_Format: Format,
+    m_PageSize: i32 = 0,
+    m_Allocator: std.mem.Allocator,
+    m_SavedViewportPosition: zm.vec.Vec(2, i32) = .{ 0, 0 },
+    m_SavedViewportSize: zm.vec.Vec(2, i32) = .{ 0, 0 },
+    //Regions handed out and not freed yet, and their texels without the padding
+    m_LiveRegions: usize = 0,
+    m_LiveTexels: usize = 0,
+    //Pages without textures or FBOs, see InitHeadless
+    m_Headless: bool = false,
+
+    pub fn Init(allocator: std.mem.Allocator, format: Format) SliderAtlas {
+        return .{
+            .m_Pages = std.ArrayList(Page).init(allocator),
+            .m_Format = format,
+            .m_Allocator = allocator,
+        };
+    }
+
+    ///_pages_ pages of _page_size_ with no GL objects behind them, only the shelf allocator works. For the tests.
+    pub fn InitHeadless(allocator: std.mem.Allocator, format: Format, page_size: i32, pages: usize) !SliderAtlas {
+        var atlas = Init(allocator, format);
+        errdefer atlas.Deinit();
+
+        atlas.m_PageSize = page_size;
+        atlas.m_Headless = true;
+
+        for (0..pages) |_| {
+            try atlas.m_Pages.append(.{
+                .Texture = std.mem.zeroes(Texture),
+                .FBO = 0,
+                .Shelves = std.ArrayList(Shelf).init(allocator),
+            });
+        }
+
+        return atlas;
+    }
+
+    pub fn Deinit(self: *SliderAtlas) void {
+        for (self.m_Pages.items) |*page| {
+            self.deinitPage(page);
+        }
+
+        self.m_Pages.deinit();
+    }
+
+    pub fn GetFormat(self: *const SliderAtlas) Format {
+        return self.m_Format;
+    }
+
+    ///Width and height of every page, 0 before the atlas is first used
+    pub fn GetPageSize(self: *const SliderAtlas) i32 {
+        return self.m_PageSize;
+    }
+
+    pub fn GetPageTexture(self: *const SliderAtlas, page: u8) *const Texture {
+        return &self.m_Pages.items[page].Texture;
+    }
+
+    pub fn GetLiveRegionCount(self: *const SliderAtlas) usize {
+        return self.m_LiveRegions;
+    }
+
+    ///Video memory the live regions take up, the depth renderbuffer of a colour page included
+    pub fn GetLiveBytes(self: *const SliderAtlas) usize {
+        return self.m_LiveTexels * self.bytesPerTexel();
+    }
+
+    ///Video memory of all pages, used or not
+    pub fn GetPageBytes(self: *const SliderAtlas) usize {
+        const page_size: usize = @intCast(self.m_PageSize);
+        return self.m_Pages.items.len * page_size * page_size * self.bytesPerTexel();
+    }
+
+    ///Largest region Allocate can hand out on either axis, bigger bodies have to be rendered scaled down
+    pub fn GetMaxRegionSize(self: *SliderAtlas) i32 {
+        self.ensurePageSize();
+        return self.m_PageSize - PADDING;
+    }
+
+    ///A _width_ x _height_ region on one of the existing pages, null if none has room (see AddPage)
+    pub fn Allocate(self: *SliderAtlas, width: i32, height: i32) ?Region {
+        self.ensurePageSize();
+
+        const padded_width = width + PADDING;
+        const padded_height = height + PADDING;
+
+        if (width <= 0 or height <= 0 or padded_width > self.m_PageSize or padded_height > self.m_PageSize)
+            return null;
+
+        //Best fitting existing shelf that doesn't waste too much height, then a new shelf, then any shelf at all
+        if (self.findShelf(padded_width, padded_height, padded_height * MAX_SHELF_WASTE)) |found| {
+            return self.place(found[0], found[1], width, height);
+        }
+
+        const shelf_height = @min(@divFloor(padded_height + SHELF_GRANULARITY - 1, SHELF_GRANULARITY) * SHELF_GRANULARITY, self.m_PageSize);
+
+        for (self.m_Pages.items, 0..) |*page, page_index| {
+            if (page.Top + shelf_height > self.m_PageSize)
+                continue;
+
+            page.Shelves.append(.{ .Y = page.Top, .Height = shelf_height }) catch return null;
+            page.Top += shelf_height;
+
+            return self.place(page_index, page.Shelves.items.len - 1, width, height);
+        }
+
+        if (self.findShelf(padded_width, padded_height, std.math.maxInt(i32))) |found| {
+            return self.place(found[0], found[1], width, height);
+        }
+
+        return null;
+    }
+
+    ///Gives _region_ back, its contents may be overwritten from now on
+    pub fn Free(self: *SliderAtlas, region: Region) void {
+        const page = &self.m_Pages.items[region.Page];
+        const shelf = &page.Shelves.items[region.m_Shelf];
+
+        shelf.Live -= 1;
+        self.m_LiveRegions -= 1;
+        self.m_LiveTexels -= @intCast(region.Width * region.Height);
+
+        if (shelf.Live == 0) {
+            shelf.Used = 0;
+        } else if (region.X + region.Width + PADDING == shelf.Used) {
+            shelf.Used = region.X;
+        }
+
+        //Empty shelves at the bottom go back to the page so they can be reopened at another height
+        while (page.Shelves.items.len > 0 and page.Shelves.items[page.Shelves.items.len - 1].Live == 0) {
+            page.Top = page.Shelves.pop().?.Y;
+        }
+    }
+
+    ///Adds an empty page, fails once there are MAX_PAGES
+    pub fn AddPage(self: *SliderAtlas) !void {
+        if (self.m_Pages.items.len >= MAX_PAGES)
+            return error.AtlasFull;
+
+        self.ensurePageSize();
+
+        if (self.m_Format == .Distance) {
+            //Never sampled outside of uploaded regions and their border, so it can start out undefined
+            var texture = try Texture.Init2(c.GL_TEXTURE_2D, self.m_PageSize, self.m_PageSize, c.GL_LUMINANCE, c.GL_LUMINANCE, c.GL_UNSIGNED_BYTE);
+            errdefer texture.Deinit();
+
+            try self.m_Pages.append(.{
+                .Texture = texture,
+                .FBO = 0,
+                .Shelves = std.ArrayList(Shelf).init(self.m_Allocator),
+            });
+
+            std.debug.print("Slider atlas: distance page {d} ({d}x{d})\n", .{ self.m_Pages.items.len, self.m_PageSize, self.m_PageSize });
+            return;
+        }
+
+        var texture = if (self.m_Format == .Color)
+            try Texture.Init2(c.GL_TEXTURE_2D, self.m_PageSize, self.m_PageSize, c.GL_RGBA, c.GL_RGBA, c.GL_UNSIGNED_BYTE)
+        else
+            try Texture.Init2(c.GL_TEXTURE_2D, self.m_PageSize, self.m_PageSize, c.GL_DEPTH_COMPONENT, c.GL_DEPTH_COMPONENT, c.GL_UNSIGNED_SHORT);
+        errdefer texture.Deinit();
+
+        var fbo: c_uint = undefined;
+        c.glGenFramebuffers(1, &fbo);
+        errdefer c.glDeleteFramebuffers(1, &fbo);
+
+        var depth_buffer: c_uint = 0;
+        errdefer if (depth_buffer != 0) c.glDeleteRenderbuffers(1, &depth_buffer);
+
+        c.glBindFramebuffer(c.GL_FRAMEBUFFER, fbo);
+
+        if (self.m_Format == .Color) {
+            c.glGenRenderbuffers(1, &depth_buffer);
+            c.glBindRenderbuffer(c.GL_RENDERBUFFER, depth_buffer);
+            c.glRenderbufferStorage(c.GL_RENDERBUFFER, c.GL_DEPTH_COMPONENT16, self.m_PageSize, self.m_PageSize);
+            c.glBindRenderbuffer(c.GL_RENDERBUFFER, 0);
+
+            c.glFramebufferTexture2D(c.GL_FRAMEBUFFER, c.GL_COLOR_ATTACHMENT0, texture.target, texture.id, 0);
+            c.glFramebufferRenderbuffer(c.GL_FRAMEBUFFER, c.GL_DEPTH_ATTACHMENT, c.GL_RENDERBUFFER, depth_buffer);
+        } else {
+            c.glFramebufferTexture2D(c.GL_FRAMEBUFFER, c.GL_DEPTH_ATTACHMENT, texture.target, texture.id, 0);
+        }
+
+        const fbo_status = c.glCheckFramebufferStatus(c.GL_FRAMEBUFFER);
+        c.glBindFramebuffer(c.GL_FRAMEBUFFER, 0);
+
+        if (fbo_status != c.GL_FRAMEBUFFER_COMPLETE) {
+            std.debug.print("ERROR::FBO:: Slider atlas framebuffer is not complete!\n", .{});
+            return error.FramebufferIncomplete;
+        }
+
+        //Start out cleared so nothing unrendered shows up as slider body
+        c.glBindFramebuffer(c.GL_FRAMEBUFFER, fbo);
+        self.clearBody();
+        c.glBindFramebuffer(c.GL_FRAMEBUFFER, 0);
+
+        try self.m_Pages.append(.{
+            .Texture = texture,
+            .FBO = fbo,
+            .DepthBuffer = depth_buffer,
+            .Shelves = std.ArrayList(Shelf).init(self.m_Allocator),
+        });
+
+        std.debug.print("Slider atlas: {s} page {d} ({d}x{d})\n", .{ if (self.m_Format == .Color) "colour" else "depth", self.m_Pages.items.len, self.m_PageSize, self.m_PageSize });
+    }
+
+    ///Deletes the empty pages at the end, regions refer to pages by index so ones in the middle have to stay. Returns
+    ///how many were deleted.
+    pub fn ReleaseEmptyPages(self: *SliderAtlas) usize {
+        var released: usize = 0;
+
+        while (self.m_Pages.items.len > 0 and self.m_Pages.items[self.m_Pages.items.len - 1].Shelves.items.len == 0) {
+            var page = self.m_Pages.pop().?;
+            self.deinitPage(&page);
+            released += 1;
+        }
+
+        if (released > 0)
+            std.debug.print("Slider atlas: released {d} pages, {d} left\n", .{ released, self.m_Pages.items.len });
+
+        return released;
+    }
+
+    ///Binds _region_'s page and limits rendering and clears to the region, which is cleared. Ends with EndRender.
+    ///On a colour page blending is off in between, the depth has to land as it is.
+    pub fn BeginRender(self: *SliderAtlas, region: Region) void {
+        std.debug.assert(self.m_Format != .Distance);
+
+        self.m_SavedViewportPosition = Viewport.GetPosition();
+        self.m_SavedViewportSize = Viewport.GetSize();
+
+        c.glBindFramebuffer(c.GL_FRAMEBUFFER, self.m_Pages.items[region.Page].FBO);
+
+        Viewport.SetViewport(region.X, region.Y, region.Width, region.Height);
+        c.glEnable(c.GL_SCISSOR_TEST);
+        self.clearBody();
+
+        if (self.m_Format == .Color)
+            c.glDisable(c.GL_BLEND);
+    }
+
+    pub fn EndRender(self: *SliderAtlas) void {
+        if (self.m_Format == .Color)
+            c.glEnable(c.GL_BLEND);
+
+        c.glDisable(c.GL_SCISSOR_TEST);
+        c.glBindFramebuffer(c.GL_FRAMEBUFFER, 0);
+
+        Viewport.SetViewport(self.m_SavedViewportPosition[0], self.m_SavedViewportPosition[1], self.m_SavedViewportSize[0], self.m_SavedViewportSize[1]);
+    }
+
+    ///Copies _pixels_ (one byte per texel, rows tightly packed) into _region_ of a distance page. The texels around the
+    ///region are set to outside the body too: they're in the padding of this region or of its neighbours, but a freed
+    ///region may have left a body there that linear filtering would pick up at the edge.
+    pub fn Upload(self: *SliderAtlas, region: Region, pixels: []const u8) void {
+        std.debug.assert(self.m_Format == .Distance);
+        std.debug.assert(pixels.len >= @as(usize, @intCast(region.Width * region.Height)));
+
+        const page = &self.m_Pages.items[region.Page];
+
+        page.Texture.Bind(0);
+        c.glPixelStorei(c.GL_UNPACK_ALIGNMENT, 1);
+
+        c.glTexSubImage2D(page.Texture.target, 0, region.X, region.Y, region.Width, region.Height, c.GL_LUMINANCE, c.GL_UNSIGNED_BYTE, pixels.ptr);
+
+        //Left and top only when not on the page edge, right and bottom always land in the region's own padding
+        const left = @max(region.X - 1, 0);
+        const top = @max(region.Y - 1, 0);
+        const right = region.X + region.Width;
+        const bottom = region.Y + region.Height;
+
+        c.glTexSubImage2D(page.Texture.target, 0, left, bottom, right + 1 - left, 1, c.GL_LUMINANCE, c.GL_UNSIGNED_BYTE, &OUTSIDE_ROW);
+        c.glTexSubImage2D(page.Texture.target, 0, right, top, 1, bottom - top, c.GL_LUMINANCE, c.GL_UNSIGNED_BYTE, &OUTSIDE_ROW);
+
+        if (region.Y > 0)
+            c.glTexSubImage2D(page.Texture.target, 0, left, top, right + 1 - left, 1, c.GL_LUMINANCE, c.GL_UNSIGNED_BYTE, &OUTSIDE_ROW);
+
+        if (region.X > 0)
+            c.glTexSubImage2D(page.Texture.target, 0, left, top, 1, bottom - top, c.GL_LUMINANCE, c.GL_UNSIGNED_BYTE, &OUTSIDE_ROW);
+
+        c.glPixelStorei(c.GL_UNPACK_ALIGNMENT, 4);
+    }
+
+    //Depth 1.0 is outside the body, a colour page holds the same in its colour
+    fn clearBody(self: *const SliderAtlas) void {
+        if (self.m_Format != .Color) {
+            c.glClear(c.GL_DEPTH_BUFFER_BIT);
+            return;
+        }
+
+        var previous: [4]f32 = undefined;
+        c.glGetFloatv(c.GL_COLOR_CLEAR_VALUE, &previous);
+
+        c.glClearColor(1.0, 1.0, 1.0, 1.0);
+        c.glClear(c.GL_COLOR_BUFFER_BIT | c.GL_DEPTH_BUFFER_BIT);
+        c.glClearColor(previous[0], previous[1], previous[2], previous[3]);
+    }
+
+    fn bytesPerTexel(self: *const SliderAtlas) usize {
+        return switch (self.m_Format) {
+            //GL_UNSIGNED_SHORT
+            .Depth => 2,
+            .Distance => 1,
+            //RGBA8 plus GL_DEPTH_COMPONENT16
+            .Color => 6,
+        };
+    }
+
+    fn deinitPage(self: *const SliderAtlas, page: *Page) void {
+        defer page.Shelves.deinit();
+
+        if (self.m_Headless)
+            return;
+
+        if (page.FBO != 0)
+            c.glDeleteFramebuffers(1, &page.FBO);
+
+        if (page.DepthBuffer != 0)
+            c.glDeleteRenderbuffers(1, &page.DepthBuffer);
+
+        page.Texture.Deinit();
+    }
+
+    fn ensurePageSize(self: *SliderAtlas) void {
+        if (self.m_PageSize != 0)
+            return;
+
+        var max_texture_size: c.GLint = 0;
+        c.glGetIntegerv(c.GL_MAX_TEXTURE_SIZE, &max_texture_size);
+
+        self.m_PageSize = if (max_texture_size > 0) @min(MAX_PAGE_SIZE, max_texture_size) else MAX_PAGE_SIZE;
+    }
+
+    ///Page and shelf index of the lowest shelf between _padded_height_ and _max_height_ tall with room for _padded_width_
+    fn findShelf(self: *const SliderAtlas, padded_width: i32, padded_height: i32, max_height: i32) ?[2]usize {
+        var best: ?[2]usize = null;
+        var best_height: i32 = std.math.maxInt(i32);
+
+        for (self.m_Pages.items, 0..) |page, page_index| {
+            for (page.Shelves.items, 0..) |shelf, shelf_index| {
+                if (shelf.Height < padded_height or shelf.Height > max_height or shelf.Height >= best_height)
+                    continue;
+
+                if (shelf.Used + padded_width > self.m_PageSize)
+                    continue;
+
+                best = .{ page_index, shelf_index };
+                best_height = shelf.Height;
+            }
+        }
+
+        return best;
+    }
+
+    fn place(self: *SliderAtlas, page_index: usize, shelf_index: usize, width: i32, height: i32) Region {
+        const shelf = &self.m_Pages.items[page_index].Shelves.items[shelf_index];
+
+        const region = Region{
+            .Page = @intCast(page_index),
+            .X = shelf.Used,
+            .Y = shelf.Y,
+            .Width = width,
+            .Height = height,
+            .m_Shelf = @intCast(shelf_index),
+        };
+
+        shelf.Used += width + PADDING;
+        shelf.Live += 1;
+        self.m_LiveRegions += 1;
+        self.m_LiveTexels += @intCast(width * height);
+
+        return region;
+    }
+};
+
+test "regions share shelves of their height and free space is reclaimed from the end" {
+    var atlas = try SliderAtlas.InitHeadless(std.testing.allocator, .Depth, 256, 1);
+    defer atlas.Deinit();
+
+    //Padded to 32x22 on a shelf rounded up to 32
+    const a = atlas.Allocate(30, 20).?;
+    const b = atlas.Allocate(30, 20).?;
+    try std.testing.expectEqual(@as(i32, 0), a.X);
+    try std.testing.expectEqual(@as(i32, 32), b.X);
+    try std.testing.expectEqual(a.Y, b.Y);
+
+    //Too tall for the first shelf, too short for the second without wasting more than MAX_SHELF_WASTE
+    const tall = atlas.Allocate(30, 60).?;
+    const short = atlas.Allocate(10, 5).?;
+    try std.testing.expectEqual(@as(i32, 32), tall.Y);
+    try std.testing.expectEqual(@as(i32, 96), short.Y);
+    try std.testing.expectEqual(@as(i32, 112), atlas.m_Pages.items[0].Top);
+
+    //b was the last on its shelf, so its space goes back
+    atlas.Free(b);
+    const again = atlas.Allocate(30, 20).?;
+    try std.testing.expectEqual(b.X, again.X);
+    try std.testing.expectEqual(b.Y, again.Y);
+
+    //An empty shelf at the bottom goes back to the page
+    atlas.Free(short);
+    try std.testing.expectEqual(@as(i32, 96), atlas.m_Pages.items[0].Top);
+
+    try std.testing.expectEqual(@as(usize, 3), atlas.GetLiveRegionCount());
+    try std.testing.expectEqual(@as(usize, (30 * 20) * 2 + 30 * 60) * 2, atlas.GetLiveBytes());
+
+    atlas.Free(a);
+    atlas.Free(again);
+    atlas.Free(tall);
+
+    try std.testing.expectEqual(@as(i32, 0), atlas.m_Pages.items[0].Top);
+    try std.testing.expectEqual(@as(usize, 0), atlas.m_Pages.items[0].Shelves.items.len);
+    try std.testing.expectEqual(@as(usize, 0), atlas.GetLiveRegionCount());
+    try std.testing.expectEqual(@as(usize, 0), atlas.GetLiveBytes());
+}
+
+test "a region goes on any shelf it fits once the page has no room for a new one" {
+    var atlas = try SliderAtlas.InitHeadless(std.testing.allocator, .Distance, 64, 1);
+    defer atlas.Deinit();
+
+    _ = atlas.Allocate(10, 40).?;
+    const small = atlas.Allocate(10, 5).?;
+    try std.testing.expectEqual(@as(i32, 64), atlas.m_Pages.items[0].Top);
+
+    //Would open a shelf of its own if there was room, takes the lower of the two instead
+    const smaller = atlas.Allocate(10, 3).?;
+    try std.testing.expectEqual(small.Y, smaller.Y);
+    try std.testing.expectEqual(@as(i32, 12), smaller.X);
+}
+
+test "allocation moves on to the next page and fails when every page is full" {
+    var atlas = try SliderAtlas.InitHeadless(std.testing.allocator, .Depth, 256, 2);
+    defer atlas.Deinit();
+
+    try std.testing.expectEqual(@as(i32, 254), atlas.GetMaxRegionSize());
+    try std.testing.expect(atlas.Allocate(255, 10) == null);
+    try std.testing.expect(atlas.Allocate(0, 10) == null);
+
+    const first = atlas.Allocate(254, 254).?;
+    const second = atlas.Allocate(254, 254).?;
+    try std.testing.expectEqual(@as(u8, 0), first.Page);
+    try std.testing.expectEqual(@as(u8, 1), second.Page);
+    try std.testing.expect(atlas.Allocate(8, 8) == null);
+
+    //Only the emptied last page goes, the first one is still full
+    atlas.Free(second);
+    try std.testing.expectEqual(@as(usize, 1), atlas.ReleaseEmptyPages());
+    try std.testing.expect(atlas.Allocate(8, 8) == null);
+
+    atlas.Free(first);
+}
@@ -0,0 +1,334 @@
+//Content addressed cache of slider shapes
+//Mappers copy paste sliders a lot, a shape is the curve type, the control points relative to the head, the pixel length,
+//the circle size and the detail it's flattened with. Everything derived from those is the same for every copy up to a
+//translation, so the flattened path (stored relative to the head) and the rendered body texture are built once per
+//shape and shared. Bodies live in the slider atlas and are only evicted once no slider on screen uses them and the
+//atlas needs the room.
+
+const std = @import("std");
+const zm = @import("zm");
+
+const HitObject = @import("OsuParser.zig").HitObject;
+const HitSliderType = @import("OsuParser.zig").HitSliderType;
+const SliderCurvePoint = @import("OsuParser.zig").SliderCurvePoint;
+const SliderPath = @import("SliderPath.zig");
+const FlattenDetail = SliderPath.FlattenDetail;
+const SliderAtlas = @import("SliderAtlas.zig").SliderAtlas;
+
+pub const SliderShape = struct {
+    ///Flattened path relative to the slider head
+    Points: []const zm.Vec2f,
+    ///Rendered body in the slider atlas, null until a slider with this shape renders it or after it was evicted
+    Body: ?SliderAtlas.Region = null,
+    ///Screen pixels per osu pixel Body was rendered at
+    BodyScale: f32 = 0.0,
+    ///Same for the distance field body, which lives in a distance atlas of its own
+    DistanceBody: ?SliderAtlas.Region = null,
+    DistanceBodyScale: f32 = 0.0,
+
+    //The key itself, compared on lookup so a hash collision can't hand out the wrong shape
+    m_Type: HitSliderType,
+    m_PixelLength: f32,
+    m_CircleSize: f32,
+    m_Detail: FlattenDetail,
+    m_ControlPoints: []const SliderCurvePoint,
+    //Shapes sharing a hash
+    m_Next: ?*SliderShape = null,
+    //Sliders currently using this shape, see SliderCurveCache.Release
+    m_Users: u32 = 0,
+
+    fn matches(self: *const SliderShape, hit_object: *const HitObject, circle_size: f32, detail: FlattenDetail) bool {
+        const slider = &hit_object.HitSlider.?;
+
+        if (self.m_Type != slider.Type or self.m_PixelLength != slider.PixelLength or self.m_CircleSize != circle_size)
+            return false;
+
+        if (!std.meta.eql(self.m_Detail, detail))
+            return false;
+
+        if (self.m_ControlPoints.len != slider.CurvePoints.items.len)
+            return false;
+
+        for (self.m_ControlPoints, slider.CurvePoints.items) |relative, point| {
+            if (relative.X != point.X - hit_object.X or relative.Y != point.Y - hit_object.Y)
+                return false;
+        }
+
+        return true;
+    }
+};
+
+pub const SliderCurveCache = struct {
+    m_Shapes: std.AutoHashMap(u64, *SliderShape),
+    m_Allocator: std.mem.Allocator,
+    m_Hits: u32 = 0,
+    m_Misses: u32 = 0,
+
+    pub fn Init(allocator: std.mem.Allocator) SliderCurveCache {
+        return .{
+            .m_Shapes = std.AutoHashMap(u64, *SliderShape).init(allocator),
+            .m_Allocator = allocator,
+        };
+    }
+
+    ///Frees every shape, nothing handed out by Get can be used afterwards. Bodies are left to the atlas.
+    pub fn Deinit(self: *SliderCurveCache) void {
+        var iterator = self.m_Shapes.valueIterator();
+        while (iterator.next()) |first| {
+            var shape: ?*SliderShape = first.*;
+
+            while (shape) |current| {
+                shape = current.m_Next;
+
+                self.m_Allocator.free(current.Points);
+                self.m_Allocator.free(current.m_ControlPoints);
+                self.m_Allocator.destroy(current);
+            }
+        }
+
+        self.m_Shapes.deinit();
+    }
+
+    ///The shape of _hit_object_ (a slider), flattening it with _detail_ if no slider with the same shape was seen before.
+    ///_flattened_ is the slider's path if it was already flattened with _detail_ (in osu pixels, not relative to the
+    ///head), it's copied instead of flattening again. The returned shape lives as long as the cache, every Get has to be
+    ///matched by a Release once the slider is gone so its body can be evicted.
+    pub fn Get(self: *SliderCurveCache, hit_object: *const HitObject, circle_size: f32, detail: FlattenDetail, flattened: ?[]const zm.Vec2f) !*SliderShape {
+        const hash = hashShape(hit_object, circle_size, detail);
+
+        const entry = try self.m_Shapes.getOrPut(hash);
+
+        if (entry.found_existing) {
+            var shape: ?*SliderShape = entry.value_ptr.*;
+
+            while (shape) |current| : (shape = current.m_Next) {
+                if (current.matches(hit_object, circle_size, detail)) {
+                    self.m_Hits += 1;
+                    current.m_Users += 1;
+                    return current;
+                }
+            }
+        }
+
+        self.m_Misses += 1;
+
+        errdefer if (!entry.found_existing) self.m_Shapes.removeByPtr(entry.key_ptr);
+
+        const shape = try self.build(hit_object, circle_size, detail, flattened);
+        shape.m_Next = if (entry.found_existing) entry.value_ptr.* else null;
+        entry.value_ptr.* = shape;
+
+        shape.m_Users += 1;
+        return shape;
+    }
+
+    pub fn Release(self: *SliderCurveCache, shape: *SliderShape) void {
+        _ = self;
+        shape.m_Users -= 1;
+    }
+
+    ///Gives the bodies of shapes no slider is using back to _atlas_, returns how many there were. Only the kind of body
+    ///_atlas_ holds is evicted.
+    pub fn EvictUnusedBodies(self: *SliderCurveCache, atlas: *SliderAtlas) usize {
+        var evicted: usize = 0;
+
+        var iterator = self.m_Shapes.valueIterator();
+        while (iterator.next()) |first| {
+            var shape: ?*SliderShape = first.*;
+
+            while (shape) |current| : (shape = current.m_Next) {
+                if (current.m_Users > 0)
+                    continue;
+
+                const body = switch (atlas.GetFormat()) {
+                    .Depth => &current.Body,
+                    .Distance => &current.DistanceBody,
+                    //Snaking bodies belong to their slider
+                    .Color => return 0,
+                };
+
+                if (body.*) |region| {
+                    atlas.Free(region);
+                    body.* = null;
+                    evicted += 1;
+                }
+            }
+        }
+
+        return evicted;
+    }
+
+    pub fn GetHitCount(self: *const SliderCurveCache) u32 {
+        return self.m_Hits;
+    }
+
+    pub fn GetMissCount(self: *const SliderCurveCache) u32 {
+        return self.m_Misses;
+    }
+
+    fn build(self: *SliderCurveCache, hit_object: *const HitObject, circle_size: f32, detail: FlattenDetail, flattened: ?[]const zm.Vec2f) !*SliderShape {
+        const allocator = self.m_Allocator;
+        const slider = &hit_object.HitSlider.?;
+
+        const points = if (flattened) |existing|
+            try allocator.dupe(zm.Vec2f, existing)
+        else
+            try SliderPath.BuildPointsDetailed(allocator, hit_object.*, detail);
+        errdefer allocator.free(points);
+
+        const head = zm.Vec2f{ @floatFromInt(hit_object.X), @floatFromInt(hit_object.Y) };
+        for (points) |*point| {
+            point.* -= head;
+        }
+
+        const control_points = try allocator.alloc(SliderCurvePoint, slider.CurvePoints.items.len);
+        errdefer allocator.free(control_points);
+
+        for (control_points, slider.CurvePoints.items) |*relative, point| {
+            relative.* = .{ .X = point.X - hit_object.X, .Y = point.Y - hit_object.Y };
+        }
+
+        const shape = try allocator.create(SliderShape);
+        shape.* = .{
+            .Points = points,
+            .m_Type = slider.Type,
+            .m_PixelLength = slider.PixelLength,
+            .m_CircleSize = circle_size,
+            .m_Detail = detail,
+            .m_ControlPoints = control_points,
+        };
+
+        return shape;
+    }
+
+    fn hashShape(hit_object: *const HitObject, circle_size: f32, detail: FlattenDetail) u64 {
+        const slider = &hit_object.HitSlider.?;
+
+        var hasher = std.hash.Wyhash.init(0);
+        hasher.update(std.mem.asBytes(&slider.Type));
+        hasher.update(std.mem.asBytes(&slider.PixelLength));
+        hasher.update(std.mem.asBytes(&circle_size));
+        hasher.update(std.mem.asBytes(&detail.Tolerance.Bezier));
+        hasher.update(std.mem.asBytes(&detail.Tolerance.CircularArc));
+        hasher.update(std.mem.asBytes(&detail.CatmullDetail));
+        hasher.update(std.mem.asBytes(&detail.Kernel));
+
+        for (slider.CurvePoints.items) |point| {
+            const relative = [2]i32{ point.X - hit_object.X, point.Y - hit_object.Y };
+            hasher.update(std.mem.asBytes(&relative));
+        }
+
+        return hasher.final();
+    }
+};
+
+fn testSlider(allocator: std.mem.Allocator, x: i32, y: i32, curve: []const SliderCurvePoint, pixel_length: f32) !HitObject {
+    var curve_points = std.ArrayList(SliderCurvePoint).init(allocator);
+    try curve_points.appendSlice(curve);
+
+    return .{
+        .X = x,
+        .Y = y,
+        .StartTime = 0,
+        .HitSoundSet = .{ .Bits = 0 },
+        .IsNewCombo = false,
+        .HitCircle = null,
+        .HitSlider = .{ .Type = .Linear, .CurvePoints = curve_points, .Slides = 1, .PixelLength = pixel_length, .EndTime = 0 },
+        .HitSpinner = null,
+    };
+}
+
+test "copies of a slider share one shape and different sliders don't" {
+    const allocator = std.testing.allocator;
+
+    var cache = SliderCurveCache.Init(allocator);
+    defer cache.Deinit();
+
+    var original = try testSlider(allocator, 10, 10, &.{.{ .X = 110, .Y = 10 }}, 100.0);
+    defer original.HitSlider.?.CurvePoints.deinit();
+    var copy = try testSlider(allocator, 200, 50, &.{.{ .X = 300, .Y = 50 }}, 100.0);
+    defer copy.HitSlider.?.CurvePoints.deinit();
+    var shorter = try testSlider(allocator, 10, 10, &.{.{ .X = 110, .Y = 10 }}, 80.0);
+    defer shorter.HitSlider.?.CurvePoints.deinit();
+
+    const flattened = [_]zm.Vec2f{ .{ 10.0, 10.0 }, .{ 110.0, 10.0 } };
+
+    const shape = try cache.Get(&original, 4.0, .{}, &flattened);
+    try std.testing.expectEqualSlices(zm.Vec2f, &.{ .{ 0.0, 0.0 }, .{ 100.0, 0.0 } }, shape.Points);
+
+    try std.testing.expectEqual(shape, try cache.Get(&copy, 4.0, .{}, null));
+    try std.testing.expect(shape != try cache.Get(&shorter, 4.0, .{}, null));
+    try std.testing.expect(shape != try cache.Get(&original, 5.0, .{}, &flattened));
+    try std.testing.expect(shape != try cache.Get(&original, 4.0, .{ .CatmullDetail = 10 }, &flattened));
+
+    try std.testing.expectEqual(@as(u32, 1), cache.GetHitCount());
+    try std.testing.expectEqual(@as(u32, 4), cache.GetMissCount());
+    try std.testing.expectEqual(@as(u32, 2), shape.m_Users);
+}
+
+test "shapes sharing a hash are told apart by their key" {
+    const allocator = std.testing.allocator;
+
+    var cache = SliderCurveCache.Init(allocator);
+    defer cache.Deinit();
+
+    var first = try testSlider(allocator, 0, 0, &.{.{ .X = 100, .Y = 0 }}, 100.0);
+    defer first.HitSlider.?.CurvePoints.deinit();
+    var second = try testSlider(allocator, 0, 0, &.{.{ .X = 0, .Y = 100 }}, 100.0);
+    defer second.HitSlider.?.CurvePoints.deinit();
+
+    const first_flattened = [_]zm.Vec2f{ .{ 0.0, 0.0 }, .{ 100.0, 0.0 } };
+    const second_flattened = [_]zm.Vec2f{ .{ 0.0, 0.0 }, .{ 0.0, 100.0 } };
+
+    const first_shape = try cache.Get(&first, 4.0, .{}, &first_flattened);
+
+    //Fake a collision, the second slider's hash already leads to the first shape
+    try cache.m_Shapes.put(SliderCurveCache.hashShape(&second, 4.0, .{}), first_shape);
+
+    const second_shape = try cache.Get(&second, 4.0, .{}, &second_flattened);
+    try std.testing.expect(second_shape != first_shape);
+    try std.testing.expectEqual(first_shape, second_shape.m_Next.?);
+
+    try std.testing.expectEqual(second_shape, try cache.Get(&second, 4.0, .{}, null));
+    try std.testing.expectEqual(first_shape, try cache.Get(&first, 4.0, .{}, null));
+
+    //Both hashes lead to the first shape now, Deinit would free it twice
+    second_shape.m_Next = null;
+}
+
+test "only bodies of unused shapes of the atlas' kind are evicted" {
+    const allocator = std.testing.allocator;
+
+    var cache = SliderCurveCache.Init(allocator);
+    defer cache.Deinit();
+
+    var depth_atlas = try SliderAtlas.InitHeadless(allocator, .Depth, 256, 1);
+    defer depth_atlas.Deinit();
+    var distance_atlas = try SliderAtlas.InitHeadless(allocator, .Distance, 256, 1);
+    defer distance_atlas.Deinit();
+    var snake_atlas = try SliderAtlas.InitHeadless(allocator, .Color, 256, 1);
+    defer snake_atlas.Deinit();
+
+    var slider = try testSlider(allocator, 0, 0, &.{.{ .X = 100, .Y = 0 }}, 100.0);
+    defer slider.HitSlider.?.CurvePoints.deinit();
+
+    const flattened = [_]zm.Vec2f{ .{ 0.0, 0.0 }, .{ 100.0, 0.0 } };
+
+    const shape = try cache.Get(&slider, 4.0, .{}, &flattened);
+    shape.Body = depth_atlas.Allocate(64, 32).?;
+    shape.DistanceBody = distance_atlas.Allocate(32, 16).?;
+
+    try std.testing.expectEqual(@as(usize, 0), cache.EvictUnusedBodies(&depth_atlas));
+
+    cache.Release(shape);
+
+    try std.testing.expectEqual(@as(usize, 0), cache.EvictUnusedBodies(&snake_atlas));
+    try std.testing.expectEqual(@as(usize, 1), cache.EvictUnusedBodies(&depth_atlas));
+    try std.testing.expect(shape.Body == null);
+    try std.testing.expect(shape.DistanceBody != null);
+    try std.testing.expectEqual(@as(usize, 0), depth_atlas.GetLiveRegionCount());
+
+    try std.testing.expectEqual(@as(usize, 1), cache.EvictUnusedBodies(&distance_atlas));
+    try std.testing.expect(shape.DistanceBody == null);
+    try std.testing.expectEqual(@as(usize, 0), cache.EvictUnusedBodies(&distance_atlas));
+}
@@ -0,0 +1,131 @@
+//Slider bodies as a distance field computed on the CPU
+//The offscreen body is a cone mesh rasterized into a depth texture, which needs OES_depth_texture and an FBO per page
+//and comes out at whatever precision the driver picks for depth. Here the same values are computed directly: every
+//texel gets its distance to the flattened path, encoded exactly like the cone's depth (0.5 on the path, 1.0 from the
+//circle radius outwards) so the body shading in main.frag reads both the same. The field is smooth, so it's rendered
+//at SCALE texels per screen pixel and linear filtering scales it back up without stair stepping the edges.
+//Per segment only the texels within a radius of it are visited, eight at a time along a row, keeping the smallest
+//squared distance; the square roots are taken once per texel at the end.
+//A field is one byte per texel at SCALE² of the body's area on screen, the depth body two bytes per texel at full size.
+//What that means for atlas memory and frame times hasn't been measured yet, curvebench --mesh prints the bytes per body
+//of both and zerosu --slider-stats the atlas usage in game.
+
+const std = @import("std");
+const zm = @import("zm");
+
+const Path = @import("SliderPath.zig").Path;
+
+///Field texels per screen pixel on each axis
+pub const SCALE: f32 = 0.5;
+
+const LANES = 8;
+const Lanes = @Vector(LANES, f32);
+
+///Texels needed on each axis for _path_'s field at _screen_scale_ screen pixels per osu pixel, before fitting it into
+///the atlas
+pub fn GetSize(path: *const Path, screen_scale: f32) [2]i32 {
+    const scale = screen_scale * SCALE;
+
+    return .{
+        @max(1, @as(i32, @intFromFloat(@ceil(@as(f32, @floatFromInt(@max(path.Width, 1))) * scale)))),
+        @max(1, @as(i32, @intFromFloat(@ceil(@as(f32, @floatFromInt(@max(path.Height, 1))) * scale)))),
+    };
+}
+
+///Fills _pixels_ (_width_ x _height_, row 0 at the path's smallest y like in the depth body) with _path_'s field stretched over its bounds.
+///_allocator_ is only used for scratch.
+pub fn Render(allocator: std.mem.Allocator, pixels: []u8, width: usize, height: usize, path: *const Path) !void {
+    std.debug.assert(pixels.len >= width * height);
+
+    //Rows padded to whole vectors so no lane ever needs masking
+    const stride = std.mem.alignForward(usize, width, LANES);
+
+    const radius = path.PointRadius;
+    const radius_squared = radius * radius;
+
+    const distances = try allocator.alloc(f32, stride * height);
+    defer allocator.free(distances);
+
+    @memset(distances, radius_squared);
+
+    //Osu pixels per texel, the region may have been shrunk to fit the atlas
+    const texel_size = zm.Vec2f{
+        @as(f32, @floatFromInt(@max(path.Width, 1))) / @as(f32, @floatFromInt(width)),
+        @as(f32, @floatFromInt(@max(path.Height, 1))) / @as(f32, @floatFromInt(height)),
+    };
+
+    var lane_offsets: Lanes = undefined;
+    inline for (0..LANES) |lane| {
+        lane_offsets[lane] = @floatFromInt(lane);
+    }
+
+    const points = path.Points;
+    const segment_count = @max(points.len, 2) - 1;
+
+    for (0..segment_count) |segment| {
+        //Relative to the bounds like the mesh, a single point path is a zero length segment
+        const a = points[segment] - path.Position;
+        const b = points[@min(segment + 1, points.len - 1)] - path.Position;
+        const ab = b - a;
+        const length_squared = zm.vec.dot(ab, ab);
+        const inverse_length_squared: f32 = if (length_squared > 0.0) 1.0 / length_squared else 0.0;
+
+        //Texels whose centers can be within a radius of the segment
+        const x_range = texelRange(@min(a[0], b[0]) - radius, @max(a[0], b[0]) + radius, texel_size[0], width);
+        const y_range = texelRange(@min(a[1], b[1]) - radius, @max(a[1], b[1]) + radius, texel_size[1], height);
+
+        const first_x = x_range[0] - x_range[0] % LANES;
+
+        for (y_range[0]..y_range[1]) |y| {
+            const row = distances[y * stride ..][0..stride];
+
+            const py = (@as(f32, @floatFromInt(y)) + 0.5) * texel_size[1] - a[1];
+            const py_lanes: Lanes = @splat(py);
+
+            var x = first_x;
+            while (x < x_range[1]) : (x += LANES) {
+                const px = ((lane_offsets + @as(Lanes, @splat(@as(f32, @floatFromInt(x)) + 0.5))) * @as(Lanes, @splat(texel_size[0]))) - @as(Lanes, @splat(a[0]));
+
+                const along = (px * @as(Lanes, @splat(ab[0])) + py_lanes * @as(Lanes, @splat(ab[1]))) * @as(Lanes, @splat(inverse_length_squared));
+                const t = @min(@max(along, @as(Lanes, @splat(0.0))), @as(Lanes, @splat(1.0)));
+
+                const dx = px - t * @as(Lanes, @splat(ab[0]));
+                const dy = py_lanes - t * @as(Lanes, @splat(ab[1]));
+
+                const current: Lanes = row[x..][0..LANES].*;
+                row[x..][0..LANES].* = @min(current, dx * dx + dy * dy);
+            }
+        }
+    }
+
+    const inverse_radius: Lanes = @splat(if (radius > 0.0) 1.0 / radius else 0.0);
+    const half: Lanes = @splat(0.5);
+    const one: Lanes = @splat(1.0);
+
+    for (0..height) |y| {
+        const row = distances[y * stride ..][0..stride];
+        const output = pixels[y * width ..][0..width];
+
+        var x: usize = 0;
+        while (x < width) : (x += LANES) {
+            const distance = @sqrt(@as(Lanes, row[x..][0..LANES].*));
+            const value = (half + half * @min(distance * inverse_radius, one)) * @as(Lanes, @splat(255.0));
+            const bytes: @Vector(LANES, u8) = @intFromFloat(@round(value));
+            const byte_array: [LANES]u8 = bytes;
+
+            const count = @min(LANES, width - x);
+            @memcpy(output[x..][0..count], byte_array[0..count]);
+        }
+    }
+}
+
+///Texels [start, end) on an axis of _count_ texels whose centers lie within [_min_, _max_] osu pixels
+fn texelRange(min: f32, max: f32, texel_size: f32, count: usize) [2]usize {
+    const first = @max(0.0, @floor(min / texel_size - 0.5));
+    const last = @min(@as(f32, @floatFromInt(count)), @ceil(max / texel_size + 0.5));
+
+    if (last <= first)
+        return .{ 0, 0 };
+
+    return .{ @intFromFloat(first), @intFromFloat(last) };
+}
@@ -0,0 +1,128 @@
+//Level of detail for slider geometry
+//Curve tolerances and circle segment counts were fixed in osu pixels, so a small window tessellated exactly as much as
+//a 1440p one. Here everything starts from an error budget in screen pixels (the quality profile) and gets converted to
+//osu pixels with the current playfield scale, so the geometry is only as fine as the display can actually show.
+
+const std = @import("std");
+
+const CurveApproximator = @import("../CurveApproximator.zig").CurveApproximator;
+const FlattenDetail = @import("SliderPath.zig").FlattenDetail;
+const PlayableBeatmap = @import("PlayableBeatmap.zig").PlayableBeatmap;
+
+pub const QualityProfile = enum {
+    Low,
+    Medium,
+    High,
+
+    ///Max distance in screen pixels between the tessellated geometry and the real curve/circle
+    pub fn ScreenTolerance(self: QualityProfile) f32 {
+        return switch (self) {
+            .Low => 1.0,
+            .Medium => 0.5,
+            .High => 0.2,
+        };
+    }
+
+    pub fn FromString(name: []const u8) ?QualityProfile {
+        inline for (comptime std.enums.values(QualityProfile)) |profile| {
+            if (std.ascii.eqlIgnoreCase(name, @tagName(profile)))
+                return profile;
+        }
+
+        return null;
+    }
+};
+
+var _profile: QualityProfile = .Medium;
+
+pub const SliderLod = struct {
+    //Before the playfield is known the scale is 0, treat that as a 1:1 playfield
+    const MIN_SCALE: f32 = 0.25;
+    //osu pixels, the extremes keep a broken scale from producing millions of points or a polygon
+    const MIN_TOLERANCE: f32 = 0.02;
+    const MAX_TOLERANCE: f32 = 2.0;
+
+    const CATMULL_DETAIL_AT_DEFAULT: f32 = 50.0;
+    const MIN_CATMULL_DETAIL: f32 = 8.0;
+    const MAX_CATMULL_DETAIL: f32 = 100.0;
+
+    const MIN_CIRCLE_SEGMENTS: f32 = 8.0;
+    pub const MAX_CIRCLE_SEGMENTS: f32 = 64.0;
+    const MIN_ARC_SEGMENTS: f32 = 2.0;
+    const MAX_ARC_SEGMENTS: f32 = 32.0;
+    //A missing joint leaves a crack this wide (as a fraction of the tolerance) at the edge of the body, small enough
+    //that it hardly ever swallows a pixel centre
+    const JOINT_SKIP_FRACTION: f32 = 0.1;
+
+    ///Screen pixels per osu pixel this was computed for
+    Scale: f32,
+    ///Max geometry error in osu pixels
+    Tolerance: f32,
+    Flatten: FlattenDetail,
+
+    pub fn SetProfile(profile: QualityProfile) void {
+        _profile = profile;
+    }
+
+    pub fn GetProfile() QualityProfile {
+        return _profile;
+    }
+
+    ///For the current playfield size and profile
+    pub fn Current() SliderLod {
+        return Compute(PlayableBeatmap.OsuToWorldScale(), _profile);
+    }
+
+    pub fn Compute(osu_to_world_scale: f32, profile: QualityProfile) SliderLod {
+        const scale = @max(osu_to_world_scale, MIN_SCALE);
+        const tolerance = std.math.clamp(profile.ScreenTolerance() / scale, MIN_TOLERANCE, MAX_TOLERANCE);
+
+        //Catmull is sampled uniformly, its error goes down with the square of the detail
+        const catmull_detail = CATMULL_DETAIL_AT_DEFAULT * @sqrt(CurveApproximator.BEZIER_TOLERANCE / tolerance);
+
+        return .{
+            .Scale = scale,
+            .Tolerance = tolerance,
+            .Flatten = .{
+                .Tolerance = .{
+                    .Bezier = tolerance,
+                    .CircularArc = tolerance * (CurveApproximator.CIRCULAR_ARC_TOLERANCE / CurveApproximator.BEZIER_TOLERANCE),
+                },
+                .CatmullDetail = @intFromFloat(@ceil(std.math.clamp(catmull_detail, MIN_CATMULL_DETAIL, MAX_CATMULL_DETAIL))),
+                //Only ever drawn, gameplay flattens with the defaults
+                .Kernel = .Simd,
+            },
+        };
+    }
+
+    ///Segments for a full circle of _radius_ osu pixels
+    pub fn CircleSegments(self: *const SliderLod, radius: f32) u16 {
+        const segments = @ceil(2.0 * std.math.pi / self.segmentAngle(radius));
+        return @intFromFloat(std.math.clamp(segments, MIN_CIRCLE_SEGMENTS, MAX_CIRCLE_SEGMENTS));
+    }
+
+    ///Segments for _angle_ radians of a circle of _radius_ osu pixels, for the round joints between slider segments
+    pub fn ArcSegments(self: *const SliderLod, radius: f32, angle: f32) u16 {
+        const segments = @ceil(@abs(angle) / self.segmentAngle(radius));
+        return @intFromFloat(std.math.clamp(segments, MIN_ARC_SEGMENTS, MAX_ARC_SEGMENTS));
+    }
+
+    ///Segments for a round joint turning by _angle_ radians, fewer than ArcSegments: a slight turn gets a single
+    ///triangle as long as the chord stays within the tolerance, and none at all once the notch between the two
+    ///segments is narrower than a tenth of it
+    pub fn JointSegments(self: *const SliderLod, radius: f32, angle: f32) u16 {
+        if (@abs(angle) * radius <= self.Tolerance * JOINT_SKIP_FRACTION)
+            return 0;
+
+        const segments = @ceil(@abs(angle) / self.segmentAngle(radius));
+        return @intFromFloat(std.math.clamp(segments, 1.0, MAX_ARC_SEGMENTS));
+    }
+
+    ///Largest angle one chord may span while staying within the tolerance (sagitta r * (1 - cos(a / 2)))
+    fn segmentAngle(self: *const SliderLod, radius: f32) f32 {
+        if (radius <= self.Tolerance)
+            return std.math.pi;
+
+        return 2.0 * std.math.acos(1.0 - self.Tolerance / radius);
+    }
+};
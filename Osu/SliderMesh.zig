@@ -0,0 +1,554 @@
+//Slider body geometry
+//The body is a cone along the path: depth 0 on the path and -1 one radius away from it, so with depth testing the
+//depth buffer ends up holding the distance to the path and the shading is done from that. Used both to render bodies
+//into the atlas and to draw them straight to the screen.
+//Segments go into the mesh in path order, so any stretch of the path is one contiguous index range. That's what
+//snaking draws: the range covering the visible part, with the two partial segments at its ends pulled in by the
+//vertex shader and the end caps moved to where the body currently ends.
+
+const std = @import("std");
+const zm = @import("zm");
+
+const c = @import("../CImports.zig").c;
+const IndexedPrimitiveBatcher = @import("../Easy2D/PrimitiveBatcher.zig").IndexedPrimitiveBatcher;
+const GLBuffer = @import("../Easy2D/GLBuffer.zig").GLBuffer;
+const Path = @import("SliderPath.zig").Path;
+const SliderLod = @import("SliderLod.zig").SliderLod;
+
+pub const SliderVertex = extern struct {
+    X: f32,
+    Y: f32,
+    Depth: f32,
+    //Distance along the path and direction of the segment, for trimming partial segments when snaking.
+    //Zero direction on caps and joints, those never move.
+    Along: f32 = 0.0,
+    DirectionX: f32 = 0.0,
+    DirectionY: f32 = 0.0,
+
+    pub fn EnableVertexAttribs() void {
+        c.glEnableVertexAttribArray(0);
+        c.glVertexAttribPointer(0, 3, c.GL_FLOAT, c.GL_FALSE, @sizeOf(SliderVertex), @ptrFromInt(0));
+
+        c.glEnableVertexAttribArray(1);
+        c.glVertexAttribPointer(1, 3, c.GL_FLOAT, c.GL_FALSE, @sizeOf(SliderVertex), @ptrFromInt(12));
+    }
+
+    pub fn DisableVertexAttribs() void {
+        c.glDisableVertexAttribArray(0);
+        c.glDisableVertexAttribArray(1);
+    }
+};
+
+//Indices are built as u32 and narrowed to u16 on upload when the GPU can't take u32 (see StaticSliderMesh)
+pub const SliderBatcher = IndexedPrimitiveBatcher(SliderVertex, u32);
+
+//u16 indices reach this many vertices, after that a mesh continues in a new chunk
+const SHORT_CHUNK_VERTICES: u32 = std.math.maxInt(u16);
+//Chunk size with OES_element_index_uint, only marathon sliders at high detail get past it
+const UINT_CHUNK_VERTICES: u32 = 1 << 18;
+
+var _UintIndices: ?bool = null;
+
+///Whether index buffers can be u32 (GL_OES_element_index_uint), GLES2 only guarantees u16
+fn supportsUintIndices() bool {
+    if (_UintIndices == null) {
+        const extensions = c.glGetString(c.GL_EXTENSIONS);
+        _UintIndices = extensions != null and std.mem.indexOf(u8, std.mem.span(@as([*:0]const u8, @ptrCast(extensions))), "GL_OES_element_index_uint") != null;
+
+        std.debug.print("Slider meshes: {s} indices\n", .{if (_UintIndices.?) "u32" else "u16"});
+    }
+
+    return _UintIndices.?;
+}
+
+///A slider body uploaded once at spawn, drawn whole or in parts every frame without touching the vertices again.
+///A body too big for one index buffer is split into chunks that are drawn one after another, positions in the index
+///stream (segment starts, ranges) run on across chunks.
+pub const StaticSliderMesh = struct {
+    const Chunk = struct {
+        Vertices: GLBuffer(SliderVertex),
+        //u16 or u32 indices depending on supportsUintIndices, hence bytes
+        Indices: GLBuffer(u8),
+        //Position of the chunk's first index in the stream
+        FirstIndex: u32,
+        IndexCount: u32,
+    };
+
+    //Collects the chunks while a mesh is built, the batcher's out of space callback uploads into it
+    const ChunkBuilder = struct {
+        Chunks: std.ArrayList(Chunk),
+        Failed: ?anyerror = null,
+    };
+
+    m_Chunks: []Chunk,
+    m_IndexType: c.GLenum,
+    m_IndexSize: u32,
+    //Indices of one end cap, the start cap is first in the stream and the end cap right after it
+    m_CapIndexCount: u32,
+    //Where each segment's quads start in the index stream, the joint to the next segment follows them
+    m_SegmentStarts: []u32,
+    m_BoundChunk: ?usize = null,
+
+    ///A batcher to build meshes with, each fill of it becomes at most one chunk
+    pub fn InitBatcher() !SliderBatcher {
+        const vertex_count = if (supportsUintIndices()) UINT_CHUNK_VERTICES else SHORT_CHUNK_VERTICES;
+
+        //Fans take up to three indices per vertex, quads one and a half
+        return SliderBatcher.Init(vertex_count, vertex_count * 3);
+    }
+
+    ///Builds _path_'s body with _batcher_ (see InitBatcher) as scratch space and uploads it, the batcher is left empty
+    pub fn Init(allocator: std.mem.Allocator, batcher: *SliderBatcher, path: *const Path, lod: *const SliderLod) !StaticSliderMesh {
+        const segment_starts = try allocator.alloc(u32, path.Points.len - 1);
+        errdefer allocator.free(segment_starts);
+
+        var builder = ChunkBuilder{ .Chunks = std.ArrayList(Chunk).init(allocator) };
+        errdefer {
+            for (builder.Chunks.items) |*chunk| {
+                deinitChunk(chunk);
+            }
+            builder.Chunks.deinit();
+        }
+
+        batcher.ResetWritePosition();
+        batcher.OutOfSpaceCallback = flushChunk;
+        batcher.OutOfSpaceContext = &builder;
+        defer {
+            batcher.OutOfSpaceCallback = null;
+            batcher.OutOfSpaceContext = null;
+            batcher.ResetWritePosition();
+        }
+
+        const cap_index_count = SliderMesh.Build(batcher, path, lod, segment_starts);
+        flushChunk(batcher);
+
+        if (builder.Failed) |err|
+            return err;
+
+        const uint_indices = supportsUintIndices();
+
+        return .{
+            .m_Chunks = try builder.Chunks.toOwnedSlice(),
+            .m_IndexType = if (uint_indices) c.GL_UNSIGNED_INT else c.GL_UNSIGNED_SHORT,
+            .m_IndexSize = if (uint_indices) @sizeOf(u32) else @sizeOf(u16),
+            .m_CapIndexCount = cap_index_count,
+            .m_SegmentStarts = segment_starts,
+        };
+    }
+
+    pub fn Deinit(self: *StaticSliderMesh, allocator: std.mem.Allocator) void {
+        for (self.m_Chunks) |*chunk| {
+            deinitChunk(chunk);
+        }
+
+        allocator.free(self.m_Chunks);
+        allocator.free(self.m_SegmentStarts);
+    }
+
+    ///Readies the mesh for the Draw calls, ends with End
+    pub fn Begin(self: *StaticSliderMesh) void {
+        self.m_BoundChunk = null;
+    }
+
+    pub fn End(self: *StaticSliderMesh) void {
+        if (self.m_BoundChunk != null)
+            SliderVertex.DisableVertexAttribs();
+
+        self.m_BoundChunk = null;
+    }
+
+    pub fn DrawAll(self: *StaticSliderMesh) void {
+        const last = self.m_Chunks[self.m_Chunks.len - 1];
+        self.drawRange(0, last.FirstIndex + last.IndexCount);
+    }
+
+    pub fn DrawStartCap(self: *StaticSliderMesh) void {
+        self.drawRange(0, self.m_CapIndexCount);
+    }
+
+    pub fn DrawEndCap(self: *StaticSliderMesh) void {
+        self.drawRange(self.m_CapIndexCount, self.m_CapIndexCount * 2);
+    }
+
+    ///Segments _first_ to _last_ inclusive and the joints between them
+    pub fn DrawSegments(self: *StaticSliderMesh, first: usize, last: usize) void {
+        if (last < first)
+            return;
+
+        self.drawRange(self.m_SegmentStarts[first], self.m_SegmentStarts[last] + SliderMesh.SEGMENT_INDEX_COUNT);
+    }
+
+    ///Stream indices _start_ up to _end_, one draw per chunk they touch
+    fn drawRange(self: *StaticSliderMesh, start: u32, end: u32) void {
+        for (self.m_Chunks, 0..) |*chunk, chunk_index| {
+            const from = @max(start, chunk.FirstIndex);
+            const to = @min(end, chunk.FirstIndex + chunk.IndexCount);
+
+            if (from >= to)
+                continue;
+
+            if (self.m_BoundChunk == null or self.m_BoundChunk.? != chunk_index) {
+                chunk.Vertices.Use();
+                chunk.Indices.Use();
+                //Attribute pointers go to whatever buffer was bound when they were set
+                SliderVertex.EnableVertexAttribs();
+                self.m_BoundChunk = chunk_index;
+            }
+
+            c.glDrawElements(c.GL_TRIANGLES, @intCast(to - from), self.m_IndexType, @ptrFromInt((from - chunk.FirstIndex) * self.m_IndexSize));
+        }
+    }
+
+    ///Out of space callback, uploads what's in the batcher as a chunk and empties it
+    fn flushChunk(batcher: *SliderBatcher) void {
+        const builder: *ChunkBuilder = @ptrCast(@alignCast(batcher.OutOfSpaceContext.?));
+
+        const upload_data = batcher.GetUploadData();
+        const first_index = batcher.GetStreamIndexCount() - batcher.GetIndexCount();
+
+        defer batcher.Flush();
+
+        if (upload_data.IndexSlice.len == 0 or builder.Failed != null)
+            return;
+
+        builder.Failed = uploadChunk(builder, upload_data.VertexSlice, upload_data.IndexSlice, first_index);
+    }
+
+    fn uploadChunk(builder: *ChunkBuilder, vertex_slice: []const SliderVertex, index_slice: []u32, first_index: u32) ?anyerror {
+        var vertices = GLBuffer(SliderVertex).Init(c.GL_ARRAY_BUFFER) catch |err| return err;
+        var indices = GLBuffer(u8).Init(c.GL_ELEMENT_ARRAY_BUFFER) catch |err| {
+            vertices.Deinit();
+            return err;
+        };
+
+        vertices.Upload(vertex_slice, c.GL_STATIC_DRAW);
+
+        if (supportsUintIndices()) {
+            indices.Upload(std.mem.sliceAsBytes(index_slice), c.GL_STATIC_DRAW);
+        } else {
+            //Narrowed in place, every u16 goes at or before the u32 it comes from. The batcher is emptied right after.
+            const short_indices = std.mem.bytesAsSlice(u16, std.mem.sliceAsBytes(index_slice))[0..index_slice.len];
+            for (short_indices, 0..) |*short_index, i| {
+                short_index.* = @intCast(index_slice[i]);
+            }
+
+            indices.Upload(std.mem.sliceAsBytes(short_indices), c.GL_STATIC_DRAW);
+        }
+
+        builder.Chunks.append(.{
+            .Vertices = vertices,
+            .Indices = indices,
+            .FirstIndex = first_index,
+            .IndexCount = @intCast(index_slice.len),
+        }) catch |err| {
+            vertices.Deinit();
+            indices.Deinit();
+            return err;
+        };
+
+        return null;
+    }
+
+    fn deinitChunk(chunk: *Chunk) void {
+        chunk.Vertices.Deinit();
+        chunk.Indices.Deinit();
+    }
+};
+
+pub const SliderMesh = struct {
+    //Two quads per segment
+    const SEGMENT_INDEX_COUNT: u32 = 12;
+    const MAX_CAP_SEGMENTS: usize = @intFromFloat(SliderLod.MAX_CIRCLE_SEGMENTS);
+
+    ///Which mesh builder BuildKernel uses. Reference is the original one (sin/cos per vertex, a fan of at least two
+    ///triangles on every joint) and is kept to check Default against, curvebench --mesh compares the two.
+    pub const Kernel = enum { Reference, Default };
+
+    ///Writes _path_'s body relative to its bounds into the empty _batcher_: start cap, end cap, then the segments in
+    ///path order. The stream index (see GetStreamIndexCount) of every segment goes to _segment_starts_ (one per
+    ///segment), returns the index count of a cap.
+    pub fn Build(batcher: *SliderBatcher, path: *const Path, lod: *const SliderLod, segment_starts: []u32) u32 {
+        return BuildKernel(.Default, batcher, path, lod, segment_starts);
+    }
+
+    pub fn BuildKernel(comptime kernel: Kernel, batcher: *SliderBatcher, path: *const Path, lod: *const SliderLod, segment_starts: []u32) u32 {
+        const points = path.Points;
+        const origin = path.Position;
+        const radius = path.PointRadius;
+        const half_thickness: zm.Vec2f = .{ radius, radius };
+
+        var prev_perpendicular: zm.Vec2f = .{ 0.0, 0.0 };
+        //Profiler.Start("Slider_Geometry");
+        const cap_segments = lod.CircleSegments(radius);
+        var cap_index_count: u32 = 0;
+
+        switch (kernel) {
+            .Reference => {
+                //start cap
+                placeCircle(batcher, points[0] - origin, radius, cap_segments);
+                cap_index_count = batcher.GetStreamIndexCount();
+                //end cap
+                placeCircle(batcher, points[points.len - 1] - origin, radius, cap_segments);
+            },
+            .Default => {
+                //Both caps come out of one table of the circle
+                var unit_circle: [MAX_CAP_SEGMENTS + 1]zm.Vec2f = undefined;
+                const ANGLE_STEP: f32 = 2.0 * std.math.pi / @as(f32, @floatFromInt(cap_segments));
+
+                for (unit_circle[0..cap_segments], 0..) |*point, i| {
+                    const angle = @as(f32, @floatFromInt(i)) * ANGLE_STEP;
+                    point.* = .{ @cos(angle), @sin(angle) };
+                }
+                unit_circle[cap_segments] = unit_circle[0];
+
+                placeCircleTable(batcher, points[0] - origin, radius, unit_circle[0 .. cap_segments + 1]);
+                cap_index_count = batcher.GetStreamIndexCount();
+                placeCircleTable(batcher, points[points.len - 1] - origin, radius, unit_circle[0 .. cap_segments + 1]);
+            },
+        }
+
+        for (0..points.len - 1) |i| {
+            const current = points[i] - origin;
+            var next = points[i + 1] - origin;
+
+            if (@reduce(.And, current == next)) {
+                //nudge hax
+                next[0] += 0.1;
+                next[1] += 0.1;
+            }
+
+            const direction = zm.vec.normalize(next - current);
+            const perpendicular: zm.Vec2f = .{ direction[1], -direction[0] };
+
+            if (i > 0) {
+                //draw corner, before the segment so a range starting at this segment leaves it out
+                switch (kernel) {
+                    .Reference => drawCornerJointDynamic(batcher, current, prev_perpendicular, perpendicular, half_thickness, lod),
+                    .Default => drawCornerJoint(batcher, current, prev_perpendicular, perpendicular, radius, lod),
+                }
+            }
+
+            //draw line segment
+            segment_starts[i] = batcher.GetStreamIndexCount();
+            switch (kernel) {
+                .Reference => drawLineSegment(batcher, current, next, direction, perpendicular, half_thickness, path.CumulativeLengths[i], path.CumulativeLengths[i + 1]),
+                .Default => drawLineSegmentVectorized(batcher, current, next, direction, perpendicular * half_thickness, path.CumulativeLengths[i], path.CumulativeLengths[i + 1]),
+            }
+
+            prev_perpendicular = perpendicular;
+        }
+        //Profiler.End("Slider_Geometry");
+
+        return cap_index_count;
+    }
+
+    ///_unit_circle_ goes once around, with the first point repeated at the end
+    inline fn placeCircleTable(batcher: *SliderBatcher, center: zm.Vec2f, radius: f32, unit_circle: []const zm.Vec2f) void {
+        const circle_verts = batcher.GetTriangleFan(@intCast(unit_circle.len + 1)) catch unreachable;
+
+        circle_verts[0] = .{
+            .X = center[0],
+            .Y = center[1],
+            .Depth = 0.0,
+        };
+
+        const radius_v: zm.Vec2f = .{ radius, radius };
+
+        for (circle_verts[1..], unit_circle) |*vertex, point| {
+            const position = center + point * radius_v;
+
+            vertex.* = .{
+                .X = position[0],
+                .Y = position[1],
+                .Depth = -1.0,
+            };
+        }
+    }
+
+    ///Both sides of a segment at once, lanes are the four corners of a quad: start edge, start, end, end edge
+    inline fn drawLineSegmentVectorized(batcher: *SliderBatcher, start: zm.Vec2f, end: zm.Vec2f, direction: zm.Vec2f, offset: zm.Vec2f, start_along: f32, end_along: f32) void {
+        const Lanes = @Vector(4, f32);
+        //1 on the edge corners, 0 on the path
+        const EDGE: Lanes = .{ 1.0, 0.0, 0.0, 1.0 };
+
+        const x: Lanes = .{ start[0], start[0], end[0], end[0] };
+        const y: Lanes = .{ start[1], start[1], end[1], end[1] };
+        const offset_x = EDGE * @as(Lanes, @splat(offset[0]));
+        const offset_y = EDGE * @as(Lanes, @splat(offset[1]));
+        const depth = -EDGE;
+        const along: Lanes = .{ start_along, start_along, end_along, end_along };
+
+        const side_x = [2]Lanes{ x + offset_x, x - offset_x };
+        const side_y = [2]Lanes{ y + offset_y, y - offset_y };
+
+        inline for (0..2) |side| {
+            //Filled before asking for the next one, that can flush this one out as a chunk
+            const quad = batcher.GetQuad();
+
+            inline for (0..4) |corner| {
+                quad[corner] = .{
+                    .X = side_x[side][corner],
+                    .Y = side_y[side][corner],
+                    .Depth = depth[corner],
+                    .Along = along[corner],
+                    .DirectionX = direction[0],
+                    .DirectionY = direction[1],
+                };
+            }
+        }
+    }
+
+    ///Round joint on the outer side of the turn, stepped by rotating one vector instead of a sin/cos per vertex.
+    ///Nothing for a turn so slight that the notch between the segments is under the tolerance.
+    inline fn drawCornerJoint(batcher: *SliderBatcher, center: zm.Vec2f, prev_perpendicular: zm.Vec2f, curr_perpendicular: zm.Vec2f, radius: f32, lod: *const SliderLod) void {
+        const cross = prev_perpendicular[0] * curr_perpendicular[1] - prev_perpendicular[1] * curr_perpendicular[0];
+        const dot = prev_perpendicular[0] * curr_perpendicular[0] + prev_perpendicular[1] * curr_perpendicular[1];
+        const angle = std.math.atan2(@abs(cross), dot);
+
+        const segments = lod.JointSegments(radius, angle);
+        if (segments == 0)
+            return;
+
+        //Outer side is the one the perpendiculars point to on a left turn, the other one on a right turn
+        const side: f32 = if (cross > 0.0) 1.0 else -1.0;
+        const radius_v: zm.Vec2f = .{ radius * side, radius * side };
+
+        const step = side * angle / @as(f32, @floatFromInt(segments));
+        const step_cos = @cos(step);
+        const step_sin = @sin(step);
+
+        const triangle_fan = batcher.GetTriangleFan(segments + 2) catch unreachable;
+        triangle_fan[0] = .{
+            .X = center[0],
+            .Y = center[1],
+            .Depth = 0.0,
+        };
+
+        var edge = prev_perpendicular;
+
+        for (triangle_fan[1 .. triangle_fan.len - 1]) |*vertex| {
+            const position = center + edge * radius_v;
+
+            vertex.* = .{
+                .X = position[0],
+                .Y = position[1],
+                .Depth = -1.0,
+            };
+
+            edge = .{ edge[0] * step_cos - edge[1] * step_sin, edge[0] * step_sin + edge[1] * step_cos };
+        }
+
+        //Exactly on the next segment's corner, the rotation drifts a little
+        const last = center + curr_perpendicular * radius_v;
+        triangle_fan[triangle_fan.len - 1] = .{
+            .X = last[0],
+            .Y = last[1],
+            .Depth = -1.0,
+        };
+    }
+
+    inline fn placeCircle(batcher: *SliderBatcher, center: zm.Vec2f, radius: f32, segments: u16) void {
+        const ANGLE_STEP: f32 = 2.0 * std.math.pi / @as(f32, @floatFromInt(segments));
+
+        var circle_verts = batcher.GetTriangleFan(segments + 2) catch unreachable;
+
+        circle_verts[0] = .{
+            .X = center[0],
+            .Y = center[1],
+            .Depth = 0.0,
+        };
+
+        for (0..segments + 1) |i| {
+            const angle = @as(f32, @floatFromInt(i)) * ANGLE_STEP;
+
+            const x: f32 = center[0] + radius * @cos(angle);
+            const y: f32 = center[1] + radius * @sin(angle);
+
+            circle_verts[i + 1] = .{
+                .X = x,
+                .Y = y,
+                .Depth = -1.0,
+            };
+        }
+    }
+
+    inline fn drawLineSegment(batcher: *SliderBatcher, start: zm.Vec2f, end: zm.Vec2f, direction: zm.Vec2f, perpendicular: zm.Vec2f, half_thickness: zm.Vec2f, start_along: f32, end_along: f32) void {
+        const offset = perpendicular * half_thickness;
+
+        //Top side then bottom side. Each quad is filled completely before asking for the next, that can flush it out
+        //as a chunk.
+        for ([_]zm.Vec2f{ offset, -offset }) |side_offset| {
+            const side = batcher.GetQuad();
+
+            side[0].X = start[0] + side_offset[0];
+            side[0].Y = start[1] + side_offset[1];
+            side[0].Depth = -1.0;
+
+            side[1].X = start[0];
+            side[1].Y = start[1];
+            side[1].Depth = 0.0;
+
+            side[2].X = end[0];
+            side[2].Y = end[1];
+            side[2].Depth = 0.0;
+
+            side[3].X = end[0] + side_offset[0];
+            side[3].Y = end[1] + side_offset[1];
+            side[3].Depth = -1.0;
+
+            for (side, [_]f32{ start_along, start_along, end_along, end_along }) |*vertex, along| {
+                vertex.Along = along;
+                vertex.DirectionX = direction[0];
+                vertex.DirectionY = direction[1];
+            }
+        }
+    }
+
+    inline fn drawCornerJointDynamic(batcher: *SliderBatcher, center: zm.Vec2f, prev_perpendicular: zm.Vec2f, curr_perpendicular: zm.Vec2f, half_thickness: zm.Vec2f, detail: *const SliderLod) void {
+        const cross = prev_perpendicular[0] * curr_perpendicular[1] - prev_perpendicular[1] * curr_perpendicular[0];
+
+        const is_left_turn = if (cross > 0.0) true else false;
+
+        var start_offset = if (is_left_turn) prev_perpendicular else -prev_perpendicular;
+        start_offset *= half_thickness;
+        var end_offset = if (is_left_turn) curr_perpendicular else -curr_perpendicular;
+        end_offset *= half_thickness;
+
+        const start_angle = std.math.atan2(start_offset[1], start_offset[0]);
+        const end_angle = std.math.atan2(end_offset[1], end_offset[0]);
+
+        var angle_diff = end_angle - start_angle;
+
+        if (angle_diff > std.math.pi) {
+            angle_diff -= 2.0 * std.math.pi;
+        } else if (angle_diff < -std.math.pi) {
+            angle_diff += 2.0 * std.math.pi;
+        }
+
+        const abs_angle_diff = @abs(angle_diff);
+
+        const resolutionInt: u16 = detail.ArcSegments(half_thickness[0], abs_angle_diff);
+
+        var triangle_fan = batcher.GetTriangleFan(resolutionInt + 2) catch unreachable;
+        triangle_fan[0] = .{
+            .X = center[0],
+            .Y = center[1],
+            .Depth = 0.0,
+        };
+
+        const clockwise: bool = angle_diff < 0.0;
+
+        for (0..resolutionInt + 1) |i| {
+            const t: f32 = @as(f32, @floatFromInt(i)) / @as(f32, @floatFromInt(resolutionInt));
+            const angle = if (clockwise) start_angle - t * abs_angle_diff else start_angle + t * angle_diff;
+
+            const offset = zm.Vec2f{ @cos(angle), @sin(angle) } * half_thickness;
+
+            triangle_fan[i + 1] = .{
+                .X = center[0] + offset[0],
+                .Y = center[1] + offset[1],
+                .Depth = -1.0,
+            };
+        }
+    }
+};
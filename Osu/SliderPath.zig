@@ -0,0 +1,404 @@
+const std = @import("std");
+const zm = @import("zm");
+
+const HitObject = @import("OsuParser.zig").HitObject;
+const SliderType = @import("OsuParser.zig").HitSliderType;
+
+const CurveApproximator = @import("../CurveApproximator.zig").CurveApproximator;
+
+pub const Path = struct {
+    //A cursor can walk this many segments before it gives up and binary searches
+    const CURSOR_WALK_LIMIT: usize = 8;
+
+    Points: []const zm.Vec2f,
+    ///Distance along the path to each point, same length as Points
+    CumulativeLengths: []const f32,
+    Length: f32,
+    Bounds: zm.Vec4f,
+    Position: zm.Vec2f,
+    Width: i32,
+    Height: i32,
+    PointRadius: f32,
+
+    ///_points_ stay owned by the caller, only the length table is allocated (see Deinit)
+    pub fn Init(allocator: std.mem.Allocator, points: []const zm.Vec2f, point_radius: f32) !Path {
+        const cumulative_lengths = try allocator.alloc(f32, points.len);
+
+        var length: f32 = 0.0;
+        for (cumulative_lengths, 0..) |*cumulative, i| {
+            if (i > 0)
+                length += zm.vec.distance(points[i - 1], points[i]);
+
+            cumulative.* = length;
+        }
+
+        var bounds = CalculateBounds(points);
+
+        bounds[0] -= point_radius;
+        bounds[1] -= point_radius;
+        bounds[2] += point_radius;
+        bounds[3] += point_radius;
+
+        return .{
+            .Points = points,
+            .CumulativeLengths = cumulative_lengths,
+            .Length = length,
+            .Bounds = bounds,
+            .Position = .{ bounds[0], bounds[1] },
+            .Width = @as(i32, @intFromFloat(bounds[2] - bounds[0])),
+            .Height = @as(i32, @intFromFloat(bounds[3] - bounds[1])),
+            .PointRadius = point_radius,
+        };
+    }
+
+    pub fn Deinit(self: *Path, allocator: std.mem.Allocator) void {
+        allocator.free(self.CumulativeLengths);
+    }
+
+    pub fn CalculatePositionAt(self: *const Path, l: f32) zm.Vec2f {
+        if (l <= 0)
+            return self.Points[0];
+
+        if (l >= self.Length)
+            return self.Points[self.Points.len - 1];
+
+        return self.positionInSegment(self.findSegment(l), l);
+    }
+
+    ///_progress_ goes from 0 (head) to 1 (tail)
+    pub fn CalculatePositionAtProgress(self: *const Path, progress: f32) zm.Vec2f {
+        return self.CalculatePositionAt(self.Length * progress);
+    }
+
+    ///Normalized direction of travel at _l_
+    pub fn CalculateTangentAt(self: *const Path, l: f32) zm.Vec2f {
+        return self.segmentTangent(self.findSegment(std.math.clamp(l, 0.0, self.Length)));
+    }
+
+    ///Index of the segment (Points[i] to Points[i + 1]) that _l_ falls in. Zero length segments are never returned
+    ///unless the whole path is one.
+    fn findSegment(self: *const Path, l: f32) usize {
+        const lengths = self.CumulativeLengths;
+
+        //Last point at or before _l_
+        var low: usize = 0;
+        var high: usize = lengths.len;
+
+        while (low < high) {
+            const mid = low + (high - low) / 2;
+
+            if (lengths[mid] <= l) {
+                low = mid + 1;
+            } else {
+                high = mid;
+            }
+        }
+
+        return std.math.clamp(low -| 1, 0, lengths.len - 2);
+    }
+
+    inline fn positionInSegment(self: *const Path, segment: usize, l: f32) zm.Vec2f {
+        const start = self.CumulativeLengths[segment];
+        const segment_length = self.CumulativeLengths[segment + 1] - start;
+
+        if (segment_length <= 0.0)
+            return self.Points[segment];
+
+        return zm.vec.lerp(self.Points[segment], self.Points[segment + 1], (l - start) / segment_length);
+    }
+
+    inline fn segmentTangent(self: *const Path, segment: usize) zm.Vec2f {
+        const direction = self.Points[segment + 1] - self.Points[segment];
+        const segment_length = self.CumulativeLengths[segment + 1] - self.CumulativeLengths[segment];
+
+        if (segment_length <= 0.0)
+            return .{ 0.0, 0.0 };
+
+        return direction / zm.Vec2f{ segment_length, segment_length };
+    }
+
+    pub fn CalculateLength(points: []const zm.Vec2f) f32 {
+        var length: f32 = 0.0;
+        for (0..points.len - 1) |i| {
+            length += zm.vec.distance(points[i], points[i + 1]);
+        }
+
+        return length;
+    }
+
+    pub fn CalculateBounds(points: []const zm.Vec2f) zm.Vec4f {
+        var xmin = std.math.floatMax(f32);
+        var xmax: f32 = 0.0;
+        var ymin = std.math.floatMax(f32);
+        var ymax: f32 = 0.0;
+
+        for (points) |current| {
+            if (xmin > current[0])
+                xmin = current[0];
+
+            if (ymin > current[1])
+                ymin = current[1];
+
+            if (xmax < current[0])
+                xmax = current[0];
+
+            if (ymax < current[1])
+                ymax = current[1];
+        }
+
+        return .{ xmin, ymin, xmax, ymax };
+    }
+};
+
+///Remembers the segment of the last query, so a sequence of queries that only moves a little each time (slider ball,
+///ticks, follow circle tracking) is O(1) per query instead of a binary search. Works in both directions, big jumps
+///fall back to the search. Doesn't hold on to the path, it's passed to every call.
+pub const PathCursor = struct {
+    m_Segment: usize = 0,
+
+    pub fn PositionAt(self: *PathCursor, path: *const Path, l: f32) zm.Vec2f {
+        if (l <= 0)
+            return path.Points[0];
+
+        if (l >= path.Length)
+            return path.Points[path.Points.len - 1];
+
+        return path.positionInSegment(self.seek(path, l), l);
+    }
+
+    pub fn PositionAtProgress(self: *PathCursor, path: *const Path, progress: f32) zm.Vec2f {
+        return self.PositionAt(path, path.Length * progress);
+    }
+
+    pub fn TangentAt(self: *PathCursor, path: *const Path, l: f32) zm.Vec2f {
+        return path.segmentTangent(self.seek(path, std.math.clamp(l, 0.0, path.Length)));
+    }
+
+    ///Index of the segment (Points[i] to Points[i + 1]) that _l_ falls in
+    pub fn SegmentAt(self: *PathCursor, path: *const Path, l: f32) usize {
+        return self.seek(path, std.math.clamp(l, 0.0, path.Length));
+    }
+
+    fn seek(self: *PathCursor, path: *const Path, l: f32) usize {
+        const lengths = path.CumulativeLengths;
+        const last_segment = lengths.len - 2;
+
+        var segment = @min(self.m_Segment, last_segment);
+
+        for (0..Path.CURSOR_WALK_LIMIT) |_| {
+            if (segment < last_segment and lengths[segment + 1] <= l) {
+                segment += 1;
+            } else if (segment > 0 and lengths[segment] > l) {
+                segment -= 1;
+            } else {
+                self.m_Segment = segment;
+                return segment;
+            }
+        }
+
+        self.m_Segment = path.findSegment(l);
+        return self.m_Segment;
+    }
+};
+
+///How finely BuildPointsDetailed flattens, the defaults are osu!'s
+pub const FlattenDetail = struct {
+    Tolerance: CurveApproximator.Tolerance = .{},
+    CatmullDetail: i32 = 50,
+    //Anything but Scalar moves the points, only for paths that are just drawn
+    Kernel: CurveApproximator.Kernel = .Scalar,
+
+    ///Whether a path flattened at _self_ is at least as fine as _detail_ asks for, the kernel aside
+    pub fn Satisfies(self: FlattenDetail, detail: FlattenDetail) bool {
+        return self.Tolerance.Bezier <= detail.Tolerance.Bezier and self.Tolerance.CircularArc <= detail.Tolerance.CircularArc and self.CatmullDetail >= detail.CatmullDetail;
+    }
+};
+
+///Flattens a slider's control points into a polyline (osu pixels) trimmed to its PixelLength, caller owns the returned slice.
+///Doesn't touch GL so it can be used from the headless tools and from worker threads.
+pub fn BuildPoints(allocator: std.mem.Allocator, hit_object: HitObject) ![]zm.Vec2f {
+    return BuildPointsDetailed(allocator, hit_object, .{});
+}
+
+pub fn BuildPointsDetailed(allocator: std.mem.Allocator, hit_object: HitObject, detail: FlattenDetail) ![]zm.Vec2f {
+    var cp_temp_buffer = std.ArrayList(zm.Vec2f).init(allocator);
+    defer cp_temp_buffer.deinit();
+    var full_path_buffer = std.ArrayList(zm.Vec2f).init(allocator);
+    errdefer full_path_buffer.deinit();
+
+    const head = zm.Vec2f{ @floatFromInt(hit_object.X), @floatFromInt(hit_object.Y) };
+
+    //Add the start todo just do this in the parser lol.
+    try cp_temp_buffer.append(head);
+
+    const slider_points = hit_object.HitSlider.?.CurvePoints.items;
+
+    const slider_type: SliderType = hit_object.HitSlider.?.Type;
+
+    //One scratch region big enough for any segment, the approximators themselves never allocate
+    const scratch = try allocator.alloc(zm.Vec2f, CurveApproximator.ScratchSize(slider_points.len + 1));
+    defer allocator.free(scratch);
+
+    try cp_temp_buffer.ensureTotalCapacity(slider_points.len + 1);
+
+    for (slider_points, 0..slider_points.len) |now, i| {
+        const next = slider_points[@min(i + 1, slider_points.len - 1)];
+
+        try cp_temp_buffer.append(zm.Vec2f{ @floatFromInt(now.X), @floatFromInt(now.Y) });
+
+        if (now.X == next.X and now.Y == next.Y) {
+            if (cp_temp_buffer.items.len < 2) {
+                continue;
+            }
+
+            try appendSegment(&full_path_buffer, slider_type, cp_temp_buffer.items, scratch, detail);
+
+            cp_temp_buffer.clearRetainingCapacity();
+        }
+    }
+
+    //Sliders without any curve points still need a drawable path
+    while (full_path_buffer.items.len < 2) {
+        try full_path_buffer.append(head);
+    }
+
+    //trim path
+    var target_length = hit_object.HitSlider.?.PixelLength;
+    const items = full_path_buffer.items;
+    for (0..items.len - 1) |i| {
+        const dist = zm.vec.distance(items[i], items[i + 1]);
+
+        if (target_length - dist <= 0) {
+            const blend = target_length / dist;
+
+            const final_point_adjusted = zm.vec.lerp(items[i], items[i + 1], blend);
+
+            full_path_buffer.shrinkRetainingCapacity(i + 1);
+            try full_path_buffer.append(final_point_adjusted);
+            break;
+        }
+
+        target_length -= dist;
+    }
+
+    return try full_path_buffer.toOwnedSlice();
+}
+
+///Flattens one segment straight into the unused capacity of _full_path_, only growing the list if it doesn't fit
+fn appendSegment(full_path: *std.ArrayList(zm.Vec2f), slider_type: SliderType, control_points: []const zm.Vec2f, scratch: []zm.Vec2f, detail: FlattenDetail) !void {
+    try full_path.ensureUnusedCapacity(control_points.len * 4 + 16);
+
+    while (true) {
+        const output = full_path.unusedCapacitySlice();
+
+        const segment = approximateSegment(slider_type, control_points, output, scratch, detail) catch |err| switch (err) {
+            error.OutputTooSmall => {
+                try full_path.ensureUnusedCapacity(output.len * 2);
+                continue;
+            },
+            else => return err,
+        };
+
+        full_path.items.len += segment.len;
+        return;
+    }
+}
+
+fn approximateBezier(control_points: []const zm.Vec2f, output: []zm.Vec2f, scratch: []zm.Vec2f, detail: FlattenDetail) CurveApproximator.Error![]zm.Vec2f {
+    return switch (detail.Kernel) {
+        inline else => |kernel| CurveApproximator.approximateBSplineIntoKernel(kernel, control_points, 0, output, scratch, detail.Tolerance),
+    };
+}
+
+fn approximateSegment(slider_type: SliderType, control_points: []const zm.Vec2f, output: []zm.Vec2f, scratch: []zm.Vec2f, detail: FlattenDetail) CurveApproximator.Error![]zm.Vec2f {
+    return switch (slider_type) {
+        //2 point path is just a straight one so just add the control points as-is
+        .Bezier => if (control_points.len >= 3)
+            approximateBezier(control_points, output, scratch, detail)
+        else
+            CurveApproximator.approximateLinearInto(control_points, output),
+        .Linear => CurveApproximator.approximateLinearInto(control_points, output),
+        //osu! only treats 3 point sliders as arcs, anything else is a bezier. The flattening in DrawableHitSlider this
+        //replaced hit a @breakpoint under 3 points and handed more than 3 to the arc code.
+        .PerfectCircle => if (control_points.len == 3)
+            CurveApproximator.approximateCircularArcInto(control_points, output, scratch, detail.Tolerance)
+        else
+            approximateBezier(control_points, output, scratch, detail),
+        //Too short for a spline, a straight line like a 2 point bezier. Used to be a @breakpoint as well.
+        .Catmull => if (control_points.len < 3)
+            CurveApproximator.approximateLinearInto(control_points, output)
+        else
+            CurveApproximator.approximateCatmullInto(control_points, detail.CatmullDetail, output),
+    };
+}
+
+//Lengths 0, 10, 10, 30, 50, the second segment has no length
+const TEST_POINTS = [_]zm.Vec2f{ .{ 0.0, 0.0 }, .{ 10.0, 0.0 }, .{ 10.0, 0.0 }, .{ 10.0, 20.0 }, .{ 30.0, 20.0 } };
+
+test "findSegment picks the segment a distance falls in and skips zero length ones" {
+    var path = try Path.Init(std.testing.allocator, &TEST_POINTS, 0.0);
+    defer path.Deinit(std.testing.allocator);
+
+    try std.testing.expectEqual(@as(f32, 50.0), path.Length);
+
+    try std.testing.expectEqual(@as(usize, 0), path.findSegment(-5.0));
+    try std.testing.expectEqual(@as(usize, 0), path.findSegment(0.0));
+    try std.testing.expectEqual(@as(usize, 0), path.findSegment(9.9));
+    try std.testing.expectEqual(@as(usize, 2), path.findSegment(10.0));
+    try std.testing.expectEqual(@as(usize, 2), path.findSegment(29.9));
+    try std.testing.expectEqual(@as(usize, 3), path.findSegment(30.0));
+    try std.testing.expectEqual(@as(usize, 3), path.findSegment(50.0));
+    try std.testing.expectEqual(@as(usize, 3), path.findSegment(500.0));
+
+    try std.testing.expectEqual(zm.Vec2f{ 10.0, 10.0 }, path.CalculatePositionAt(20.0));
+    try std.testing.expectEqual(zm.Vec2f{ 0.0, 1.0 }, path.CalculateTangentAt(20.0));
+    try std.testing.expectEqual(TEST_POINTS[4], path.CalculatePositionAt(60.0));
+}
+
+test "PathCursor.seek agrees with findSegment whichever way it moves" {
+    const allocator = std.testing.allocator;
+
+    //Long enough that a jump is more than a cursor walks
+    var points: [64]zm.Vec2f = undefined;
+    for (&points, 0..) |*point, i| {
+        const x: f32 = @floatFromInt(i / 2);
+        point.* = .{ x * 10.0, if (i % 4 < 2) 0.0 else 10.0 };
+    }
+
+    var path = try Path.Init(allocator, &points, 0.0);
+    defer path.Deinit(allocator);
+
+    var cursor = PathCursor{};
+
+    const steps = [_]f32{ 0.0, 0.5, 3.0, 7.0, 2.0 };
+    var l: f32 = 0.0;
+
+    //Small steps forwards and backwards, then big jumps both ways
+    while (l < path.Length) : (l += 1.5) {
+        for (steps) |offset| {
+            const at = @min(l + offset, path.Length);
+            try std.testing.expectEqual(path.findSegment(at), cursor.seek(&path, at));
+        }
+    }
+
+    for ([_]f32{ 0.0, path.Length, 1.0, path.Length * 0.5, path.Length * 0.25, path.Length - 1.0, 0.0 }) |at| {
+        try std.testing.expectEqual(path.findSegment(at), cursor.seek(&path, at));
+        try std.testing.expectEqual(path.CalculatePositionAt(at), cursor.PositionAt(&path, at));
+    }
+}
+
+test "FlattenDetail.Satisfies only accepts paths at least as fine, whatever the kernel" {
+    const default = FlattenDetail{};
+    const coarser = FlattenDetail{ .Tolerance = .{ .Bezier = 1.0, .CircularArc = 0.5 }, .CatmullDetail = 20, .Kernel = .Simd };
+    const finer = FlattenDetail{ .Tolerance = .{ .Bezier = 0.05, .CircularArc = 0.02 }, .CatmullDetail = 80, .Kernel = .Simd };
+
+    try std.testing.expect(default.Satisfies(default));
+    try std.testing.expect(default.Satisfies(coarser));
+    try std.testing.expect(!default.Satisfies(finer));
+    try std.testing.expect(finer.Satisfies(default));
+
+    //One coarser setting is enough to need another flattening
+    var mixed = coarser;
+    mixed.CatmullDetail = 80;
+    try std.testing.expect(!default.Satisfies(mixed));
+}
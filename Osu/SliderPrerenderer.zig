@@ -0,0 +1,105 @@
+//Builds slider drawables ahead of their spawn
+//Creating a slider flattens its path, builds and uploads its mesh and renders its body into the atlas. Done on the
+//frame the slider enters the preempt window that's a spike every time a few sliders spawn close together (kiai
+//streams of sliders). Instead every frame looks ahead on the timeline and creates the upcoming sliders in spawn order
+//until the frame's budget is spent, the spawn then only has to pick the finished drawable up. A slider that wasn't
+//reached in time is still created on spawn like before.
+//The budget is CPU time: GLES2 has no timer queries, so the GPU side of a body render only shows up as the driver time
+//it costs here.
+
+const std = @import("std");
+
+const PlayableBeatmap = @import("PlayableBeatmap.zig").PlayableBeatmap;
+const DrawableHitSlider = @import("Drawables/DrawableHitSlider.zig").DrawableHitSlider;
+
+pub const SliderPrerenderer = struct {
+    const DEFAULT_BUDGET_NS: u64 = 1 * std.time.ns_per_ms;
+    //How far past the spawn point to look, enough to get through a kiai burst a few frames at a time
+    const LOOKAHEAD_MS: f64 = 1500.0;
+
+    const Prerendered = struct {
+        ObjectIndex: usize,
+        Slider: *DrawableHitSlider,
+    };
+
+    //In object order, so also in spawn order
+    m_Ready: std.ArrayList(Prerendered),
+    //Next hit object to look at
+    m_NextIndex: usize = 0,
+    m_BudgetNs: u64 = DEFAULT_BUDGET_NS,
+
+    pub fn Init(allocator: std.mem.Allocator) SliderPrerenderer {
+        return .{
+            .m_Ready = std.ArrayList(Prerendered).init(allocator),
+        };
+    }
+
+    pub fn Deinit(self: *SliderPrerenderer) void {
+        self.Reset(0);
+        self.m_Ready.deinit();
+    }
+
+    ///Drops everything prerendered and starts looking ahead from _object_index_ again
+    pub fn Reset(self: *SliderPrerenderer, object_index: usize) void {
+        for (self.m_Ready.items) |prerendered| {
+            prerendered.Slider.Discard();
+        }
+
+        self.m_Ready.clearRetainingCapacity();
+        self.m_NextIndex = object_index;
+    }
+
+    ///0 turns prerendering off, everything gets created on spawn
+    pub fn SetBudget(self: *SliderPrerenderer, budget_ns: u64) void {
+        self.m_BudgetNs = budget_ns;
+    }
+
+    ///The drawable prerendered for _object_index_, null if it wasn't reached yet
+    pub fn Take(self: *SliderPrerenderer, object_index: usize) ?*DrawableHitSlider {
+        //Anything before it was skipped over and will never spawn
+        while (self.m_Ready.items.len > 0 and self.m_Ready.items[0].ObjectIndex < object_index) {
+            self.m_Ready.orderedRemove(0).Slider.Discard();
+        }
+
+        if (self.m_Ready.items.len > 0 and self.m_Ready.items[0].ObjectIndex == object_index)
+            return self.m_Ready.orderedRemove(0).Slider;
+
+        return null;
+    }
+
+    ///Creates upcoming sliders of _beatmap_ in spawn order until the budget is spent. _first_unspawned_ is the next
+    ///object to spawn, _song_pos_ the current time in ms.
+    pub fn Run(self: *SliderPrerenderer, allocator: std.mem.Allocator, beatmap: *const PlayableBeatmap, first_unspawned: usize, song_pos: f64) void {
+        if (self.m_BudgetNs == 0)
+            return;
+
+        const hit_objects = beatmap.Beatmap.HitObjects.items;
+        const start = std.time.Instant.now() catch return;
+
+        self.m_NextIndex = @max(self.m_NextIndex, first_unspawned);
+
+        while (self.m_NextIndex < hit_objects.len) {
+            const hit_object = hit_objects[self.m_NextIndex];
+
+            const spawn_time: f64 = @floatFromInt(hit_object.StartTime - beatmap.Preempt);
+            if (spawn_time > song_pos + LOOKAHEAD_MS)
+                break;
+
+            if (hit_object.HitSlider != null) {
+                //Layer is set on spawn
+                const slider = DrawableHitSlider.New(allocator, hit_object, self.m_NextIndex, beatmap, .{ 0.0, 0.0 }, 0);
+
+                self.m_Ready.append(.{ .ObjectIndex = self.m_NextIndex, .Slider = slider }) catch {
+                    slider.Discard();
+                    return;
+                };
+            }
+
+            self.m_NextIndex += 1;
+
+            const now = std.time.Instant.now() catch return;
+            if (now.since(start) >= self.m_BudgetNs)
+                break;
+        }
+    }
+};
@@ -0,0 +1,428 @@
+//Live spectating over a unix domain socket
+
+//The playing instance runs a SpectatorHost, which hooks into the ReplayRecorder's consumer thread and streams new frames
+//as they get recorded. A second instance connects with a SpectatorViewer and plays them through a ReplayPlayer,
+//staying a bit behind the newest frame so small hiccups in the stream don't show.
+//
+//Stream layout:
+//  header: "ZSPC", version u8, beatmap md5 (32 ascii hex bytes)
+//  batch:  payload length u32 LE, then frames
+//  frame:  uleb128 time delta (ms), zigzag uleb128 x/y delta (1/16 osu pixels), uleb128 button mask
+//Deltas are against the previous frame in the stream so a typical frame is 4-6 bytes.
+
+const std = @import("std");
+
+const SpscRing = @import("../RingBuffer.zig").SpscRing;
+const Sound = @import("../Sound.zig").Sound;
+
+const ReplayFrame = @import("ReplayParser.zig").ReplayFrame;
+const FrameSink = @import("ReplayRecorder.zig").FrameSink;
+
+const MAGIC = "ZSPC";
+const VERSION: u8 = 1;
+const HEADER_SIZE = MAGIC.len + 1 + 32;
+const POSITION_SCALE: f32 = 16.0;
+//Keeps batches small even when a late viewer gets the whole backlog at once
+const MAX_FRAMES_PER_BATCH: usize = 256;
+const MAX_BATCH_SIZE: u32 = 64 * 1024;
+//About half an hour of 1000hz input, a viewer further behind than that gets dropped
+const MAX_PENDING_SIZE: usize = 8 * 1024 * 1024;
+
+const FrameCodec = struct {
+    PrevTime: u64 = 0,
+    PrevX: i32 = 0,
+    PrevY: i32 = 0,
+
+    fn encode(self: *FrameCodec, writer: anytype, frame: ReplayFrame) !void {
+        const x: i32 = @intFromFloat(@round(frame.X * POSITION_SCALE));
+        const y: i32 = @intFromFloat(@round(frame.Y * POSITION_SCALE));
+
+        try std.leb.writeUleb128(writer, frame.Time -| self.PrevTime);
+        try std.leb.writeUleb128(writer, zigzag(x -% self.PrevX));
+        try std.leb.writeUleb128(writer, zigzag(y -% self.PrevY));
+        try std.leb.writeUleb128(writer, frame.ButtonMask);
+
+        self.PrevTime = @max(self.PrevTime, frame.Time);
+        self.PrevX = x;
+        self.PrevY = y;
+    }
+
+    fn decode(self: *FrameCodec, reader: anytype) !ReplayFrame {
+        const delta = try std.leb.readUleb128(u64, reader);
+        const x = self.PrevX +% unzigzag(try std.leb.readUleb128(u32, reader));
+        const y = self.PrevY +% unzigzag(try std.leb.readUleb128(u32, reader));
+        const button_mask = try std.leb.readUleb128(u32, reader);
+
+        self.PrevTime += delta;
+        self.PrevX = x;
+        self.PrevY = y;
+
+        return .{
+            .Time = self.PrevTime,
+            .Delta = delta,
+            .X = @as(f32, @floatFromInt(x)) / POSITION_SCALE,
+            .Y = @as(f32, @floatFromInt(y)) / POSITION_SCALE,
+            .ButtonMask = button_mask,
+        };
+    }
+
+    inline fn zigzag(value: i32) u32 {
+        return @bitCast((value << 1) ^ (value >> 31));
+    }
+
+    inline fn unzigzag(value: u32) i32 {
+        return @as(i32, @bitCast(value >> 1)) ^ -@as(i32, @intCast(value & 1));
+    }
+};
+
+///Serves one viewer at a time, frames are encoded and sent from the recorder's consumer thread. Sends never block
+///that thread: what the socket doesn't take right away waits in a queue for the next batch.
+pub const SpectatorHost = struct {
+    m_Server: std.net.Server,
+    m_AcceptThread: std.Thread,
+    m_Running: std.atomic.Value(bool) = std.atomic.Value(bool).init(true),
+    //Socket of the connected viewer or -1, set by the accept thread, cleared by the sender on error
+    m_Client: std.atomic.Value(std.posix.socket_t) = std.atomic.Value(std.posix.socket_t).init(-1),
+
+    //Sender (recorder consumer thread) only
+    //Socket that already got the header and backlog. A handle the sender hasn't seen yet is a new viewer, however soon
+    //after the accept thread published it frames arrive.
+    m_HeaderSentTo: std.posix.socket_t = -1,
+    m_Codec: FrameCodec = .{},
+    //Encoded bytes the viewer hasn't taken yet
+    m_Pending: std.ArrayList(u8),
+
+    m_BeatmapMD5: [32]u8,
+    m_SocketPath: []const u8,
+    m_Allocator: std.mem.Allocator,
+
+    pub fn Start(allocator: std.mem.Allocator, socket_path: []const u8, beatmap_md5: [32]u8) !*SpectatorHost {
+        //A previous run might have left the socket file behind
+        std.fs.cwd().deleteFile(socket_path) catch {};
+
+        const address = try std.net.Address.initUnix(socket_path);
+
+        const self = try allocator.create(SpectatorHost);
+        errdefer allocator.destroy(self);
+
+        self.* = .{
+            .m_Server = try address.listen(.{}),
+            .m_AcceptThread = undefined,
+            .m_Pending = try std.ArrayList(u8).initCapacity(allocator, MAX_BATCH_SIZE),
+            .m_BeatmapMD5 = beatmap_md5,
+            .m_SocketPath = try allocator.dupe(u8, socket_path),
+            .m_Allocator = allocator,
+        };
+
+        self.m_AcceptThread = try std.Thread.spawn(.{}, acceptLoop, .{self});
+
+        std.debug.print("Spectator host listening on {s}\n", .{socket_path});
+
+        return self;
+    }
+
+    pub fn Deinit(self: *SpectatorHost) void {
+        self.m_Running.store(false, .release);
+
+        //Wakes the accept thread up
+        std.posix.shutdown(self.m_Server.stream.handle, .both) catch {};
+        self.m_AcceptThread.join();
+        self.m_Server.deinit();
+
+        const client = self.m_Client.swap(-1, .acq_rel);
+        if (client >= 0)
+            std.posix.close(client);
+
+        std.fs.cwd().deleteFile(self.m_SocketPath) catch {};
+
+        self.m_Pending.deinit();
+        self.m_Allocator.free(self.m_SocketPath);
+        self.m_Allocator.destroy(self);
+    }
+
+    pub fn GetSink(self: *SpectatorHost) FrameSink {
+        return .{ .Context = self, .OnFrames = onFrames };
+    }
+
+    fn acceptLoop(self: *SpectatorHost) void {
+        while (self.m_Running.load(.acquire)) {
+            const connection = self.m_Server.accept() catch return;
+
+            //Only one viewer, anyone else gets hung up on
+            if (self.m_Client.cmpxchgStrong(-1, connection.stream.handle, .acq_rel, .acquire) != null) {
+                connection.stream.close();
+                continue;
+            }
+
+            std.debug.print("Spectator connected\n", .{});
+        }
+    }
+
+    fn onFrames(context: *anyopaque, frames: []const ReplayFrame, new_from: usize) void {
+        const self: *SpectatorHost = @ptrCast(@alignCast(context));
+
+        const client = self.m_Client.load(.acquire);
+        if (client < 0)
+            return;
+
+        var first = new_from;
+
+        //A fresh viewer gets the header and everything recorded so far
+        if (client != self.m_HeaderSentTo) {
+            self.m_HeaderSentTo = client;
+            self.m_Codec = .{};
+            self.m_Pending.clearRetainingCapacity();
+            first = 0;
+
+            var header: [HEADER_SIZE]u8 = undefined;
+            @memcpy(header[0..MAGIC.len], MAGIC);
+            header[MAGIC.len] = VERSION;
+            @memcpy(header[MAGIC.len + 1 ..], &self.m_BeatmapMD5);
+
+            self.m_Pending.appendSlice(&header) catch {
+                self.dropClient(client);
+                return;
+            };
+        }
+
+        while (first < frames.len) {
+            const last = @min(first + MAX_FRAMES_PER_BATCH, frames.len);
+
+            //Half a batch in the queue would corrupt the stream, so a failure here loses the viewer too
+            self.encodeBatch(frames[first..last]) catch {
+                self.dropClient(client);
+                return;
+            };
+
+            first = last;
+        }
+
+        self.flush(client) catch {
+            self.dropClient(client);
+            return;
+        };
+
+        if (self.m_Pending.items.len > MAX_PENDING_SIZE) {
+            std.debug.print("Spectator can't keep up\n", .{});
+            self.dropClient(client);
+        }
+    }
+
+    ///Appends a batch to the queue
+    fn encodeBatch(self: *SpectatorHost, frames: []const ReplayFrame) !void {
+        const start = self.m_Pending.items.len;
+        errdefer self.m_Pending.shrinkRetainingCapacity(start);
+
+        //Length gets patched in once the payload is written
+        try self.m_Pending.appendNTimes(0, 4);
+
+        const writer = self.m_Pending.writer();
+        for (frames) |frame| {
+            try self.m_Codec.encode(writer, frame);
+        }
+
+        const payload_len: u32 = @intCast(self.m_Pending.items.len - start - 4);
+        std.mem.writeInt(u32, self.m_Pending.items[start..][0..4], payload_len, .little);
+    }
+
+    ///Sends as much of the queue as the socket takes without blocking, the rest stays queued
+    fn flush(self: *SpectatorHost, client: std.posix.socket_t) !void {
+        const pending = self.m_Pending.items;
+
+        var sent: usize = 0;
+        while (sent < pending.len) {
+            //No SIGPIPE if the viewer went away, just an error
+            sent += std.posix.send(client, pending[sent..], std.posix.MSG.DONTWAIT | std.posix.MSG.NOSIGNAL) catch |err| switch (err) {
+                error.WouldBlock => break,
+                else => return err,
+            };
+        }
+
+        std.mem.copyForwards(u8, pending[0 .. pending.len - sent], pending[sent..]);
+        self.m_Pending.shrinkRetainingCapacity(pending.len - sent);
+    }
+
+    fn dropClient(self: *SpectatorHost, client: std.posix.socket_t) void {
+        //The next viewer may well get the same handle back
+        self.m_HeaderSentTo = -1;
+        self.m_Pending.clearRetainingCapacity();
+
+        if (self.m_Client.cmpxchgStrong(client, -1, .acq_rel, .acquire) == null) {
+            std.posix.close(client);
+            std.debug.print("Spectator disconnected\n", .{});
+        }
+    }
+};
+
+///Receives frames on a reader thread and hands them to the game thread through an SPSC ring.
+///The song is the clock: the viewer keeps it between MIN_BUFFER_MS and MAX_BUFFER_MS behind the newest received frame
+///by pausing when the stream runs dry and playing slightly faster when it falls too far behind.
+pub const SpectatorViewer = struct {
+    const RING_CAPACITY: usize = 8192;
+    //Where playback aims to sit behind the newest frame
+    const BUFFER_DELAY_MS: f64 = 250.0;
+    const MIN_BUFFER_MS: f64 = 50.0;
+    const MAX_BUFFER_MS: f64 = 1000.0;
+    //Past this catching up by playing faster would take too long, just seek
+    const RESYNC_MS: f64 = 3000.0;
+    const CATCH_UP_RATE: f32 = 1.05;
+
+    m_Stream: std.net.Stream,
+    m_Thread: std.Thread,
+    m_Ring: SpscRing(ReplayFrame),
+    m_Connected: std.atomic.Value(bool) = std.atomic.Value(bool).init(true),
+    m_HeaderReceived: std.atomic.Value(bool) = std.atomic.Value(bool).init(false),
+    m_BeatmapMD5: [32]u8 = [_]u8{0} ** 32,
+
+    //Game thread only
+    m_Frames: std.ArrayList(ReplayFrame),
+    m_Started: bool = false,
+    m_Buffering: bool = false,
+    m_Rate: f32 = 1.0,
+
+    m_Allocator: std.mem.Allocator,
+
+    pub fn Connect(allocator: std.mem.Allocator, socket_path: []const u8) !*SpectatorViewer {
+        const self = try allocator.create(SpectatorViewer);
+        errdefer allocator.destroy(self);
+
+        const stream = try std.net.connectUnixSocket(socket_path);
+        errdefer stream.close();
+
+        self.* = .{
+            .m_Stream = stream,
+            .m_Thread = undefined,
+            .m_Ring = try SpscRing(ReplayFrame).Init(allocator, RING_CAPACITY),
+            .m_Frames = std.ArrayList(ReplayFrame).init(allocator),
+            .m_Allocator = allocator,
+        };
+
+        self.m_Thread = try std.Thread.spawn(.{}, readLoop, .{self});
+
+        std.debug.print("Spectating {s}\n", .{socket_path});
+
+        return self;
+    }
+
+    pub fn Deinit(self: *SpectatorViewer) void {
+        //Unblocks the reader
+        std.posix.shutdown(self.m_Stream.handle, .both) catch {};
+        self.m_Thread.join();
+        self.m_Stream.close();
+
+        self.m_Ring.Deinit();
+        self.m_Frames.deinit();
+        self.m_Allocator.destroy(self);
+    }
+
+    ///Null until the host's header has arrived
+    pub fn GetBeatmapMD5(self: *const SpectatorViewer) ?[]const u8 {
+        if (!self.m_HeaderReceived.load(.acquire))
+            return null;
+
+        return &self.m_BeatmapMD5;
+    }
+
+    ///Moves everything the reader has received into the frame list, returns all frames so far.
+    ///The slice is only valid until the next Poll.
+    pub fn Poll(self: *SpectatorViewer) []const ReplayFrame {
+        while (self.m_Ring.Pop()) |frame| {
+            self.m_Frames.append(frame) catch break;
+        }
+
+        return self.m_Frames.items;
+    }
+
+    ///Rate SyncClock last set on the song, catching up included
+    pub fn GetRate(self: *const SpectatorViewer) f32 {
+        return self.m_Rate;
+    }
+
+    ///Keeps _song_ a bounded distance behind the stream, _base_rate_ is the rate the user picked
+    pub fn SyncClock(self: *SpectatorViewer, song: *Sound, base_rate: f32) void {
+        const frames = self.m_Frames.items;
+        if (frames.len == 0) {
+            if (song.IsPlaying())
+                song.Pause();
+            return;
+        }
+
+        const newest: f64 = @floatFromInt(frames[frames.len - 1].Time);
+        const position = song.GetPlaybackPositionInSeconds() * 1000.0;
+        const buffered = newest - position;
+
+        if (!self.m_Started or buffered > RESYNC_MS) {
+            self.m_Started = true;
+            self.m_Buffering = false;
+            song.SetPlaybackPositionSecs(@max(0.0, newest - BUFFER_DELAY_MS) / 1000.0);
+            song.Play(false);
+            return;
+        }
+
+        //Once the host is gone whatever is left just plays out
+        if (self.m_Connected.load(.acquire)) {
+            if (!self.m_Buffering and buffered < MIN_BUFFER_MS) {
+                self.m_Buffering = true;
+                song.Pause();
+            } else if (self.m_Buffering and buffered >= BUFFER_DELAY_MS) {
+                self.m_Buffering = false;
+                song.Play(false);
+            }
+        } else if (self.m_Buffering) {
+            self.m_Buffering = false;
+            song.Play(false);
+        }
+
+        const rate = if (buffered > MAX_BUFFER_MS) base_rate * CATCH_UP_RATE else base_rate;
+        if (rate != self.m_Rate) {
+            self.m_Rate = rate;
+            song.SetPlaybackRate(rate);
+        }
+    }
+
+    fn readLoop(self: *SpectatorViewer) void {
+        defer self.m_Connected.store(false, .release);
+
+        self.readStream() catch |err| switch (err) {
+            error.EndOfStream => std.debug.print("Spectator stream ended\n", .{}),
+            else => std.debug.print("Spectator stream error: {}\n", .{err}),
+        };
+    }
+
+    fn readStream(self: *SpectatorViewer) !void {
+        const reader = self.m_Stream.reader();
+
+        var header: [HEADER_SIZE]u8 = undefined;
+        try reader.readNoEof(&header);
+
+        if (!std.mem.eql(u8, header[0..MAGIC.len], MAGIC) or header[MAGIC.len] != VERSION)
+            return error.InvalidSpectatorHeader;
+
+        @memcpy(&self.m_BeatmapMD5, header[MAGIC.len + 1 ..]);
+        self.m_HeaderReceived.store(true, .release);
+
+        var codec = FrameCodec{};
+        const payload = try self.m_Allocator.alloc(u8, MAX_BATCH_SIZE);
+        defer self.m_Allocator.free(payload);
+
+        while (true) {
+            const payload_len = try reader.readInt(u32, .little);
+            if (payload_len > MAX_BATCH_SIZE)
+                return error.SpectatorBatchTooLarge;
+
+            try reader.readNoEof(payload[0..payload_len]);
+
+            var batch_stream = std.io.fixedBufferStream(payload[0..payload_len]);
+            const batch_reader = batch_stream.reader();
+
+            while (batch_stream.pos < payload_len) {
+                const frame = try codec.decode(batch_reader);
+
+                //The viewer must not lose frames, wait for the game thread to make room
+                while (!self.m_Ring.Push(frame)) {
+                    std.Thread.sleep(std.time.ns_per_ms);
+                }
+            }
+        }
+    }
+};
@@ -3,6 +3,8 @@ const std = @import("std");
 const HashMapType = std.StringHashMap(std.time.Instant);
 
 var _profileMap: ?HashMapType = null;
+//Beatmaps get parsed on worker threads too
+var _profileMutex: std.Thread.Mutex = .{};
 
 pub const Profiler = struct {
     fn getMap() *HashMapType {
@@ -14,6 +16,9 @@ pub const Profiler = struct {
     }
 
     pub fn Start(name: []const u8) void {
+        _profileMutex.lock();
+        defer _profileMutex.unlock();
+
         const map = getMap();
 
         const now = std.time.Instant.now() catch return;
@@ -24,6 +29,9 @@ pub const Profiler = struct {
     pub fn End(name: []const u8) void {
         const now = std.time.Instant.now() catch return;
 
+        _profileMutex.lock();
+        defer _profileMutex.unlock();
+
         const map = getMap();
 
         if (map.*.get(name)) |prev| {
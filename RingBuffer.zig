@@ -0,0 +1,70 @@
+const std = @import("std");
+
+///Bounded single producer / single consumer queue. Storage is allocated once up front, Push and Pop never allocate or lock,
+///so one thread (the game loop) can hand data to another without ever waiting on it.
+///Only one thread may call Push and only one (other) thread may call Pop.
+pub fn SpscRing(comptime T: type) type {
+    return struct {
+        const Self = @This();
+
+        //Kept on separate cache lines so the producer and consumer don't keep stealing the line from each other
+        m_Head: std.atomic.Value(usize) align(std.atomic.cache_line) = std.atomic.Value(usize).init(0),
+        m_Tail: std.atomic.Value(usize) align(std.atomic.cache_line) = std.atomic.Value(usize).init(0),
+
+        m_Items: []T,
+        m_Mask: usize,
+        m_Allocator: std.mem.Allocator,
+
+        ///_capacity_ gets rounded up to a power of two
+        pub fn Init(allocator: std.mem.Allocator, capacity: usize) !Self {
+            const real_capacity = try std.math.ceilPowerOfTwo(usize, @max(capacity, 2));
+
+            return .{
+                .m_Items = try allocator.alloc(T, real_capacity),
+                .m_Mask = real_capacity - 1,
+                .m_Allocator = allocator,
+            };
+        }
+
+        pub fn Deinit(self: *Self) void {
+            self.m_Allocator.free(self.m_Items);
+        }
+
+        ///Producer side, returns false if the ring is full (the item is not added)
+        pub fn Push(self: *Self, item: T) bool {
+            const head = self.m_Head.load(.monotonic);
+            const tail = self.m_Tail.load(.acquire);
+
+            if (head -% tail > self.m_Mask)
+                return false;
+
+            self.m_Items[head & self.m_Mask] = item;
+            self.m_Head.store(head +% 1, .release);
+
+            return true;
+        }
+
+        ///Consumer side
+        pub fn Pop(self: *Self) ?T {
+            const tail = self.m_Tail.load(.monotonic);
+            const head = self.m_Head.load(.acquire);
+
+            if (tail == head)
+                return null;
+
+            const item = self.m_Items[tail & self.m_Mask];
+            self.m_Tail.store(tail +% 1, .release);
+
+            return item;
+        }
+
+        ///Approximate when called while the other side is active
+        pub fn Len(self: *const Self) usize {
+            return self.m_Head.load(.acquire) -% self.m_Tail.load(.acquire);
+        }
+
+        pub fn Capacity(self: *const Self) usize {
+            return self.m_Items.len;
+        }
+    };
+}
@@ -7,23 +7,68 @@ const c = @import("../CImports.zig").c;
 const PlayableBeatmap = @import("../Osu/PlayableBeatmap.zig").PlayableBeatmap;
 const HitObject = @import("../Osu/OsuParser.zig").HitObject;
 
-const DrawableHitCircle = @import("../Osu/Drawables/DrawableHitCircle.zig").DrawableHitCircle;
+const HitCircleRenderer = @import("../Osu/HitCircleRenderer.zig").HitCircleRenderer;
 const DrawableHitSlider = @import("../Osu/Drawables/DrawableHitSlider.zig").DrawableHitSlider;
+const SliderRenderMode = @import("../Osu/Drawables/DrawableHitSlider.zig").SliderRenderMode;
+const SliderPrerenderer = @import("../Osu/SliderPrerenderer.zig").SliderPrerenderer;
 const DrawableManager = @import("../Drawables/DrawableManager.zig").DrawableManager;
 
 const Skin = @import("../Osu/Skin.zig").Skin;
 
+const Replay = @import("../Osu/ReplayParser.zig").Replay;
+const ReplayPlayer = @import("../Osu/ReplayPlayer.zig").ReplayPlayer;
+const ButtonMask = @import("../Osu/ReplayPlayer.zig").ButtonMask;
+const ReplayRecorder = @import("../Osu/ReplayRecorder.zig").ReplayRecorder;
+const ReplayCursorOverlay = @import("../Osu/ReplayCursorOverlay.zig").ReplayCursorOverlay;
+const SpectatorHost = @import("../Osu/Spectator.zig").SpectatorHost;
+const SpectatorViewer = @import("../Osu/Spectator.zig").SpectatorViewer;
+
+const Viewport = @import("../Easy2D/Viewport.zig").Viewport;
+const GameClock = @import("../GameClock.zig").GameClock;
+const zm = @import("zm");
+
 var _playScene: ?PlayScene = null;
 
 var _playingBeatmap: ?PlayableBeatmap = null;
 var _objectIndex: usize = 0;
 var _hitObjMan = DrawableManager.Init();
+//Circles aren't drawables, they go in between the sliders by layer
+var _hitCircles = HitCircleRenderer.Init(std.heap.c_allocator);
+var _sliderPrerenderer = SliderPrerenderer.Init(std.heap.c_allocator);
 
 var _drawableArenaAllocator = std.heap.ArenaAllocator.init(std.heap.c_allocator);
 var _drawableAllocator = _drawableArenaAllocator.allocator();
 
 var _skin: ?Skin = null;
 
+var _replay: ?Replay = null;
+var _replayPlayer: ?ReplayPlayer = null;
+var _playbackRate: f32 = 1.0;
+//The song time everything reads this frame, sampled once in OnUpdate
+var _clock = GameClock{};
+
+var _cursorOverlay: ?ReplayCursorOverlay = null;
+
+var _spectatorHost: ?*SpectatorHost = null;
+var _spectatorViewer: ?*SpectatorViewer = null;
+
+//Recording happens whenever a replay isn't being watched
+var _recorder: ?*ReplayRecorder = null;
+var _recordingFinished = false;
+var _recordCursor: zm.Vec2f = .{ 0.0, 0.0 };
+var _recordKeys: u32 = 0;
+var _recordMouse: u32 = 0;
+//Song time and SDL ticks sampled once per update, input events are timestamped relative to these
+var _frameSongTimeMs: f64 = 0.0;
+var _frameTicksMs: u32 = 0;
+
+const CURSOR_TRAIL_LENGTH: usize = 12;
+//How long after the last object the recording gets saved
+const RECORD_END_DELAY_MS: f64 = 1000.0;
+const REPLAY_DIR = "replays";
+const MIN_PLAYBACK_RATE: f32 = 0.25;
+const MAX_PLAYBACK_RATE: f32 = 2.0;
+
 pub const PlayScene = struct {
     pub fn GetInstance() *PlayScene {
         if (_playScene == null) {
@@ -48,6 +93,77 @@ pub const PlayScene = struct {
         return &_skin.?;
     }
 
+    ///Song time for this frame, drawables read it instead of asking the song
+    pub fn GetClock() *const GameClock {
+        return &_clock;
+    }
+
+    ///Plays _replay_ back against the loaded beatmap, the scene takes ownership of it
+    pub fn SetReplay(replay: Replay) void {
+        if (_replay) |*old_replay| {
+            old_replay.Deinit();
+        }
+
+        _replay = replay;
+        _replayPlayer = ReplayPlayer.Init(_replay.?.ReplayFrames.items);
+
+        std.debug.print("Playing replay by {s} ({d} frames)\n", .{ replay.ReplayInfo.PlayerName, replay.ReplayFrames.items.len });
+    }
+
+    ///Call after changing the quality profile. The beatmap's slider paths are gameplay and don't depend on it, but the
+    ///sliders created ahead of their spawn have bodies at the old detail.
+    pub fn RefreshSliderBodies() void {
+        _sliderPrerenderer.Reset(_objectIndex);
+    }
+
+    ///CPU time per frame spent creating upcoming sliders ahead of their spawn, 0 creates them on spawn
+    pub fn SetSliderPrerenderBudget(budget_ms: f32) void {
+        _sliderPrerenderer.SetBudget(@intFromFloat(@max(budget_ms, 0.0) * std.time.ns_per_ms));
+    }
+
+    ///Streams whatever gets recorded from now on to a viewer connecting to _socket_path_
+    pub fn StartSpectatorHost(socket_path: []const u8) void {
+        if (_spectatorHost != null)
+            return;
+
+        _spectatorHost = SpectatorHost.Start(std.heap.c_allocator, socket_path, _playingBeatmap.?.Beatmap.MD5Hash) catch |err| {
+            std.debug.print("Couldn't start spectator host on {s}: {}\n", .{ socket_path, err });
+            return;
+        };
+    }
+
+    ///Watches another instance's live play, the song follows the incoming stream instead of the other way around
+    pub fn StartSpectating(socket_path: []const u8) void {
+        if (_spectatorViewer != null)
+            return;
+
+        _spectatorViewer = SpectatorViewer.Connect(std.heap.c_allocator, socket_path) catch |err| {
+            std.debug.print("Couldn't connect to spectator host {s}: {}\n", .{ socket_path, err });
+            return;
+        };
+
+        _replayPlayer = ReplayPlayer.Init(&.{});
+        _playingBeatmap.?.Song.Pause();
+    }
+
+    ///Adds _replay_'s cursor to the multi replay overlay, the replay is freed once its frames have been copied
+    pub fn AddOverlayReplay(replay: Replay) void {
+        var owned_replay = replay;
+        defer owned_replay.Deinit();
+
+        if (_cursorOverlay == null) {
+            _cursorOverlay = ReplayCursorOverlay.Init(std.heap.c_allocator);
+        }
+
+        if (!std.mem.eql(u8, replay.ReplayInfo.BeatmapMD5Hash, &_playingBeatmap.?.Beatmap.MD5Hash)) {
+            std.debug.print("Overlay replay by {s} is for a different map\n", .{replay.ReplayInfo.PlayerName});
+        }
+
+        _cursorOverlay.?.Add(replay.ReplayFrames.items) catch |err| {
+            std.debug.print("Couldn't add overlay replay: {}\n", .{err});
+        };
+    }
+
     //Doesnt really need a ptr to self since the instance is a singleton
     fn OnEnter() void {
         std.debug.print("{s}.OnEnter: Hello :D\n", .{@typeName(@This())});
@@ -58,6 +174,7 @@ pub const PlayScene = struct {
             _objectIndex = 0;
             const k: f64 = @floatFromInt(_playingBeatmap.?.Beatmap.HitObjects.items[_objectIndex].StartTime - 1000);
             _playingBeatmap.?.Song.SetPlaybackPositionSecs(k / 1000.0);
+            _clock.Snap();
         }
 
         if (_skin == null) {
@@ -67,10 +184,19 @@ pub const PlayScene = struct {
         //GetInstance()...
     }
 
-    fn OnExit() void {}
+    fn OnExit() void {
+        finishRecording();
+    }
 
     fn OnUpdate(delta: f32) void {
-        const pos = _playingBeatmap.?.Song.GetPlaybackPositionInSeconds() * 1000.0;
+        if (_spectatorViewer) |viewer| {
+            _replayPlayer.?.Frames = viewer.Poll();
+            viewer.SyncClock(&_playingBeatmap.?.Song, _playbackRate);
+            _clock.SetRate(viewer.GetRate());
+        }
+
+        _clock.Update(&_playingBeatmap.?.Song);
+        const pos = _clock.GetTimeMs();
         const hit_objs = _playingBeatmap.?.Beatmap.HitObjects.items;
 
         if (_objectIndex < hit_objs.len) {
@@ -80,21 +206,12 @@ pub const PlayScene = struct {
                 const layer: i32 = 727_727 - @as(i32, @intCast(_objectIndex));
 
                 if (obj_to_spawn.HitCircle != null) {
-                    //This boy is on the stack and is gonna get destroyed
-                    //was**
-                    var drawable_hs = _drawableAllocator.create(DrawableHitCircle) catch unreachable;
-                    drawable_hs.Beatmap = &_playingBeatmap.?;
-                    drawable_hs.IsDead = false;
-                    drawable_hs.Layer = layer;
-                    drawable_hs.Alpha = 0.0;
-                    drawable_hs.HitCircle = obj_to_spawn;
-
-                    const data = drawable_hs.GetData();
-
-                    _hitObjMan.Add(data) catch {};
+                    _hitCircles.Add(&obj_to_spawn, layer);
                 } else if (obj_to_spawn.HitSlider != null) {
                     //if (obj_to_spawn.HitSlider.?.Type == .Bezier) {
-                    var drawable_slider = DrawableHitSlider.New(_drawableAllocator, obj_to_spawn, &_playingBeatmap.?, .{ 0.0, 0.0 }, layer);
+                    //Usually built a few frames ago by the prerenderer, only a late one gets built on the spot
+                    const drawable_slider = _sliderPrerenderer.Take(_objectIndex) orelse DrawableHitSlider.New(_drawableAllocator, obj_to_spawn, _objectIndex, &_playingBeatmap.?, .{ 0.0, 0.0 }, layer);
+                    drawable_slider.Layer = layer;
 
                     const data = drawable_slider.GetData();
 
@@ -109,25 +226,204 @@ pub const PlayScene = struct {
                     break;
             }
         }
+        _sliderPrerenderer.Run(_drawableAllocator, &_playingBeatmap.?, _objectIndex, pos);
+
         _hitObjMan.Update(delta);
+
+        if (_replayPlayer) |*replay_player| {
+            replay_player.Update(pos);
+        }
+
+        if (_cursorOverlay) |*overlay| {
+            overlay.Update(pos);
+        }
+
+        _frameSongTimeMs = pos;
+        _frameTicksMs = c.SDL_GetTicks();
+
+        if (_recorder != null and hit_objs.len > 0 and pos > @as(f64, @floatFromInt(hit_objs[hit_objs.len - 1].GetEndTime())) + RECORD_END_DELAY_MS) {
+            finishRecording();
+        }
     }
 
     fn OnDraw(g: *Graphics) void {
-        _hitObjMan.Draw(g);
+        DrawableHitSlider.BeginFrame();
+
+        _hitCircles.Animate(&_playingBeatmap.?, _clock.GetTimeMs());
+        _hitObjMan.DrawInterleaved(g, &_hitCircles, HitCircleRenderer.DrawBelowLayer);
+
+        if (_cursorOverlay) |*overlay| {
+            const skin = GetSkin();
+            overlay.Draw(g, &skin.Cursor.BackingTexture, &skin.CursorTrail.BackingTexture, _playingBeatmap.?.GetWorldCircleSize() * zm.Vec2f{ 0.75, 0.75 });
+        }
+
+        if (_replayPlayer) |*replay_player| {
+            drawReplayCursor(g, replay_player);
+        }
+    }
+
+    fn drawReplayCursor(g: *Graphics, replay_player: *const ReplayPlayer) void {
+        const TEXT_RECT: zm.Vec4f = .{ 0.0, 0.0, 1.0, 1.0 };
+        const skin = GetSkin();
+        const cursor_size = _playingBeatmap.?.GetWorldCircleSize();
+
+        //Trail is just the last few raw frames, walking backwards from the playhead
+        const frames = replay_player.Frames;
+        const frame_index = replay_player.GetFrameIndex();
+        const trail_count = @min(CURSOR_TRAIL_LENGTH, frame_index);
+
+        for (0..trail_count) |i| {
+            const frame = frames[frame_index - i];
+            const trail_alpha = 1.0 - @as(f32, @floatFromInt(i)) / @as(f32, @floatFromInt(CURSOR_TRAIL_LENGTH));
+            const trail_pos = PlayableBeatmap.MapToPlayfield2(frame.X, frame.Y);
+
+            g.DrawRectangleCentered(trail_pos, cursor_size * zm.Vec2f{ 0.5, 0.5 }, .{ 1.0, 1.0, 1.0, trail_alpha }, &skin.CursorTrail.BackingTexture, TEXT_RECT);
+        }
+
+        const cursor_pos = PlayableBeatmap.MapToPlayfield2(replay_player.Position[0], replay_player.Position[1]);
+        g.DrawRectangleCentered(cursor_pos, cursor_size * zm.Vec2f{ 0.75, 0.75 }, .{ 1.0, 1.0, 1.0, 1.0 }, &skin.Cursor.BackingTexture, TEXT_RECT);
+
+        //Key overlay on the right edge of the screen
+        const screen_size = Viewport.GetSizeF();
+        const KEY_SIZE: f32 = 32.0;
+        const key_masks = [_]u32{ ButtonMask.K1, ButtonMask.K2, ButtonMask.M1, ButtonMask.M2 };
+
+        for (key_masks, 0..) |mask, i| {
+            const key_pos = zm.Vec2f{ screen_size[0] - KEY_SIZE, screen_size[1] * 0.5 + (@as(f32, @floatFromInt(i)) - 1.5) * KEY_SIZE * 1.25 };
+            const key_color: zm.Vec4f = if (replay_player.IsDown(mask)) .{ 1.0, 0.8, 0.2, 1.0 } else .{ 0.3, 0.3, 0.3, 0.6 };
+
+            g.DrawRectangleCentered(key_pos, .{ KEY_SIZE, KEY_SIZE }, key_color, skin.DotTexture, TEXT_RECT);
+        }
+    }
+
+    fn setPlaybackRate(rate: f32) void {
+        _playbackRate = std.math.clamp(rate, MIN_PLAYBACK_RATE, MAX_PLAYBACK_RATE);
+        _playingBeatmap.?.Song.SetPlaybackRate(_playbackRate);
+        _clock.SetRate(_playbackRate);
+
+        std.debug.print("Playback rate: {d:.2}x\n", .{_playbackRate});
+    }
+
+    ///Turns mouse/key events into input samples for the recorder, the recorder is started on the first input
+    fn recordEvent(event: *const c.SDL_Event) void {
+        switch (event.type) {
+            c.SDL_MOUSEMOTION => {
+                _recordCursor = PlayableBeatmap.MapFromPlayfield(.{ @floatFromInt(event.motion.x), @floatFromInt(event.motion.y) });
+            },
+            c.SDL_MOUSEBUTTONDOWN, c.SDL_MOUSEBUTTONUP => {
+                const mask: u32 = switch (event.button.button) {
+                    c.SDL_BUTTON_LEFT => ButtonMask.M1,
+                    c.SDL_BUTTON_RIGHT => ButtonMask.M2,
+                    else => return,
+                };
+
+                if (event.type == c.SDL_MOUSEBUTTONDOWN) _recordMouse |= mask else _recordMouse &= ~mask;
+            },
+            c.SDL_KEYDOWN, c.SDL_KEYUP => {
+                if (event.key.repeat != 0)
+                    return;
+
+                //Keys always come together with their mouse button in .osr (K1 = 5, K2 = 10)
+                const mask: u32 = switch (event.key.keysym.scancode) {
+                    c.SDL_SCANCODE_Z => ButtonMask.K1 | ButtonMask.M1,
+                    c.SDL_SCANCODE_X => ButtonMask.K2 | ButtonMask.M2,
+                    else => return,
+                };
+
+                if (event.type == c.SDL_KEYDOWN) _recordKeys |= mask else _recordKeys &= ~mask;
+            },
+            else => return,
+        }
+
+        if (_recorder == null) {
+            if (_recordingFinished)
+                return;
+
+            const hit_objs = _playingBeatmap.?.Beatmap.HitObjects.items;
+            const duration_ms: u64 = if (hit_objs.len > 0) @intCast(@max(0, hit_objs[hit_objs.len - 1].GetEndTime())) else 0;
+
+            const sink = if (_spectatorHost) |host| host.GetSink() else null;
+
+            _recorder = ReplayRecorder.Start(std.heap.c_allocator, duration_ms, sink) catch |err| {
+                std.debug.print("Couldn't start replay recorder: {}\n", .{err});
+                _recordingFinished = true;
+                return;
+            };
+        }
+
+        //Events arrive before this frame's update, so offset from the last sampled song time by how much later they happened
+        const since_frame_ms: f64 = @floatFromInt(@as(i64, event.common.timestamp) - @as(i64, _frameTicksMs));
+
+        _recorder.?.Push(.{
+            .Time = _frameSongTimeMs + since_frame_ms * @as(f64, _playbackRate),
+            .X = _recordCursor[0],
+            .Y = _recordCursor[1],
+            .ButtonMask = _recordKeys | _recordMouse,
+        });
+    }
+
+    fn finishRecording() void {
+        const recorder = _recorder orelse return;
+        defer recorder.Deinit();
+
+        _recorder = null;
+        _recordingFinished = true;
+
+        var replay = recorder.Finish(&_playingBeatmap.?.Beatmap, 0, "zerosu") catch |err| {
+            std.debug.print("Couldn't finish replay: {}\n", .{err});
+            return;
+        };
+        defer replay.Deinit();
+
+        std.fs.cwd().makePath(REPLAY_DIR) catch {};
+
+        var path_buf: [256]u8 = undefined;
+        const path = std.fmt.bufPrint(&path_buf, "{s}/zerosu-{d}.osr", .{ REPLAY_DIR, std.time.milliTimestamp() }) catch unreachable;
+
+        replay.SaveToFile(std.heap.c_allocator, path) catch |err| {
+            std.debug.print("Couldn't save replay {s}: {}\n", .{ path, err });
+            return;
+        };
+
+        std.debug.print("Saved replay {s} ({d} frames, 300: {d} 100: {d} 50: {d} miss: {d})\n", .{
+            path,
+            replay.ReplayFrames.items.len,
+            replay.ReplayInfo.Count300,
+            replay.ReplayInfo.Count100,
+            replay.ReplayInfo.Count50,
+            replay.ReplayInfo.CountMiss,
+        });
     }
 
     fn OnEvent(event: *const c.SDL_Event) void {
         _ = _hitObjMan.OnEvent(event);
 
+        if (_replayPlayer == null and _cursorOverlay == null) {
+            recordEvent(event);
+        }
+
         if (event.type == c.SDL_KEYDOWN) {
             if (event.key.keysym.scancode == c.SDL_SCANCODE_SPACE) {
                 _playingBeatmap.?.Song.TogglePlay();
+            } else if (event.key.keysym.scancode == c.SDL_SCANCODE_UP) {
+                setPlaybackRate(_playbackRate + 0.25);
+            } else if (event.key.keysym.scancode == c.SDL_SCANCODE_DOWN) {
+                setPlaybackRate(_playbackRate - 0.25);
+            } else if (event.key.keysym.scancode == c.SDL_SCANCODE_F2) {
+                const mode: SliderRenderMode = switch (DrawableHitSlider.GetRenderMode()) {
+                    .Offscreen => .Direct,
+                    .Direct => .DistanceField,
+                    .DistanceField => .Offscreen,
+                };
+                DrawableHitSlider.SetRenderMode(mode);
+                std.debug.print("Slider render mode: {s}\n", .{@tagName(mode)});
             }
         } else if (event.type == c.SDL_MOUSEWHEEL) {
             //std.debug.print("Wheel: {d}\n", .{event.wheel.y});
             const wheel_delta: f32 = @floatFromInt(event.wheel.y);
             const value: f32 = wheel_delta * 0.01;
             _playingBeatmap.?.Song.SetPlaybackPositionSecs(_playingBeatmap.?.Song.GetPlaybackPositionInSeconds() + value);
+            _clock.Snap();
         }
     }
 };
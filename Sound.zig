@@ -78,14 +78,27 @@ pub const Sound = struct {
         _ = Bass.BASS_ChannelPlay(self.Stream, @intFromBool(restart));
     }
 
+    pub fn IsPlaying(self: *const Sound) bool {
+        return Bass.BASS_ChannelIsActive(self.Stream) == Bass.BASS_ACTIVE_PLAYING;
+    }
+
     pub fn GetFrequency(self: *Sound) f32 {
-        const freq: f32 = 0.0;
+        var freq: f32 = 0.0;
         _ = Bass.BASS_ChannelGetAttribute(self.Stream, Bass.BASS_ATTRIB_FREQ, &freq);
         return freq;
     }
 
     pub fn SetFrequency(self: *Sound, value: f32) void {
-        Bass.BASS_ChannelSetAttribute(self.Stream, Bass.BASS_ATTRIB_FREQ, value);
+        _ = Bass.BASS_ChannelSetAttribute(self.Stream, Bass.BASS_ATTRIB_FREQ, value);
+    }
+
+    ///Scales the stream's default sample rate, 1.0 is normal speed (pitch changes with it)
+    pub fn SetPlaybackRate(self: *Sound, rate: f32) void {
+        var info: Bass.BASS_CHANNELINFO = undefined;
+        if (Bass.BASS_ChannelGetInfo(self.Stream, &info) == 0)
+            return;
+
+        self.SetFrequency(@as(f32, @floatFromInt(info.freq)) * rate);
     }
 
     pub fn Deinit(self: *Sound) void {
@@ -0,0 +1,455 @@
+//zerosu analyze <replay_dir> <maps_dir> <out.csv>
+//Crunches a whole directory of replays into statistics: per replay judgement, unstable rate, key press and cursor speed
+//numbers go into <out.csv>, and hit error / cursor speed / key press histograms summed over every replay go into
+//<out.csv>.histograms.csv. Replays are matched to maps by the MD5 in their header.
+//Every replay is one job on a thread pool, so while some workers are waiting on the disk others are decompressing
+//and judging. Each job only writes its own result slot, the slots get summed up once the pool is done.
+
+const std = @import("std");
+
+const Beatmap = @import("../Osu/OsuParser.zig").Beatmap;
+const Replay = @import("../Osu/ReplayParser.zig").Replay;
+const ReplayFrame = @import("../Osu/ReplayParser.zig").ReplayFrame;
+const ButtonMask = @import("../Osu/ReplayPlayer.zig").ButtonMask;
+
+const ReplayJudge = @import("../Osu/ReplayJudge.zig");
+const JudgeBeatmap = ReplayJudge.JudgeBeatmap;
+const JudgeResult = ReplayJudge.JudgeResult;
+const Mods = ReplayJudge.Mods;
+
+const MAX_FILE_SIZE = 64 * 1024 * 1024;
+
+//Histogram layouts, [min, min + bins * width)
+const HIT_ERROR_MIN: f32 = -200.0;
+const HIT_ERROR_BIN_WIDTH: f32 = 5.0;
+const HIT_ERROR_BINS = 80;
+
+//osu pixels per ms
+const SPEED_BIN_WIDTH: f32 = 0.25;
+const SPEED_BINS = 40;
+
+const PRESS_BIN_WIDTH: f32 = 10.0;
+const PRESS_BINS = 30;
+
+const ReplayStats = struct {
+    Error: ?anyerror = null,
+    HasMap: bool = false,
+
+    PlayerName: []const u8 = "",
+    BeatmapMD5: []const u8 = "",
+    Mods: u32 = 0,
+    FrameCount: usize = 0,
+
+    Judge: JudgeResult = .{},
+    Recorded: JudgeResult = .{},
+
+    MeanHitError: f64 = 0.0,
+    UnstableRate: f64 = 0.0,
+    MeanPressMs: f64 = 0.0,
+    MeanSpeed: f64 = 0.0,
+
+    HitErrorHistogram: [HIT_ERROR_BINS]u32 = [_]u32{0} ** HIT_ERROR_BINS,
+    SpeedHistogram: [SPEED_BINS]u32 = [_]u32{0} ** SPEED_BINS,
+    PressHistogram: [PRESS_BINS]u32 = [_]u32{0} ** PRESS_BINS,
+};
+
+const MapEntry = struct {
+    Path: []const u8,
+    //Set under MapCache.Mutex by the worker that parses the map
+    Claimed: bool = false,
+    //Set once Beatmap is final, whether it loaded or not
+    Loaded: std.Thread.ResetEvent = .{},
+    Beatmap: ?JudgeBeatmap = null,
+};
+
+///Maps are parsed the first time a replay needs them and then shared read only by every worker.
+///Only claiming a map happens under the lock, so different maps get parsed in parallel. Workers needing a map another
+///one is still parsing wait for that map alone.
+const MapCache = struct {
+    //Filled before the pool starts and never resized after, so looking up doesn't need the lock
+    Entries: std.AutoHashMap([32]u8, MapEntry),
+    Mutex: std.Thread.Mutex = .{},
+
+    fn get(self: *MapCache, md5: []const u8) ?*const JudgeBeatmap {
+        if (md5.len != 32)
+            return null;
+
+        const entry = self.Entries.getPtr(md5[0..32].*) orelse return null;
+
+        self.Mutex.lock();
+        const claimed = !entry.Claimed;
+        entry.Claimed = true;
+        self.Mutex.unlock();
+
+        if (claimed) {
+            entry.Beatmap = loadMap(entry.Path) catch |err| blk: {
+                std.debug.print("Couldn't load map {s}: {s}\n", .{ entry.Path, @errorName(err) });
+                break :blk null;
+            };
+            entry.Loaded.set();
+        } else {
+            entry.Loaded.wait();
+        }
+
+        if (entry.Beatmap) |*beatmap|
+            return beatmap;
+
+        return null;
+    }
+
+    fn loadMap(path: []const u8) !JudgeBeatmap {
+        const allocator = std.heap.c_allocator;
+
+        const data = try std.fs.cwd().readFileAlloc(allocator, path, MAX_FILE_SIZE);
+        defer allocator.free(data);
+
+        var beatmap = Beatmap.FromString(allocator, data);
+        defer beatmap.Deinit();
+        beatmap.StackObjectsPass();
+
+        return try JudgeBeatmap.Init(allocator, &beatmap);
+    }
+
+    fn deinit(self: *MapCache) void {
+        var iterator = self.Entries.valueIterator();
+        while (iterator.next()) |entry| {
+            if (entry.Beatmap) |*beatmap| {
+                beatmap.Deinit();
+            }
+        }
+
+        self.Entries.deinit();
+    }
+};
+
+const JobContext = struct {
+    Paths: []const []const u8,
+    Stats: []ReplayStats,
+    Maps: *MapCache,
+    //Strings that outlive the job (player name, md5) go here
+    StringAllocator: std.mem.Allocator,
+    StringMutex: *std.Thread.Mutex,
+};
+
+pub fn Run(allocator: std.mem.Allocator, args: []const [:0]u8) !void {
+    const stdout = std.io.getStdOut().writer();
+
+    if (args.len < 3) {
+        try stdout.print("usage: zerosu analyze <replay_dir> <maps_dir> <out.csv>\n", .{});
+        return;
+    }
+
+    const start = try std.time.Instant.now();
+
+    var arena_state = std.heap.ArenaAllocator.init(allocator);
+    defer arena_state.deinit();
+    const arena = arena_state.allocator();
+
+    const replay_paths = try collectFiles(arena, args[0], ".osr");
+    const map_paths = try collectFiles(arena, args[1], ".osu");
+
+    var pool: std.Thread.Pool = undefined;
+    try pool.init(.{ .allocator = allocator });
+    defer pool.deinit();
+
+    //Index the maps by content hash, also on the pool since it's just as disk bound
+    const map_hashes = try arena.alloc(?[32]u8, map_paths.len);
+    {
+        var wait_group: std.Thread.WaitGroup = .{};
+        for (0..map_paths.len) |i| {
+            pool.spawnWg(&wait_group, hashMapJob, .{ map_paths, map_hashes, i });
+        }
+        pool.waitAndWork(&wait_group);
+    }
+
+    var maps = MapCache{ .Entries = std.AutoHashMap([32]u8, MapEntry).init(allocator) };
+    defer maps.deinit();
+
+    for (map_paths, map_hashes) |path, hash| {
+        if (hash) |md5| {
+            try maps.Entries.put(md5, .{ .Path = path });
+        }
+    }
+
+    const stats = try allocator.alloc(ReplayStats, replay_paths.len);
+    defer allocator.free(stats);
+    @memset(stats, .{});
+
+    var string_mutex: std.Thread.Mutex = .{};
+    const context = JobContext{
+        .Paths = replay_paths,
+        .Stats = stats,
+        .Maps = &maps,
+        .StringAllocator = arena,
+        .StringMutex = &string_mutex,
+    };
+
+    {
+        var wait_group: std.Thread.WaitGroup = .{};
+        for (0..replay_paths.len) |i| {
+            pool.spawnWg(&wait_group, analyzeJob, .{ &context, i });
+        }
+        pool.waitAndWork(&wait_group);
+    }
+
+    try writeReplayCsv(args[2], replay_paths, stats);
+
+    const histogram_path = try std.fmt.allocPrint(arena, "{s}.histograms.csv", .{args[2]});
+    try writeHistogramCsv(histogram_path, stats);
+
+    var failed: usize = 0;
+    var matched: usize = 0;
+    for (stats) |stat| {
+        if (stat.Error != null) failed += 1;
+        if (stat.HasMap) matched += 1;
+    }
+
+    const elapsed_s = @as(f64, @floatFromInt((try std.time.Instant.now()).since(start))) / std.time.ns_per_s;
+
+    try stdout.print("{d} replays ({d} matched to one of {d} maps, {d} failed) in {d:.3}s ({d:.1} replays/s)\nWrote {s} and {s}\n", .{
+        replay_paths.len,
+        matched,
+        maps.Entries.count(),
+        failed,
+        elapsed_s,
+        if (elapsed_s > 0.0) @as(f64, @floatFromInt(replay_paths.len)) / elapsed_s else 0.0,
+        args[2],
+        histogram_path,
+    });
+}
+
+fn hashMapJob(paths: []const []const u8, hashes: []?[32]u8, index: usize) void {
+    hashes[index] = null;
+
+    const data = std.fs.cwd().readFileAlloc(std.heap.c_allocator, paths[index], MAX_FILE_SIZE) catch return;
+    defer std.heap.c_allocator.free(data);
+
+    var digest: [std.crypto.hash.Md5.digest_length]u8 = undefined;
+    std.crypto.hash.Md5.hash(data, &digest, .{});
+
+    hashes[index] = std.fmt.bytesToHex(digest, .lower);
+}
+
+fn analyzeJob(context: *const JobContext, index: usize) void {
+    var arena_state = std.heap.ArenaAllocator.init(std.heap.c_allocator);
+    defer arena_state.deinit();
+    const arena = arena_state.allocator();
+
+    const stats = &context.Stats[index];
+
+    analyzeReplay(context, arena, context.Paths[index], stats) catch |err| {
+        stats.Error = err;
+    };
+}
+
+fn analyzeReplay(context: *const JobContext, arena: std.mem.Allocator, path: []const u8, stats: *ReplayStats) !void {
+    const data = try std.fs.cwd().readFileAlloc(arena, path, MAX_FILE_SIZE);
+    const replay = try Replay.FromData(arena, data);
+
+    const info = &replay.ReplayInfo;
+    const frames = replay.ReplayFrames.items;
+
+    {
+        context.StringMutex.lock();
+        defer context.StringMutex.unlock();
+
+        stats.PlayerName = try context.StringAllocator.dupe(u8, info.PlayerName);
+        stats.BeatmapMD5 = try context.StringAllocator.dupe(u8, info.BeatmapMD5Hash);
+    }
+
+    stats.Mods = info.Mods;
+    stats.FrameCount = frames.len;
+    stats.Recorded = .{
+        .Count300 = info.Count300,
+        .Count100 = info.Count100,
+        .Count50 = info.Count50,
+        .CountMiss = info.CountMiss,
+        .MaxCombo = info.HighestCombo,
+        .TotalScore = info.TotalScore,
+    };
+
+    //Everything is measured in map time, speed ups make the player's real timing tighter by the same factor
+    const rate: f64 = if (info.Mods & (Mods.DoubleTime | Mods.Nightcore) != 0) 1.5 else if (info.Mods & Mods.HalfTime != 0) 0.75 else 1.0;
+
+    analyzeCursor(frames, rate, stats);
+    analyzeKeys(frames, rate, stats);
+
+    const beatmap = context.Maps.get(info.BeatmapMD5Hash) orelse return;
+    stats.HasMap = true;
+
+    var hit_errors = std.ArrayList(f32).init(arena);
+    stats.Judge = try ReplayJudge.JudgeReplayWithHitErrors(arena, beatmap, frames, info.Mods, &hit_errors);
+
+    if (hit_errors.items.len == 0)
+        return;
+
+    var sum: f64 = 0.0;
+    for (hit_errors.items) |hit_error| {
+        sum += @as(f64, hit_error);
+        addToHistogram(&stats.HitErrorHistogram, hit_error, HIT_ERROR_MIN, HIT_ERROR_BIN_WIDTH);
+    }
+
+    const count: f64 = @floatFromInt(hit_errors.items.len);
+    const mean = sum / count;
+
+    var variance: f64 = 0.0;
+    for (hit_errors.items) |hit_error| {
+        const diff = @as(f64, hit_error) - mean;
+        variance += diff * diff;
+    }
+    variance /= count;
+
+    stats.MeanHitError = mean / rate;
+    stats.UnstableRate = @sqrt(variance) * 10.0 / rate;
+}
+
+fn analyzeCursor(frames: []const ReplayFrame, rate: f64, stats: *ReplayStats) void {
+    var total_distance: f64 = 0.0;
+    var total_time: f64 = 0.0;
+
+    for (1..frames.len) |i| {
+        const prev = frames[i - 1];
+        const frame = frames[i];
+
+        if (frame.Time <= prev.Time)
+            continue;
+
+        const dx = frame.X - prev.X;
+        const dy = frame.Y - prev.Y;
+        const distance: f64 = @sqrt(dx * dx + dy * dy);
+        const duration: f64 = @as(f64, @floatFromInt(frame.Time - prev.Time)) / rate;
+
+        total_distance += distance;
+        total_time += duration;
+
+        addToHistogram(&stats.SpeedHistogram, @floatCast(distance / duration), 0.0, SPEED_BIN_WIDTH);
+    }
+
+    if (total_time > 0.0)
+        stats.MeanSpeed = total_distance / total_time;
+}
+
+fn analyzeKeys(frames: []const ReplayFrame, rate: f64, stats: *ReplayStats) void {
+    const buttons = [_]u32{ ButtonMask.M1, ButtonMask.M2, ButtonMask.K1, ButtonMask.K2 };
+    var press_start = [_]?u64{null} ** buttons.len;
+
+    var total_press: f64 = 0.0;
+    var press_count: usize = 0;
+
+    for (frames) |frame| {
+        for (buttons, &press_start) |button, *start| {
+            const down = (frame.ButtonMask & button) != 0;
+
+            if (down and start.* == null) {
+                start.* = frame.Time;
+            } else if (!down and start.* != null) {
+                const duration: f64 = @as(f64, @floatFromInt(frame.Time - start.*.?)) / rate;
+                start.* = null;
+
+                total_press += duration;
+                press_count += 1;
+                addToHistogram(&stats.PressHistogram, @floatCast(duration), 0.0, PRESS_BIN_WIDTH);
+            }
+        }
+    }
+
+    if (press_count > 0)
+        stats.MeanPressMs = total_press / @as(f64, @floatFromInt(press_count));
+}
+
+///Values outside the range land in the first/last bin
+fn addToHistogram(histogram: []u32, value: f32, min: f32, bin_width: f32) void {
+    const bin = std.math.clamp(@floor((value - min) / bin_width), 0.0, @as(f32, @floatFromInt(histogram.len - 1)));
+    histogram[@intFromFloat(bin)] += 1;
+}
+
+fn writeReplayCsv(path: []const u8, paths: []const []const u8, stats: []const ReplayStats) !void {
+    const file = try std.fs.cwd().createFile(path, .{});
+    defer file.close();
+
+    var buffered = std.io.bufferedWriter(file.writer());
+    const out = buffered.writer();
+
+    try out.print("path,player,beatmap_md5,mods,frames,has_map,300,100,50,miss,max_combo,score,recorded_300,recorded_100,recorded_50,recorded_miss,recorded_combo,mean_hit_error,unstable_rate,mean_press_ms,mean_cursor_speed,error\n", .{});
+
+    for (paths, stats) |replay_path, stat| {
+        try out.print("\"{s}\",\"{s}\",{s},{d},{d},{d},{d},{d},{d},{d},{d},{d},{d},{d},{d},{d},{d},{d:.3},{d:.3},{d:.3},{d:.4},{s}\n", .{
+            replay_path,
+            stat.PlayerName,
+            stat.BeatmapMD5,
+            stat.Mods,
+            stat.FrameCount,
+            @intFromBool(stat.HasMap),
+            stat.Judge.Count300,
+            stat.Judge.Count100,
+            stat.Judge.Count50,
+            stat.Judge.CountMiss,
+            stat.Judge.MaxCombo,
+            stat.Judge.TotalScore,
+            stat.Recorded.Count300,
+            stat.Recorded.Count100,
+            stat.Recorded.Count50,
+            stat.Recorded.CountMiss,
+            stat.Recorded.MaxCombo,
+            stat.MeanHitError,
+            stat.UnstableRate,
+            stat.MeanPressMs,
+            stat.MeanSpeed,
+            if (stat.Error) |err| @errorName(err) else "",
+        });
+    }
+
+    try buffered.flush();
+}
+
+fn writeHistogramCsv(path: []const u8, stats: []const ReplayStats) !void {
+    var hit_errors = [_]u64{0} ** HIT_ERROR_BINS;
+    var speeds = [_]u64{0} ** SPEED_BINS;
+    var presses = [_]u64{0} ** PRESS_BINS;
+
+    for (stats) |stat| {
+        for (&hit_errors, stat.HitErrorHistogram) |*total, count| total.* += count;
+        for (&speeds, stat.SpeedHistogram) |*total, count| total.* += count;
+        for (&presses, stat.PressHistogram) |*total, count| total.* += count;
+    }
+
+    const file = try std.fs.cwd().createFile(path, .{});
+    defer file.close();
+
+    var buffered = std.io.bufferedWriter(file.writer());
+    const out = buffered.writer();
+
+    try out.print("histogram,bin_start,bin_end,count\n", .{});
+    try writeHistogram(out, "hit_error_ms", &hit_errors, HIT_ERROR_MIN, HIT_ERROR_BIN_WIDTH);
+    try writeHistogram(out, "cursor_speed_px_per_ms", &speeds, 0.0, SPEED_BIN_WIDTH);
+    try writeHistogram(out, "key_press_ms", &presses, 0.0, PRESS_BIN_WIDTH);
+
+    try buffered.flush();
+}
+
+fn writeHistogram(out: anytype, name: []const u8, histogram: []const u64, min: f32, bin_width: f32) !void {
+    for (histogram, 0..) |count, i| {
+        const bin_start = min + @as(f32, @floatFromInt(i)) * bin_width;
+        try out.print("{s},{d},{d},{d}\n", .{ name, bin_start, bin_start + bin_width, count });
+    }
+}
+
+///Every file under _dir_path_ (recursively) ending in _extension_
+fn collectFiles(allocator: std.mem.Allocator, dir_path: []const u8, extension: []const u8) ![]const []const u8 {
+    var paths = std.ArrayList([]const u8).init(allocator);
+
+    var dir = try std.fs.cwd().openDir(dir_path, .{ .iterate = true });
+    defer dir.close();
+
+    var walker = try dir.walk(allocator);
+    defer walker.deinit();
+
+    while (try walker.next()) |entry| {
+        if (entry.kind != .file or !std.mem.endsWith(u8, entry.basename, extension))
+            continue;
+
+        try paths.append(try std.fs.path.join(allocator, &.{ dir_path, entry.path }));
+    }
+
+    return try paths.toOwnedSlice();
+}
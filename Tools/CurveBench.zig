@@ -0,0 +1,896 @@
+//zerosu curvebench [map.osu | maps_dir]... [--iterations N]
+//zerosu curvebench --write-golden <file> [map.osu | maps_dir]...
+//zerosu curvebench --golden <file> [--iterations N]
+//zerosu curvebench --mesh [map.osu | maps_dir]... [--iterations N] [--scale S] [--bezier]
+//Accuracy and speed harness for CurveApproximator. The corpus is every slider segment of the given maps (./maps when
+//none are given) fed to the approximator osu! would use for it, plus hand made edge cases (degenerate arcs, collinear
+//and coincident points, huge segments, high degree curves).
+//Without --golden it compares the scalar and SIMD bezier kernels on the corpus and reports points/s for every
+//approximator. --write-golden stores the corpus together with the current output of every approximator, --golden
+//reruns that stored corpus and fails if any path moved by more than GOLDEN_TOLERANCE, so curve performance work can
+//show it didn't change slider shapes. curve_golden.txt next to this file is the golden of the approximators from before
+//any of that work (the edge cases and maps/fukutuidol), zig build test checks the current ones against it.
+//--mesh flattens every slider of the maps like the game does and builds its body with both SliderMesh kernels,
+//reporting vertex and index counts and vertices/s. --scale is screen pixels per osu pixel for the level of detail,
+//the default is a 1080p playfield. --bezier only takes the bezier sliders, for comparing the kernels on the curves
+//that have the most joints. The reference kernel is the mesh the game built before SliderMesh.Kernel.Default, so its line
+//is the before and the default one the after. It also computes every body as a distance field and compares its size with
+//the depth body's.
+//Run it on every architecture that matters (x86_64, aarch64), the kernels are the same code but the vector widths
+//and what the compiler makes of them are not. Every report starts with the target it was built for, including the CPU
+//model and how many f32 lanes a native vector has: the SIMD kernel always works 8 wide, which is one register with
+//AVX and two with SSE or NEON.
+
+const std = @import("std");
+const builtin = @import("builtin");
+const zm = @import("zm");
+
+const Beatmap = @import("../Osu/OsuParser.zig").Beatmap;
+
+const CurveApproximator = @import("../CurveApproximator.zig").CurveApproximator;
+const Kernel = CurveApproximator.Kernel;
+const SliderPath = @import("../Osu/SliderPath.zig");
+const SliderLod = @import("../Osu/SliderLod.zig").SliderLod;
+const SliderMesh = @import("../Osu/SliderMesh.zig").SliderMesh;
+const SliderBatcher = @import("../Osu/SliderMesh.zig").SliderBatcher;
+const SliderDistanceField = @import("../Osu/SliderDistanceField.zig");
+
+const MAX_FILE_SIZE = 64 * 1024 * 1024;
+const DEFAULT_ITERATIONS: usize = 20;
+const DEFAULT_MAPS_DIR = "./maps";
+
+const GOLDEN_HEADER = "zerosu-curve-golden 1";
+//Two flattenings that are each within BEZIER_TOLERANCE of the real curve can be this far apart
+const GOLDEN_TOLERANCE: f32 = CurveApproximator.BEZIER_TOLERANCE * 2.0;
+
+const BSPLINE_DEGREE: i32 = 3;
+const CATMULL_DETAIL: i32 = 50;
+//Lagrange blows up with many points and needs strictly increasing x, only small segments from the maps qualify
+const MAX_LAGRANGE_POINTS: usize = 8;
+
+const DEFAULT_MESH_SCALE: f32 = 2.25;
+
+const INITIAL_OUTPUT_SIZE: usize = 4096;
+
+const Approximator = enum {
+    Bezier,
+    BSpline,
+    Catmull,
+    CircularArc,
+    Linear,
+    Lagrange,
+};
+
+const Case = struct {
+    Kind: Approximator,
+    Name: []const u8,
+    Start: usize,
+    End: usize,
+};
+
+///Control points of every case back to back, case i is Points[Cases[i].Start..Cases[i].End]
+const Corpus = struct {
+    Points: std.ArrayList(zm.Vec2f),
+    Cases: std.ArrayList(Case),
+    //Expected output of every case when loaded from a golden file, laid out like Points
+    Golden: std.ArrayList(zm.Vec2f),
+    GoldenRanges: std.ArrayList([2]usize),
+
+    fn init(allocator: std.mem.Allocator) Corpus {
+        return .{
+            .Points = std.ArrayList(zm.Vec2f).init(allocator),
+            .Cases = std.ArrayList(Case).init(allocator),
+            .Golden = std.ArrayList(zm.Vec2f).init(allocator),
+            .GoldenRanges = std.ArrayList([2]usize).init(allocator),
+        };
+    }
+
+    fn deinit(self: *Corpus) void {
+        self.Points.deinit();
+        self.Cases.deinit();
+        self.Golden.deinit();
+        self.GoldenRanges.deinit();
+    }
+
+    fn add(self: *Corpus, kind: Approximator, name: []const u8, points: []const zm.Vec2f) !void {
+        const start = self.Points.items.len;
+        try self.Points.appendSlice(points);
+        try self.Cases.append(.{ .Kind = kind, .Name = name, .Start = start, .End = self.Points.items.len });
+    }
+
+    fn controlPoints(self: *const Corpus, case: Case) []const zm.Vec2f {
+        return self.Points.items[case.Start..case.End];
+    }
+
+    fn maxControlPoints(self: *const Corpus) usize {
+        var max_points: usize = 0;
+        for (self.Cases.items) |case| {
+            max_points = @max(max_points, case.End - case.Start);
+        }
+
+        return max_points;
+    }
+};
+
+const EdgeCase = struct {
+    Kind: Approximator,
+    Name: []const u8,
+    Points: []const zm.Vec2f,
+};
+
+const ZIGZAG = blk: {
+    var points: [24]zm.Vec2f = undefined;
+    for (&points, 0..) |*point, i| {
+        point.* = .{ @as(f32, @floatFromInt(i)) * 20.0, if (i % 2 == 0) 0.0 else 150.0 };
+    }
+    break :blk points;
+};
+
+const EDGE_CASES = [_]EdgeCase{
+    .{ .Kind = .CircularArc, .Name = "arc-collinear", .Points = &.{ .{ 0.0, 0.0 }, .{ 50.0, 0.0 }, .{ 100.0, 0.0 } } },
+    .{ .Kind = .CircularArc, .Name = "arc-coincident", .Points = &.{ .{ 10.0, 10.0 }, .{ 10.0, 10.0 }, .{ 60.0, 40.0 } } },
+    .{ .Kind = .CircularArc, .Name = "arc-tiny-radius", .Points = &.{ .{ 0.0, 0.0 }, .{ 0.02, 0.01 }, .{ 0.04, 0.0 } } },
+    .{ .Kind = .CircularArc, .Name = "arc-almost-full-circle", .Points = &.{ .{ 17.3648, -98.4808 }, .{ -100.0, 0.0 }, .{ -17.3648, -98.4808 } } },
+    .{ .Kind = .CircularArc, .Name = "arc-huge-radius", .Points = &.{ .{ 0.0, 0.0 }, .{ 256.0, 0.5 }, .{ 512.0, 0.0 } } },
+    .{ .Kind = .Bezier, .Name = "bezier-collinear", .Points = &.{ .{ 0.0, 0.0 }, .{ 100.0, 0.0 }, .{ 200.0, 0.0 }, .{ 300.0, 0.0 } } },
+    .{ .Kind = .Bezier, .Name = "bezier-zero-length", .Points = &.{ .{ 256.0, 192.0 }, .{ 256.0, 192.0 }, .{ 256.0, 192.0 }, .{ 256.0, 192.0 } } },
+    .{ .Kind = .Bezier, .Name = "bezier-cusp", .Points = &.{ .{ 0.0, 0.0 }, .{ 300.0, 100.0 }, .{ 0.0, 100.0 }, .{ 300.0, 0.0 } } },
+    .{ .Kind = .Bezier, .Name = "bezier-very-long", .Points = &.{ .{ 0.0, 0.0 }, .{ 50000.0, 30000.0 }, .{ -20000.0, 80000.0 }, .{ 100000.0, 100000.0 } } },
+    .{ .Kind = .Bezier, .Name = "bezier-quadratic", .Points = &.{ .{ 0.0, 0.0 }, .{ 150.0, 300.0 }, .{ 300.0, 0.0 } } },
+    .{ .Kind = .Bezier, .Name = "bezier-high-degree", .Points = &ZIGZAG },
+    .{ .Kind = .BSpline, .Name = "bspline-high-degree", .Points = &ZIGZAG },
+    .{ .Kind = .Catmull, .Name = "catmull-collinear", .Points = &.{ .{ 0.0, 0.0 }, .{ 100.0, 0.0 }, .{ 200.0, 0.0 } } },
+    .{ .Kind = .Catmull, .Name = "catmull-repeated", .Points = &.{ .{ 0.0, 0.0 }, .{ 0.0, 0.0 }, .{ 100.0, 100.0 }, .{ 100.0, 100.0 } } },
+    .{ .Kind = .Linear, .Name = "linear-very-long", .Points = &.{ .{ -100000.0, 0.0 }, .{ 100000.0, 0.0 } } },
+    .{ .Kind = .Linear, .Name = "linear-zero-length", .Points = &.{ .{ 64.0, 64.0 }, .{ 64.0, 64.0 } } },
+    .{ .Kind = .Lagrange, .Name = "lagrange-quadratic", .Points = &.{ .{ 0.0, 0.0 }, .{ 100.0, 200.0 }, .{ 200.0, 0.0 } } },
+    .{ .Kind = .Lagrange, .Name = "lagrange-wiggle", .Points = &.{ .{ 0.0, 0.0 }, .{ 40.0, 80.0 }, .{ 80.0, -20.0 }, .{ 120.0, 60.0 }, .{ 160.0, 10.0 }, .{ 200.0, 50.0 } } },
+};
+
+pub fn Run(allocator: std.mem.Allocator, args: []const [:0]u8) !void {
+    const stdout = std.io.getStdOut().writer();
+
+    var iterations = DEFAULT_ITERATIONS;
+    var golden_path: ?[]const u8 = null;
+    var write_golden_path: ?[]const u8 = null;
+    var mesh = false;
+    var mesh_scale = DEFAULT_MESH_SCALE;
+    var mesh_bezier_only = false;
+
+    var arena_state = std.heap.ArenaAllocator.init(allocator);
+    defer arena_state.deinit();
+    const arena = arena_state.allocator();
+
+    var inputs = std.ArrayList([]const u8).init(arena);
+
+    var i: usize = 0;
+    while (i < args.len) : (i += 1) {
+        const has_value = i + 1 < args.len;
+
+        if (std.mem.eql(u8, args[i], "--iterations") and has_value) {
+            i += 1;
+            iterations = @max(1, try std.fmt.parseInt(usize, args[i], 10));
+        } else if (std.mem.eql(u8, args[i], "--golden") and has_value) {
+            i += 1;
+            golden_path = args[i];
+        } else if (std.mem.eql(u8, args[i], "--write-golden") and has_value) {
+            i += 1;
+            write_golden_path = args[i];
+        } else if (std.mem.eql(u8, args[i], "--mesh")) {
+            mesh = true;
+        } else if (std.mem.eql(u8, args[i], "--scale") and has_value) {
+            i += 1;
+            mesh_scale = try std.fmt.parseFloat(f32, args[i]);
+        } else if (std.mem.eql(u8, args[i], "--bezier")) {
+            mesh_bezier_only = true;
+        } else {
+            try inputs.append(args[i]);
+        }
+    }
+
+    if (mesh) {
+        if (inputs.items.len == 0)
+            try inputs.append(DEFAULT_MAPS_DIR);
+
+        return benchmarkMeshes(allocator, arena, try collectMapPaths(arena, inputs.items), iterations, mesh_scale, mesh_bezier_only);
+    }
+
+    var corpus = Corpus.init(allocator);
+    defer corpus.deinit();
+
+    if (golden_path) |path| {
+        try loadGolden(arena, path, &corpus);
+    } else {
+        if (inputs.items.len == 0)
+            try inputs.append(DEFAULT_MAPS_DIR);
+
+        for (try collectMapPaths(arena, inputs.items)) |path| {
+            collectMapCases(allocator, arena, path, &corpus) catch |err| {
+                try stdout.print("Couldn't load map {s}: {s}\n", .{ path, @errorName(err) });
+            };
+        }
+
+        for (EDGE_CASES) |edge_case| {
+            try corpus.add(edge_case.Kind, edge_case.Name, edge_case.Points);
+        }
+    }
+
+    const scratch = try allocator.alloc(zm.Vec2f, CurveApproximator.ScratchSize(corpus.maxControlPoints()));
+    defer allocator.free(scratch);
+
+    //Grown as needed by everything but the timed loops
+    var output = try allocator.alloc(zm.Vec2f, INITIAL_OUTPUT_SIZE);
+    defer allocator.free(output);
+    var reference = try allocator.alloc(zm.Vec2f, INITIAL_OUTPUT_SIZE);
+    defer allocator.free(reference);
+
+    var buffered = std.io.bufferedWriter(stdout);
+    const out = buffered.writer();
+
+    if (write_golden_path) |path| {
+        try writeGolden(allocator, path, &corpus, &output, scratch);
+        try out.print("Wrote {d} cases to {s}\n", .{ corpus.Cases.items.len, path });
+        try buffered.flush();
+        return;
+    }
+
+    try printTarget(out);
+    try out.print(", {d} cases (max {d} control points), {d} iterations\n\n", .{
+        corpus.Cases.items.len,
+        corpus.maxControlPoints(),
+        iterations,
+    });
+
+    //Accuracy first
+    var moved: usize = 0;
+
+    if (golden_path != null) {
+        moved = try checkGolden(allocator, out, &corpus, &output, scratch);
+    } else {
+        try compareKernels(allocator, out, &corpus, iterations, &output, &reference, scratch);
+    }
+
+    //The kernel comparison only grew the buffer for the bezier cases, the timed loops can't grow it
+    for (corpus.Cases.items) |case| {
+        _ = try flattenGrowing(allocator, case.Kind, corpus.controlPoints(case), &output, scratch);
+    }
+
+    for (std.enums.values(Approximator)) |kind| {
+        try benchmarkApproximator(out, kind, &corpus, iterations, output, scratch);
+    }
+
+    try buffered.flush();
+
+    if (moved > 0)
+        return error.GoldenMismatch;
+}
+
+fn printTarget(out: anytype) !void {
+    try out.print("{s}-{s} {s}, {d} f32 lanes per native vector", .{
+        @tagName(builtin.cpu.arch),
+        @tagName(builtin.mode),
+        builtin.cpu.model.name,
+        std.simd.suggestVectorLength(f32) orelse 1,
+    });
+}
+
+fn flatten(kind: Approximator, control_points: []const zm.Vec2f, output: []zm.Vec2f, scratch: []zm.Vec2f) CurveApproximator.Error![]zm.Vec2f {
+    return switch (kind) {
+        .Bezier => CurveApproximator.approximateBezierInto(control_points, output, scratch, .{}),
+        .BSpline => CurveApproximator.approximateBSplineInto(control_points, BSPLINE_DEGREE, output, scratch, .{}),
+        .Catmull => CurveApproximator.approximateCatmullInto(control_points, CATMULL_DETAIL, output),
+        .CircularArc => CurveApproximator.approximateCircularArcInto(control_points, output, scratch, .{}),
+        .Linear => CurveApproximator.approximateLinearInto(control_points, output),
+        .Lagrange => CurveApproximator.approximateLagrangePolynomialInto(control_points, output, scratch),
+    };
+}
+
+fn flattenGrowing(allocator: std.mem.Allocator, kind: Approximator, control_points: []const zm.Vec2f, output: *[]zm.Vec2f, scratch: []zm.Vec2f) ![]zm.Vec2f {
+    while (true) {
+        return flatten(kind, control_points, output.*, scratch) catch |err| switch (err) {
+            error.OutputTooSmall => {
+                output.* = try allocator.realloc(output.*, output.len * 2);
+                continue;
+            },
+            else => return err,
+        };
+    }
+}
+
+fn flattenKernelGrowing(allocator: std.mem.Allocator, comptime kernel: Kernel, control_points: []const zm.Vec2f, output: *[]zm.Vec2f, scratch: []zm.Vec2f) ![]zm.Vec2f {
+    while (true) {
+        return CurveApproximator.approximateBSplineIntoKernel(kernel, control_points, 0, output.*, scratch, .{}) catch |err| switch (err) {
+            error.OutputTooSmall => {
+                output.* = try allocator.realloc(output.*, output.len * 2);
+                continue;
+            },
+            else => return err,
+        };
+    }
+}
+
+///Reflattens every stored case and prints the ones that moved, returns how many did
+fn checkGolden(allocator: std.mem.Allocator, out: anytype, corpus: *const Corpus, output: *[]zm.Vec2f, scratch: []zm.Vec2f) !usize {
+    var moved: usize = 0;
+    var max_deviation: f32 = 0.0;
+    var point_count_changes: usize = 0;
+
+    for (corpus.Cases.items, corpus.GoldenRanges.items) |case, range| {
+        const expected = corpus.Golden.items[range[0]..range[1]];
+        const actual = try flattenGrowing(allocator, case.Kind, corpus.controlPoints(case), output, scratch);
+
+        if (actual.len != expected.len)
+            point_count_changes += 1;
+
+        const deviation = polylineDeviation(actual, expected);
+        max_deviation = @max(max_deviation, deviation);
+
+        //Written so NaN counts as moved too
+        if (!(deviation <= GOLDEN_TOLERANCE)) {
+            moved += 1;
+            try out.print("MOVED {s} {s}: {d:.4}px off, {d} points (was {d})\n", .{ @tagName(case.Kind), case.Name, deviation, actual.len, expected.len });
+        }
+    }
+
+    try out.print("golden: {d}/{d} cases within {d:.2}px (max {d:.4}px), {d} with a different point count\n\n", .{
+        corpus.Cases.items.len - moved,
+        corpus.Cases.items.len,
+        GOLDEN_TOLERANCE,
+        max_deviation,
+        point_count_changes,
+    });
+
+    return moved;
+}
+
+fn compareKernels(allocator: std.mem.Allocator, out: anytype, corpus: *const Corpus, iterations: usize, output: *[]zm.Vec2f, reference: *[]zm.Vec2f, scratch: []zm.Vec2f) !void {
+    var max_deviation: f32 = 0.0;
+    var worst_case: []const u8 = "";
+    var over_tolerance: usize = 0;
+    var bezier_cases: usize = 0;
+
+    for (corpus.Cases.items) |case| {
+        if (case.Kind != .Bezier)
+            continue;
+
+        bezier_cases += 1;
+
+        const control_points = corpus.controlPoints(case);
+        const scalar = try flattenKernelGrowing(allocator, .Scalar, control_points, reference, scratch);
+        const simd = try flattenKernelGrowing(allocator, .Simd, control_points, output, scratch);
+
+        const deviation = polylineDeviation(simd, scalar);
+        if (deviation > max_deviation) {
+            max_deviation = deviation;
+            worst_case = case.Name;
+        }
+
+        if (deviation > GOLDEN_TOLERANCE)
+            over_tolerance += 1;
+    }
+
+    if (bezier_cases == 0)
+        return;
+
+    const scalar_stats = try timeKernel(.Scalar, corpus, iterations, reference.*, scratch);
+    const simd_stats = try timeKernel(.Simd, corpus, iterations, output.*, scratch);
+
+    try out.print("bezier kernels on {d} cases: scalar {d:.3}s {d:.2} Mpoints/s, simd {d:.3}s {d:.2} Mpoints/s", .{
+        bezier_cases,
+        scalar_stats.Seconds,
+        scalar_stats.pointsPerSecond() / 1e6,
+        simd_stats.Seconds,
+        simd_stats.pointsPerSecond() / 1e6,
+    });
+    if (simd_stats.Seconds > 0.0) {
+        try out.print(" ({d:.2}x)", .{scalar_stats.Seconds / simd_stats.Seconds});
+    }
+
+    try out.print("\nsimd max deviation from scalar {d:.4}px ({s}), {d} cases over {d:.2}px\n\n", .{
+        max_deviation,
+        worst_case,
+        over_tolerance,
+        GOLDEN_TOLERANCE,
+    });
+}
+
+const KernelStats = struct {
+    //Over all iterations
+    Points: usize = 0,
+    Seconds: f64 = 0.0,
+
+    fn pointsPerSecond(self: KernelStats) f64 {
+        return if (self.Seconds > 0.0) @as(f64, @floatFromInt(self.Points)) / self.Seconds else 0.0;
+    }
+};
+
+fn timeKernel(comptime kernel: Kernel, corpus: *const Corpus, iterations: usize, output: []zm.Vec2f, scratch: []zm.Vec2f) !KernelStats {
+    var stats = KernelStats{};
+
+    const start = try std.time.Instant.now();
+
+    for (0..iterations) |_| {
+        for (corpus.Cases.items) |case| {
+            if (case.Kind != .Bezier)
+                continue;
+
+            const flattened = try CurveApproximator.approximateBSplineIntoKernel(kernel, corpus.controlPoints(case), 0, output, scratch, .{});
+            std.mem.doNotOptimizeAway(flattened.ptr);
+
+            stats.Points += flattened.len;
+        }
+    }
+
+    const elapsed_ns = (try std.time.Instant.now()).since(start);
+    stats.Seconds = @as(f64, @floatFromInt(elapsed_ns)) / std.time.ns_per_s;
+
+    return stats;
+}
+
+fn benchmarkApproximator(out: anytype, kind: Approximator, corpus: *const Corpus, iterations: usize, output: []zm.Vec2f, scratch: []zm.Vec2f) !void {
+    var case_count: usize = 0;
+    var points: usize = 0;
+
+    const start = try std.time.Instant.now();
+
+    for (0..iterations) |_| {
+        for (corpus.Cases.items) |case| {
+            if (case.Kind != kind)
+                continue;
+
+            const flattened = try flatten(kind, corpus.controlPoints(case), output, scratch);
+            std.mem.doNotOptimizeAway(flattened.ptr);
+
+            case_count += 1;
+            points += flattened.len;
+        }
+    }
+
+    const elapsed_ns = (try std.time.Instant.now()).since(start);
+    const seconds = @as(f64, @floatFromInt(elapsed_ns)) / std.time.ns_per_s;
+
+    if (case_count == 0)
+        return;
+
+    try out.print("{s: <12} {d: >6} cases  {d:.3}s  {d:.2} Mcurves/s  {d:.2} Mpoints/s\n", .{
+        @tagName(kind),
+        case_count / iterations,
+        seconds,
+        if (seconds > 0.0) @as(f64, @floatFromInt(case_count)) / seconds / 1e6 else 0.0,
+        if (seconds > 0.0) @as(f64, @floatFromInt(points)) / seconds / 1e6 else 0.0,
+    });
+}
+
+const MeshStats = struct {
+    Vertices: usize = 0,
+    Indices: usize = 0,
+    Seconds: f64 = 0.0,
+};
+
+fn benchmarkMeshes(allocator: std.mem.Allocator, arena: std.mem.Allocator, map_paths: []const []const u8, iterations: usize, scale: f32, bezier_only: bool) !void {
+    const stdout = std.io.getStdOut().writer();
+
+    const lod = SliderLod.Compute(scale, SliderLod.GetProfile());
+
+    var paths = std.ArrayList(SliderPath.Path).init(allocator);
+    defer paths.deinit();
+
+    for (map_paths) |map_path| {
+        collectMapSliderPaths(allocator, arena, map_path, &lod, bezier_only, &paths) catch |err| {
+            try stdout.print("Couldn't load map {s}: {s}\n", .{ map_path, @errorName(err) });
+        };
+    }
+
+    var max_points: usize = 2;
+    for (paths.items) |path| {
+        max_points = @max(max_points, path.Points.len);
+    }
+
+    const segment_starts = try allocator.alloc(u32, max_points - 1);
+    defer allocator.free(segment_starts);
+
+    //Only counted, so a body bigger than the batcher just carries on like a chunked one in the game
+    var batcher = try SliderBatcher.Init(std.math.maxInt(u16), std.math.maxInt(u16) * 3);
+    batcher.OutOfSpaceCallback = discardMesh;
+
+    var buffered = std.io.bufferedWriter(stdout);
+    const out = buffered.writer();
+
+    try printTarget(out);
+    try out.print(", {d} {s}slider bodies, scale {d:.2}, {s} quality, {d} iterations\n\n", .{
+        paths.items.len,
+        if (bezier_only) "bezier " else "",
+        lod.Scale,
+        @tagName(SliderLod.GetProfile()),
+        iterations,
+    });
+
+    const reference = try timeMeshKernel(.Reference, paths.items, &lod, iterations, &batcher, segment_starts);
+    const current = try timeMeshKernel(.Default, paths.items, &lod, iterations, &batcher, segment_starts);
+
+    try printMeshStats(out, "before", reference, paths.items.len, iterations);
+    try printMeshStats(out, "after", current, paths.items.len, iterations);
+
+    if (reference.Vertices > 0 and reference.Indices > 0 and reference.Seconds > 0.0 and current.Seconds > 0.0) {
+        try out.print("\nafter/before: {d:.1}% fewer vertices, {d:.1}% fewer indices, {d:.2}x vertices/s, {d:.2}x bodies/s\n", .{
+            100.0 * (1.0 - @as(f64, @floatFromInt(current.Vertices)) / @as(f64, @floatFromInt(reference.Vertices))),
+            100.0 * (1.0 - @as(f64, @floatFromInt(current.Indices)) / @as(f64, @floatFromInt(reference.Indices))),
+            (@as(f64, @floatFromInt(current.Vertices)) / current.Seconds) / (@as(f64, @floatFromInt(reference.Vertices)) / reference.Seconds),
+            reference.Seconds / current.Seconds,
+        });
+    }
+
+    const field = try timeDistanceFields(allocator, paths.items, lod.Scale, iterations);
+
+    //Both are rendered at the screen size, the depth body a 16 bit texel per pixel, a field one byte per texel at
+    //SliderDistanceField.SCALE
+    var depth_texels: usize = 0;
+    for (paths.items) |path| {
+        const width = @ceil(@as(f32, @floatFromInt(@max(path.Width, 1))) * lod.Scale);
+        const height = @ceil(@as(f32, @floatFromInt(@max(path.Height, 1))) * lod.Scale);
+        depth_texels += @as(usize, @intFromFloat(width)) * @as(usize, @intFromFloat(height));
+    }
+
+    const field_bytes: f64 = @floatFromInt(field.Texels);
+    const depth_bytes: f64 = @floatFromInt(depth_texels * 2);
+
+    try out.print("\ndistance field {d: >10} texels {d:.2} MB, depth body {d: >10} texels {d:.2} MB ({d:.1}%)  {d:.3}s  {d:.3} Mbodies/s\n", .{
+        field.Texels,
+        field_bytes / (1024.0 * 1024.0),
+        depth_texels,
+        depth_bytes / (1024.0 * 1024.0),
+        if (depth_bytes > 0.0) 100.0 * field_bytes / depth_bytes else 0.0,
+        field.Seconds,
+        if (field.Seconds > 0.0) @as(f64, @floatFromInt(paths.items.len * iterations)) / field.Seconds / 1e6 else 0.0,
+    });
+
+    //What a body takes in its atlas page, the in-game numbers are in zerosu --slider-stats
+    if (paths.items.len > 0) {
+        const bodies: f64 = @floatFromInt(paths.items.len);
+        try out.print("per body: distance field {d:.0} bytes, depth body {d:.0} bytes\n", .{ field_bytes / bodies, depth_bytes / bodies });
+    }
+
+    try buffered.flush();
+}
+
+const FieldStats = struct {
+    Texels: usize = 0,
+    Seconds: f64 = 0.0,
+};
+
+///Texels are for one pass over _paths_ at _scale_ screen pixels per osu pixel, the time for all _iterations_
+fn timeDistanceFields(allocator: std.mem.Allocator, paths: []const SliderPath.Path, scale: f32, iterations: usize) !FieldStats {
+    var stats = FieldStats{};
+
+    var pixels = std.ArrayList(u8).init(allocator);
+    defer pixels.deinit();
+
+    const start = try std.time.Instant.now();
+
+    for (0..iterations) |iteration| {
+        for (paths) |*path| {
+            const size = SliderDistanceField.GetSize(path, scale);
+            const width: usize = @intCast(size[0]);
+            const height: usize = @intCast(size[1]);
+
+            try pixels.resize(width * height);
+            try SliderDistanceField.Render(allocator, pixels.items, width, height, path);
+            std.mem.doNotOptimizeAway(pixels.items.ptr);
+
+            if (iteration == 0)
+                stats.Texels += width * height;
+        }
+    }
+
+    const elapsed_ns = (try std.time.Instant.now()).since(start);
+    stats.Seconds = @as(f64, @floatFromInt(elapsed_ns)) / std.time.ns_per_s;
+
+    return stats;
+}
+
+///Counts are for one pass over _paths_, the time for all _iterations_
+fn timeMeshKernel(comptime kernel: SliderMesh.Kernel, paths: []const SliderPath.Path, lod: *const SliderLod, iterations: usize, batcher: *SliderBatcher, segment_starts: []u32) !MeshStats {
+    var stats = MeshStats{};
+
+    const start = try std.time.Instant.now();
+
+    for (0..iterations) |iteration| {
+        for (paths) |*path| {
+            _ = SliderMesh.BuildKernel(kernel, batcher, path, lod, segment_starts[0 .. path.Points.len - 1]);
+            std.mem.doNotOptimizeAway(batcher.vertexBuffer.ptr);
+
+            if (iteration == 0) {
+                stats.Vertices += batcher.GetStreamVertexCount();
+                stats.Indices += batcher.GetStreamIndexCount();
+            }
+
+            batcher.ResetWritePosition();
+        }
+    }
+
+    const elapsed_ns = (try std.time.Instant.now()).since(start);
+    stats.Seconds = @as(f64, @floatFromInt(elapsed_ns)) / std.time.ns_per_s;
+
+    return stats;
+}
+
+fn discardMesh(batcher: *SliderBatcher) void {
+    batcher.Flush();
+}
+
+fn printMeshStats(out: anytype, name: []const u8, stats: MeshStats, bodies: usize, iterations: usize) !void {
+    const total_bodies: f64 = @floatFromInt(bodies * iterations);
+    const total_vertices: f64 = @floatFromInt(stats.Vertices * iterations);
+
+    try out.print("{s: <10} {d: >10} vertices {d: >10} indices  {d:.1} vertices/body  {d:.3}s  {d:.2} Mvertices/s  {d:.3} Mbodies/s\n", .{
+        name,
+        stats.Vertices,
+        stats.Indices,
+        if (bodies > 0) @as(f64, @floatFromInt(stats.Vertices)) / @as(f64, @floatFromInt(bodies)) else 0.0,
+        stats.Seconds,
+        if (stats.Seconds > 0.0) total_vertices / stats.Seconds / 1e6 else 0.0,
+        if (stats.Seconds > 0.0) total_bodies / stats.Seconds / 1e6 else 0.0,
+    });
+}
+
+///Every slider of the map flattened at _lod_, with the map's circle radius. Only the bezier ones with _bezier_only_.
+fn collectMapSliderPaths(allocator: std.mem.Allocator, arena: std.mem.Allocator, map_path: []const u8, lod: *const SliderLod, bezier_only: bool, paths: *std.ArrayList(SliderPath.Path)) !void {
+    const data = try std.fs.cwd().readFileAlloc(allocator, map_path, MAX_FILE_SIZE);
+    defer allocator.free(data);
+
+    var beatmap = Beatmap.FromString(allocator, data);
+    defer beatmap.Deinit();
+
+    //Same as PlayableBeatmap
+    const radius = 54.4 - 4.48 * beatmap.Difficulty.CircleSize;
+
+    for (beatmap.HitObjects.items) |hit_object| {
+        if (!hit_object.IsHitSlider())
+            continue;
+
+        if (bezier_only and hit_object.HitSlider.?.Type != .Bezier)
+            continue;
+
+        const points = try SliderPath.BuildPointsDetailed(arena, hit_object, lod.Flatten);
+        try paths.append(try SliderPath.Path.Init(arena, points, radius));
+    }
+}
+
+///Largest distance from a point of either polyline to the other one
+fn polylineDeviation(a: []const zm.Vec2f, b: []const zm.Vec2f) f32 {
+    if (a.len == 0 or b.len == 0)
+        return if (a.len == b.len) 0.0 else std.math.inf(f32);
+
+    return @max(maxDistanceToPolyline(a, b), maxDistanceToPolyline(b, a));
+}
+
+///Largest distance from any point of _points_ to the polyline _line_
+fn maxDistanceToPolyline(points: []const zm.Vec2f, line: []const zm.Vec2f) f32 {
+    var max_distance: f32 = 0.0;
+
+    for (points) |point| {
+        var closest = std.math.floatMax(f32);
+
+        if (line.len == 1)
+            closest = zm.vec.distance(point, line[0]);
+
+        for (0..line.len -| 1) |i| {
+            closest = @min(closest, distanceToSegment(point, line[i], line[i + 1]));
+        }
+
+        max_distance = @max(max_distance, closest);
+    }
+
+    return max_distance;
+}
+
+fn distanceToSegment(point: zm.Vec2f, a: zm.Vec2f, b: zm.Vec2f) f32 {
+    const ab = b - a;
+    const length_squared = zm.vec.dot(ab, ab);
+
+    if (length_squared == 0.0)
+        return zm.vec.distance(point, a);
+
+    const t = std.math.clamp(zm.vec.dot(point - a, ab) / length_squared, 0.0, 1.0);
+    return zm.vec.distance(point, a + ab * zm.Vec2f{ t, t });
+}
+
+//Golden file, plain text so a moved case shows up in a diff:
+//  zerosu-curve-golden 1
+//  case <Approximator> <name>
+//  control <count> x y x y ...
+//  output <count> x y x y ...
+
+fn writeGolden(allocator: std.mem.Allocator, path: []const u8, corpus: *const Corpus, output: *[]zm.Vec2f, scratch: []zm.Vec2f) !void {
+    const file = try std.fs.cwd().createFile(path, .{});
+    defer file.close();
+
+    var buffered = std.io.bufferedWriter(file.writer());
+    const writer = buffered.writer();
+
+    try writer.print("{s}\n", .{GOLDEN_HEADER});
+
+    for (corpus.Cases.items) |case| {
+        const control_points = corpus.controlPoints(case);
+        const flattened = try flattenGrowing(allocator, case.Kind, control_points, output, scratch);
+
+        try writer.print("case {s} {s}\n", .{ @tagName(case.Kind), case.Name });
+        try writePoints(writer, "control", control_points);
+        try writePoints(writer, "output", flattened);
+    }
+
+    try buffered.flush();
+}
+
+fn writePoints(writer: anytype, label: []const u8, points: []const zm.Vec2f) !void {
+    try writer.print("{s} {d}", .{ label, points.len });
+
+    for (points) |point| {
+        try writer.print(" {d} {d}", .{ point[0], point[1] });
+    }
+
+    try writer.writeByte('\n');
+}
+
+fn loadGolden(arena: std.mem.Allocator, path: []const u8, corpus: *Corpus) !void {
+    try parseGolden(try std.fs.cwd().readFileAlloc(arena, path, MAX_FILE_SIZE), corpus);
+}
+
+///The cases point into _data_, which has to outlive _corpus_
+fn parseGolden(data: []const u8, corpus: *Corpus) !void {
+    var lines = std.mem.tokenizeAny(u8, data, "\r\n");
+
+    const header = lines.next() orelse return error.InvalidGoldenFile;
+    if (!std.mem.eql(u8, header, GOLDEN_HEADER))
+        return error.InvalidGoldenFile;
+
+    while (lines.next()) |case_line| {
+        var fields = std.mem.splitScalar(u8, case_line, ' ');
+
+        if (!std.mem.eql(u8, fields.next() orelse "", "case"))
+            return error.InvalidGoldenFile;
+
+        const kind = std.meta.stringToEnum(Approximator, fields.next() orelse "") orelse return error.InvalidGoldenFile;
+        const name = fields.rest();
+
+        const control_start = corpus.Points.items.len;
+        try readPoints(lines.next() orelse return error.InvalidGoldenFile, "control", &corpus.Points);
+
+        const golden_start = corpus.Golden.items.len;
+        try readPoints(lines.next() orelse return error.InvalidGoldenFile, "output", &corpus.Golden);
+
+        try corpus.Cases.append(.{ .Kind = kind, .Name = name, .Start = control_start, .End = corpus.Points.items.len });
+        try corpus.GoldenRanges.append(.{ golden_start, corpus.Golden.items.len });
+    }
+}
+
+fn readPoints(line: []const u8, label: []const u8, points: *std.ArrayList(zm.Vec2f)) !void {
+    var fields = std.mem.tokenizeScalar(u8, line, ' ');
+
+    if (!std.mem.eql(u8, fields.next() orelse "", label))
+        return error.InvalidGoldenFile;
+
+    const count = try std.fmt.parseInt(usize, fields.next() orelse return error.InvalidGoldenFile, 10);
+    try points.ensureUnusedCapacity(count);
+
+    for (0..count) |_| {
+        const x = try std.fmt.parseFloat(f32, fields.next() orelse return error.InvalidGoldenFile);
+        const y = try std.fmt.parseFloat(f32, fields.next() orelse return error.InvalidGoldenFile);
+        points.appendAssumeCapacity(.{ x, y });
+    }
+}
+
+///Adds every segment of _path_'s sliders as a case for the approximator SliderPath.BuildPoints would pick for it.
+///Bezier segments are also run as a cubic B-spline, and short ones with strictly increasing x as a Lagrange polynomial.
+fn collectMapCases(allocator: std.mem.Allocator, arena: std.mem.Allocator, path: []const u8, corpus: *Corpus) !void {
+    const data = try std.fs.cwd().readFileAlloc(allocator, path, MAX_FILE_SIZE);
+    defer allocator.free(data);
+
+    var beatmap = Beatmap.FromString(allocator, data);
+    defer beatmap.Deinit();
+
+    var segment = std.ArrayList(zm.Vec2f).init(allocator);
+    defer segment.deinit();
+
+    for (beatmap.HitObjects.items, 0..) |hit_object, object_index| {
+        if (!hit_object.IsHitSlider())
+            continue;
+
+        const slider = hit_object.HitSlider.?;
+        const curve_points = slider.CurvePoints.items;
+
+        segment.clearRetainingCapacity();
+        try segment.append(.{ @floatFromInt(hit_object.X), @floatFromInt(hit_object.Y) });
+
+        var segment_index: usize = 0;
+
+        for (curve_points, 0..) |now, i| {
+            const next = curve_points[@min(i + 1, curve_points.len - 1)];
+
+            try segment.append(.{ @floatFromInt(now.X), @floatFromInt(now.Y) });
+
+            if (now.X != next.X or now.Y != next.Y)
+                continue;
+
+            const points = segment.items;
+            if (points.len < 2)
+                continue;
+
+            const name = try std.fmt.allocPrint(arena, "{s}#{d}.{d}", .{ path, object_index, segment_index });
+            segment_index += 1;
+
+            const kind: Approximator = switch (slider.Type) {
+                .Bezier => if (points.len >= 3) .Bezier else .Linear,
+                .PerfectCircle => if (points.len == 3) .CircularArc else .Bezier,
+                .Catmull => if (points.len >= 3) .Catmull else .Linear,
+                .Linear => .Linear,
+            };
+
+            try corpus.add(kind, name, points);
+
+            if (kind == .Bezier and points.len > @as(usize, @intCast(BSPLINE_DEGREE)) + 1)
+                try corpus.add(.BSpline, name, points);
+
+            if (points.len >= 3 and points.len <= MAX_LAGRANGE_POINTS and isStrictlyIncreasingX(points))
+                try corpus.add(.Lagrange, name, points);
+
+            segment.clearRetainingCapacity();
+        }
+    }
+}
+
+fn isStrictlyIncreasingX(points: []const zm.Vec2f) bool {
+    for (1..points.len) |i| {
+        if (points[i][0] <= points[i - 1][0])
+            return false;
+    }
+
+    return true;
+}
+
+///Expands directories into the .osu files under them
+fn collectMapPaths(allocator: std.mem.Allocator, inputs: []const []const u8) ![]const []const u8 {
+    var paths = std.ArrayList([]const u8).init(allocator);
+
+    for (inputs) |input| {
+        var dir = std.fs.cwd().openDir(input, .{ .iterate = true }) catch |err| switch (err) {
+            error.NotDir => {
+                try paths.append(input);
+                continue;
+            },
+            else => return err,
+        };
+        defer dir.close();
+
+        var walker = try dir.walk(allocator);
+        defer walker.deinit();
+
+        while (try walker.next()) |entry| {
+            if (entry.kind != .file or !std.mem.endsWith(u8, entry.basename, ".osu"))
+                continue;
+
+            try paths.append(try std.fs.path.join(allocator, &.{ input, entry.path }));
+        }
+    }
+
+    return try paths.toOwnedSlice();
+}
+
+test "every approximator stays within the tolerance of the golden from before the performance work" {
+    const allocator = std.testing.allocator;
+
+    var corpus = Corpus.init(allocator);
+    defer corpus.deinit();
+
+    try parseGolden(@embedFile("curve_golden.txt"), &corpus);
+    try std.testing.expect(corpus.Cases.items.len > EDGE_CASES.len);
+
+    const scratch = try allocator.alloc(zm.Vec2f, CurveApproximator.ScratchSize(corpus.maxControlPoints()));
+    defer allocator.free(scratch);
+
+    //Small on purpose, the long cases have to grow it
+    var output = try allocator.alloc(zm.Vec2f, 64);
+    defer allocator.free(output);
+
+    try std.testing.expectEqual(@as(usize, 0), try checkGolden(allocator, std.io.null_writer, &corpus, &output, scratch));
+}
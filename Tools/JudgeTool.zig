@@ -0,0 +1,175 @@
+//zerosu judge <map.osu> <replay.osr | replay_dir>...
+//Re-judges every replay against the map without opening a window and reports the ones whose recorded
+//hit counts/combo disagree with the simulation. Replays are independent so they're spread over a thread pool,
+//the JudgeBeatmap is built once and only read from the workers.
+
+const std = @import("std");
+
+const Beatmap = @import("../Osu/OsuParser.zig").Beatmap;
+const Replay = @import("../Osu/ReplayParser.zig").Replay;
+
+const ReplayJudge = @import("../Osu/ReplayJudge.zig");
+const JudgeBeatmap = ReplayJudge.JudgeBeatmap;
+const JudgeResult = ReplayJudge.JudgeResult;
+
+const MAX_REPLAY_SIZE = 64 * 1024 * 1024;
+
+const JobResult = struct {
+    Result: JudgeResult = .{},
+    Recorded: JudgeResult = .{},
+    Mismatch: bool = false,
+    Error: ?anyerror = null,
+};
+
+const JobContext = struct {
+    Beatmap: *const JudgeBeatmap,
+    Paths: []const []const u8,
+    Results: []JobResult,
+};
+
+pub fn Run(allocator: std.mem.Allocator, args: []const [:0]u8) !void {
+    const stdout = std.io.getStdOut().writer();
+
+    if (args.len < 2) {
+        try stdout.print("usage: zerosu judge <map.osu> <replay.osr | replay_dir>...\n", .{});
+        return;
+    }
+
+    const map_data = try std.fs.cwd().readFileAlloc(allocator, args[0], MAX_REPLAY_SIZE);
+    defer allocator.free(map_data);
+
+    var beatmap = Beatmap.FromString(allocator, map_data);
+    defer beatmap.Deinit();
+    beatmap.StackObjectsPass();
+
+    var judge_beatmap = try JudgeBeatmap.Init(allocator, &beatmap);
+    defer judge_beatmap.Deinit();
+
+    var arena_state = std.heap.ArenaAllocator.init(allocator);
+    defer arena_state.deinit();
+
+    const paths = try collectReplayPaths(arena_state.allocator(), args[1..]);
+
+    const results = try allocator.alloc(JobResult, paths.len);
+    defer allocator.free(results);
+    @memset(results, .{});
+
+    const context = JobContext{
+        .Beatmap = &judge_beatmap,
+        .Paths = paths,
+        .Results = results,
+    };
+
+    const start = try std.time.Instant.now();
+
+    var pool: std.Thread.Pool = undefined;
+    try pool.init(.{ .allocator = allocator });
+    defer pool.deinit();
+
+    var wait_group: std.Thread.WaitGroup = .{};
+    for (0..paths.len) |i| {
+        pool.spawnWg(&wait_group, judgeJob, .{ &context, i });
+    }
+    pool.waitAndWork(&wait_group);
+
+    const elapsed_ns = (try std.time.Instant.now()).since(start);
+
+    var buffered = std.io.bufferedWriter(stdout);
+    const out = buffered.writer();
+
+    var mismatches: usize = 0;
+    var failures: usize = 0;
+
+    for (paths, results) |path, result| {
+        if (result.Error) |err| {
+            failures += 1;
+            try out.print("ERROR    {s}: {s}\n", .{ path, @errorName(err) });
+            continue;
+        }
+
+        if (!result.Mismatch)
+            continue;
+
+        mismatches += 1;
+        try out.print("MISMATCH {s}\n", .{path});
+        try out.print("    recorded  300:{d} 100:{d} 50:{d} miss:{d} combo:{d} score:{d}\n", .{ result.Recorded.Count300, result.Recorded.Count100, result.Recorded.Count50, result.Recorded.CountMiss, result.Recorded.MaxCombo, result.Recorded.TotalScore });
+        try out.print("    simulated 300:{d} 100:{d} 50:{d} miss:{d} combo:{d} score:{d}\n", .{ result.Result.Count300, result.Result.Count100, result.Result.Count50, result.Result.CountMiss, result.Result.MaxCombo, result.Result.TotalScore });
+    }
+
+    const elapsed_s = @as(f64, @floatFromInt(elapsed_ns)) / std.time.ns_per_s;
+    const judged = paths.len - failures;
+
+    try out.print("\n{d} replays, {d} matched, {d} mismatched, {d} failed in {d:.3}s ({d:.1} replays/s)\n", .{
+        paths.len,
+        judged - mismatches,
+        mismatches,
+        failures,
+        elapsed_s,
+        if (elapsed_s > 0.0) @as(f64, @floatFromInt(paths.len)) / elapsed_s else 0.0,
+    });
+
+    try buffered.flush();
+}
+
+fn judgeJob(context: *const JobContext, index: usize) void {
+    //Everything a replay needs lives in its own arena and goes away in one free
+    var arena_state = std.heap.ArenaAllocator.init(std.heap.c_allocator);
+    defer arena_state.deinit();
+    const arena = arena_state.allocator();
+
+    const slot = &context.Results[index];
+
+    const data = std.fs.cwd().readFileAlloc(arena, context.Paths[index], MAX_REPLAY_SIZE) catch |err| {
+        slot.Error = err;
+        return;
+    };
+
+    const replay = Replay.FromData(arena, data) catch |err| {
+        slot.Error = err;
+        return;
+    };
+
+    const result = ReplayJudge.JudgeReplay(arena, context.Beatmap, replay.ReplayFrames.items, replay.ReplayInfo.Mods) catch |err| {
+        slot.Error = err;
+        return;
+    };
+
+    const info = &replay.ReplayInfo;
+
+    slot.Result = result;
+    slot.Recorded = .{
+        .Count300 = info.Count300,
+        .Count100 = info.Count100,
+        .Count50 = info.Count50,
+        .CountMiss = info.CountMiss,
+        .MaxCombo = info.HighestCombo,
+        .TotalScore = info.TotalScore,
+    };
+    slot.Mismatch = !result.Matches(info);
+}
+
+///Expands directories into the .osr files inside them
+fn collectReplayPaths(allocator: std.mem.Allocator, args: []const [:0]u8) ![]const []const u8 {
+    var paths = std.ArrayList([]const u8).init(allocator);
+
+    for (args) |arg| {
+        var dir = std.fs.cwd().openDir(arg, .{ .iterate = true }) catch |err| switch (err) {
+            error.NotDir => {
+                try paths.append(arg);
+                continue;
+            },
+            else => return err,
+        };
+        defer dir.close();
+
+        var iterator = dir.iterate();
+        while (try iterator.next()) |entry| {
+            if (entry.kind != .file or !std.mem.endsWith(u8, entry.name, ".osr"))
+                continue;
+
+            try paths.append(try std.fs.path.join(allocator, &.{ arg, entry.name }));
+        }
+    }
+
+    return try paths.toOwnedSlice();
+}
@@ -20,7 +20,8 @@ pub fn build(b: *std.Build) void {
         exe_example.omit_frame_pointer = true;
         exe_example.valgrind = false;
         exe_example.unwind_tables = null;
-        exe_example.single_threaded = true;
+        //The headless replay tools run on a thread pool
+        exe_example.single_threaded = false;
         exe_example.sanitize_thread = false;
     }
 
@@ -30,38 +31,10 @@ pub fn build(b: *std.Build) void {
         .root_module = exe_example,
     });
 
-    if (target.result.cpu.arch.isArm()) {
-        //my pi zero2
-        exe.addLibraryPath(.{ .cwd_relative = "/home/alex/Downloads/piroot/usr/lib/arm-linux-gnueabihf/" });
-        exe.addIncludePath(.{ .cwd_relative = "/home/alex/Downloads/piroot/usr/include/arm-linux-gnueabihf/" });
-        exe.addIncludePath(.{ .cwd_relative = "/home/alex/Downloads/piroot/usr/include/" });
-    }
-
-    exe.addIncludePath(.{ .cwd_relative = "c" });
-    exe.addCSourceFile(.{ .file = .{
-        .cwd_relative = "c/stb_image_impl.c",
-    } });
-
-    //if (target.result.os)
-    const targetCpu = target.result.cpu.arch;
-    const targetOs = target.result.os.tag;
-
-    const libsLibPath = switch (targetOs) {
-        .linux => "libs/linux",
-        else => @panic("Unsupported arch"),
-    };
-    exe.addLibraryPath(.{ .cwd_relative = libsLibPath });
-
-    //Link Bass
+    linkLibraries(b, exe, target);
 
-    //Will append lib before this path even tho i dont want it
-    const bassLibPath = switch (targetCpu) {
-        .x86_64 => "_x86_64/libbass",
-        .arm => "_armhf/libbass",
-        .aarch64 => "_aarch64/libbass",
-        else => @panic("Unsupported arch"),
-    };
-    exe.linkSystemLibrary(bassLibPath);
+    const libsLibPath = libsPath(target);
+    const bassLibPath = bassPath(target);
 
     //const finalLibPath = try concatThreeStrings(b.allocator, libsLibPath, "lib", bassLibPath);
     const libOutputPath = std.fmt.allocPrint(b.allocator, "{s}/lib{s}.so", .{ libsLibPath, bassLibPath }) catch return;
@@ -71,13 +44,6 @@ pub fn build(b: *std.Build) void {
 
     //LINK_BASS(b, exe);
 
-    const zm = b.dependency("zm", .{});
-    exe.root_module.addImport("zm", zm.module("zm"));
-
-    exe.linkLibC();
-    exe.linkSystemLibrary("SDL2");
-    exe.linkSystemLibrary("GLESv2");
-
     const maps_dir = "maps";
     const skins_dir = "skins";
     addDirToOutput(b, maps_dir);
@@ -94,6 +60,66 @@ pub fn build(b: *std.Build) void {
 
     const run_step = b.step("run", "Run the app");
     run_step.dependOn(&run_cmd.step);
+
+    //Linked like the game, the code under test imports modules that touch GL and BASS even where the tests don't
+    const tests = b.addTest(.{
+        .root_module = b.createModule(.{
+            .root_source_file = b.path("tests.zig"),
+            .target = target,
+            .optimize = optimize,
+        }),
+    });
+    linkLibraries(b, tests, target);
+
+    const run_tests = b.addRunArtifact(tests);
+    //The game finds BASS next to it once installed, the tests run from the cache
+    run_tests.setEnvironmentVariable("LD_LIBRARY_PATH", b.pathFromRoot(std.fs.path.dirname(libOutputPath).?));
+
+    const test_step = b.step("test", "Run the unit tests");
+    test_step.dependOn(&run_tests.step);
+}
+
+fn libsPath(target: std.Build.ResolvedTarget) []const u8 {
+    return switch (target.result.os.tag) {
+        .linux => "libs/linux",
+        else => @panic("Unsupported arch"),
+    };
+}
+
+//Will append lib before this path even tho i dont want it
+fn bassPath(target: std.Build.ResolvedTarget) []const u8 {
+    return switch (target.result.cpu.arch) {
+        .x86_64 => "_x86_64/libbass",
+        .arm => "_armhf/libbass",
+        .aarch64 => "_aarch64/libbass",
+        else => @panic("Unsupported arch"),
+    };
+}
+
+fn linkLibraries(b: *std.Build, compile: *std.Build.Step.Compile, target: std.Build.ResolvedTarget) void {
+    if (target.result.cpu.arch.isArm()) {
+        //my pi zero2
+        compile.addLibraryPath(.{ .cwd_relative = "/home/alex/Downloads/piroot/usr/lib/arm-linux-gnueabihf/" });
+        compile.addIncludePath(.{ .cwd_relative = "/home/alex/Downloads/piroot/usr/include/arm-linux-gnueabihf/" });
+        compile.addIncludePath(.{ .cwd_relative = "/home/alex/Downloads/piroot/usr/include/" });
+    }
+
+    compile.addIncludePath(.{ .cwd_relative = "c" });
+    compile.addCSourceFile(.{ .file = .{
+        .cwd_relative = "c/stb_image_impl.c",
+    } });
+
+    compile.addLibraryPath(.{ .cwd_relative = libsPath(target) });
+
+    //Link Bass
+    compile.linkSystemLibrary(bassPath(target));
+
+    const zm = b.dependency("zm", .{});
+    compile.root_module.addImport("zm", zm.module("zm"));
+
+    compile.linkLibC();
+    compile.linkSystemLibrary("SDL2");
+    compile.linkSystemLibrary("GLESv2");
 }
 
 fn addDirToOutput(b: *std.Build, dir_name: []const u8) void {
@@ -26,9 +26,33 @@ const PlayableBeatmap = @import("Osu/PlayableBeatmap.zig").PlayableBeatmap;
 
 const Replay = @import("Osu/ReplayParser.zig").Replay;
 
+const JudgeTool = @import("Tools/JudgeTool.zig");
+const AnalyticsTool = @import("Tools/AnalyticsTool.zig");
+const CurveBench = @import("Tools/CurveBench.zig");
+const SliderLod = @import("Osu/SliderLod.zig").SliderLod;
+const QualityProfile = @import("Osu/SliderLod.zig").QualityProfile;
+const DrawableHitSlider = @import("Osu/Drawables/DrawableHitSlider.zig").DrawableHitSlider;
+const SliderRenderMode = @import("Osu/Drawables/DrawableHitSlider.zig").SliderRenderMode;
+
 pub fn main() !void {
     std.debug.print("\nHello zig!\n\n", .{});
 
+    const args = try std.process.argsAlloc(std.heap.c_allocator);
+    defer std.process.argsFree(std.heap.c_allocator, args);
+
+    //Headless subcommands, these never open a window
+    if (args.len >= 2 and std.mem.eql(u8, args[1], "judge")) {
+        return JudgeTool.Run(std.heap.c_allocator, args[2..]);
+    }
+
+    if (args.len >= 2 and std.mem.eql(u8, args[1], "analyze")) {
+        return AnalyticsTool.Run(std.heap.c_allocator, args[2..]);
+    }
+
+    if (args.len >= 2 and std.mem.eql(u8, args[1], "curvebench")) {
+        return CurveBench.Run(std.heap.c_allocator, args[2..]);
+    }
+
     if (c.SDL_Init(c.SDL_INIT_VIDEO) != 0) {
         std.debug.print("SDL_Init Error: {s}\n", .{c.SDL_GetError()});
         return;
@@ -39,6 +63,8 @@ pub fn main() !void {
     _ = c.SDL_GL_SetAttribute(c.SDL_GL_CONTEXT_PROFILE_MASK, c.SDL_GL_CONTEXT_PROFILE_ES);
     _ = c.SDL_GL_SetAttribute(c.SDL_GL_CONTEXT_MAJOR_VERSION, 2);
     _ = c.SDL_GL_SetAttribute(c.SDL_GL_CONTEXT_MINOR_VERSION, 0);
+    //Only the direct slider render mode uses it
+    _ = c.SDL_GL_SetAttribute(c.SDL_GL_DEPTH_SIZE, 16);
 
     var width: i32 = 1280;
     var height: i32 = 720;
@@ -81,12 +107,67 @@ pub fn main() !void {
     var total_time: f32 = 0.0;
     var fps: i32 = 0;
     var fpsTimer: f64 = 0.0;
+    var worstFrame: f64 = 0.0;
 
     onResize(&g, width, height);
 
     SceneManager.GetInstance().AddScene(PlayScene, PlayScene.GetInstance(), PlayScene.GetFnTable());
     SceneManager.GetInstance().AddScene(MenuScene, MenuScene.GetInstance(), MenuScene.GetFnTable());
     SceneManager.GetInstance().AddScene(TestScene, TestScene.GetInstance(), TestScene.GetFnTable());
+
+    //zerosu --replay path/to/replay.osr
+    //zerosu --overlay path/to/replay_or_dir [--overlay ...]
+    //zerosu --spectate-host /tmp/zerosu.sock, then in another instance: zerosu --spectate /tmp/zerosu.sock
+    //zerosu --quality low|medium|high (slider tessellation detail, default medium)
+    //zerosu --slider-render offscreen|direct|distancefield (slider bodies through the atlas, straight to the screen or as
+    //CPU distance fields through the atlas, F2 cycles)
+    //zerosu --prerender-budget 1.0 (ms per frame for building sliders ahead of their spawn, 0 builds them on spawn)
+    //zerosu --slider-stats (slider body memory next to the frame times every second, to compare the render modes)
+    var sliderStats = false;
+    for (args[1..]) |arg| {
+        if (std.mem.eql(u8, arg, "--slider-stats"))
+            sliderStats = true;
+    }
+
+    var arg_index: usize = 1;
+    while (arg_index + 1 < args.len) : (arg_index += 1) {
+        if (std.mem.eql(u8, args[arg_index], "--replay")) {
+            arg_index += 1;
+            loadReplay(args[arg_index]);
+        } else if (std.mem.eql(u8, args[arg_index], "--overlay")) {
+            arg_index += 1;
+            loadOverlayReplays(args[arg_index]);
+        } else if (std.mem.eql(u8, args[arg_index], "--spectate-host")) {
+            arg_index += 1;
+            PlayScene.StartSpectatorHost(args[arg_index]);
+        } else if (std.mem.eql(u8, args[arg_index], "--spectate")) {
+            arg_index += 1;
+            PlayScene.StartSpectating(args[arg_index]);
+        } else if (std.mem.eql(u8, args[arg_index], "--slider-render")) {
+            arg_index += 1;
+            if (SliderRenderMode.FromString(args[arg_index])) |mode| {
+                DrawableHitSlider.SetRenderMode(mode);
+            } else {
+                std.debug.print("Unknown slider render mode {s}, expected offscreen, direct or distancefield\n", .{args[arg_index]});
+            }
+        } else if (std.mem.eql(u8, args[arg_index], "--quality")) {
+            arg_index += 1;
+            if (QualityProfile.FromString(args[arg_index])) |profile| {
+                SliderLod.SetProfile(profile);
+                PlayScene.RefreshSliderBodies();
+            } else {
+                std.debug.print("Unknown quality {s}, expected low, medium or high\n", .{args[arg_index]});
+            }
+        } else if (std.mem.eql(u8, args[arg_index], "--prerender-budget")) {
+            arg_index += 1;
+            if (std.fmt.parseFloat(f32, args[arg_index])) |budget_ms| {
+                PlayScene.SetSliderPrerenderBudget(budget_ms);
+            } else |_| {
+                std.debug.print("Invalid prerender budget {s}, expected milliseconds\n", .{args[arg_index]});
+            }
+        }
+    }
+
     while (running) {
         const now = try std.time.Instant.now();
         const delta_ns = now.since(prev); //nanoseconds
@@ -98,11 +179,17 @@ pub fn main() !void {
 
         fps += 1;
         fpsTimer += d_delta;
+        worstFrame = @max(worstFrame, d_delta);
 
         if (fpsTimer >= 1.0) {
-            std.debug.print("FPS: {d}\n", .{fps});
+            std.debug.print("FPS: {d} ({d:.2} ms avg, {d:.2} ms worst)\n", .{ fps, fpsTimer * 1000.0 / @as(f64, @floatFromInt(fps)), worstFrame * 1000.0 });
+
+            if (sliderStats)
+                DrawableHitSlider.PrintStats();
+
             fps = 0;
             fpsTimer -= 1.0;
+            worstFrame = 0.0;
         }
 
         while (c.SDL_PollEvent(&event) != 0) {
@@ -129,7 +216,7 @@ pub fn main() !void {
         }
 
         //clear screen to cornflower blue
-        c.glClear(c.GL_COLOR_BUFFER_BIT);
+        c.glClear(c.GL_COLOR_BUFFER_BIT | c.GL_DEPTH_BUFFER_BIT);
         g.Time = total_time;
 
         SceneManager.OnUpdate(delta);
@@ -147,6 +234,56 @@ pub fn main() !void {
     }
 }
 
+fn loadReplay(path: []const u8) void {
+    const absolute_path = std.fs.cwd().realpathAlloc(std.heap.c_allocator, path) catch |err| {
+        std.debug.print("Couldn't find replay {s}: {}\n", .{ path, err });
+        return;
+    };
+    defer std.heap.c_allocator.free(absolute_path);
+
+    const replay = Replay.FromFile(std.heap.c_allocator, absolute_path) catch |err| {
+        std.debug.print("Couldn't load replay {s}: {}\n", .{ path, err });
+        return;
+    };
+
+    PlayScene.SetReplay(replay);
+}
+
+fn loadOverlayReplays(path: []const u8) void {
+    var dir = std.fs.cwd().openDir(path, .{ .iterate = true }) catch {
+        //Not a directory, a single replay then
+        loadOverlayReplay(path);
+        return;
+    };
+    defer dir.close();
+
+    var iterator = dir.iterate();
+    while (iterator.next() catch null) |entry| {
+        if (entry.kind != .file or !std.mem.endsWith(u8, entry.name, ".osr"))
+            continue;
+
+        const replay_path = std.fs.path.join(std.heap.c_allocator, &.{ path, entry.name }) catch continue;
+        defer std.heap.c_allocator.free(replay_path);
+
+        loadOverlayReplay(replay_path);
+    }
+}
+
+fn loadOverlayReplay(path: []const u8) void {
+    const absolute_path = std.fs.cwd().realpathAlloc(std.heap.c_allocator, path) catch |err| {
+        std.debug.print("Couldn't find replay {s}: {}\n", .{ path, err });
+        return;
+    };
+    defer std.heap.c_allocator.free(absolute_path);
+
+    const replay = Replay.FromFile(std.heap.c_allocator, absolute_path) catch |err| {
+        std.debug.print("Couldn't load replay {s}: {}\n", .{ path, err });
+        return;
+    };
+
+    PlayScene.AddOverlayReplay(replay);
+}
+
 fn onResize(g: *Graphics, window_width: i32, window_height: i32) void {
     g.ProjectionMatrix = zm.Mat4f.orthographic(0.0, @floatFromInt(window_width), @floatFromInt(window_height), 0.0, -1.0, 1.0);
     PlayableBeatmap.UpdatePlayfield(@floatFromInt(window_width), @floatFromInt(window_height));
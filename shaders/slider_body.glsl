@@ -0,0 +1,82 @@
+//Slider body shading, shared by main.frag and slider_direct.frag which are compiled with this in front of them
+precision highp float;
+
+uniform vec3 u_BorderColorOuter;
+uniform vec3 u_BorderColorInner;
+
+uniform vec3 u_TrackColorOuter;
+uniform vec3 u_TrackColorInner;
+
+uniform vec4 u_ShadowColor;
+
+uniform float u_BorderWidth;
+
+//Keyframes of the border gradient around the current time, baked by SliderGradient.zig
+uniform sampler2D u_Gradient0;
+uniform sampler2D u_Gradient1;
+uniform float u_GradientBlend;
+
+//_depth_ is the slider's depth at this point (0.5 on the path, 1.0 at the edge), _diller_ the position inside the
+//slider's bounds from 0 to 1
+vec4 sliderBody(float depth, vec2 diller, float alpha) {
+    #define borderStart 0.06640625 // 34/512
+    #define baseBorderWidth 0.126953125 // 65/512
+    #define blend 0.01
+
+    #define maxBorderWidth (1.0 - borderStart)
+    #define slope ((maxBorderWidth - baseBorderWidth) / 9.0)
+
+    float distance = depth * 2.0 - 1.0;
+    float distance_inv = 1.0 - distance;
+
+    vec3 gradient = mix(texture2D(u_Gradient0, diller).rgb, texture2D(u_Gradient1, diller).rgb, u_GradientBlend);
+    vec4 effecFinal = vec4(gradient, alpha);
+
+    vec4 borderColorOuter = effecFinal;//vec4(u_BorderColorOuter.rgb, alpha);
+    vec4 borderColorInner = effecFinal;//vec4(u_BorderColorInner.rgb, alpha);
+    vec4 outerShadow = vec4(u_ShadowColor.rgb, u_ShadowColor.a * distance_inv / borderStart * borderColorInner.a);
+    vec4 bodyColorOuter = vec4(u_TrackColorOuter.rgb, alpha * 0.6);
+    vec4 bodyColorInner = vec4(u_TrackColorInner.rgb, alpha * 0.6);
+
+    // border width scaling without branch:
+    float t = clamp((u_BorderWidth - 1.0) / 8.99, 0.0, 1.0); // normalized between 0 and 1 for [1, 9.99]
+    float borderWidthScaled = mix(baseBorderWidth, slope * 8.99 + baseBorderWidth, t);
+
+    float borderMid = borderStart + borderWidthScaled * 0.5;
+    float borderEnd = borderStart + borderWidthScaled;
+
+    // Interpolate border colors smoothly
+    float borderMixFactor = smoothstep(borderMid - borderWidthScaled * 0.25, borderMid + borderWidthScaled * 0.25, distance_inv);
+    vec4 borderColorMix = mix(borderColorOuter, borderColorInner, borderMixFactor);
+
+    // Interpolate body colors smoothly
+    float bodyMixFactor = (distance_inv - borderEnd) / (1.0 - borderEnd);
+    bodyMixFactor = clamp(bodyMixFactor, 0.0, 1.0);
+    vec4 bodyColorMix = mix(bodyColorOuter, bodyColorInner, bodyMixFactor);
+
+    // Replace borderColorMix with outerShadow if u_BorderWidth < 0.01 (smooth step)
+    float borderWidthLowFactor = smoothstep(0.01, 0.02, u_BorderWidth); // 0 at very low width, 1 when above 0.02
+    borderColorMix = mix(outerShadow, borderColorMix, borderWidthLowFactor);
+
+    // Replace bodyColorMix with borderColorMix if u_BorderWidth > 9.99 (smooth step)
+    float borderWidthHighFactor = smoothstep(9.98, 9.99, u_BorderWidth); // 0 below 9.98, 1 above 9.99
+    bodyColorMix = mix(bodyColorMix, borderColorMix, borderWidthHighFactor);
+
+    // Now handle sliderTexture output based on distance_inv with smoothstep blending
+
+    // Compute smooth transitions at borderStart and borderEnd
+    float s0 = smoothstep(borderStart - blend, borderStart + blend, distance_inv);
+    float s1 = smoothstep(borderEnd - blend, borderEnd + blend, distance_inv);
+
+    // OuterShadow to borderColorMix blending around borderStart
+    vec4 colorStartBlend = mix(outerShadow, borderColorMix, s0);
+
+    // borderColorMix to bodyColorMix blending around borderEnd
+    vec4 colorEndBlend = mix(borderColorMix, bodyColorMix, s1);
+
+    // Combine the two regions with smoothstep ramps:
+    float between = smoothstep(borderStart + blend, borderEnd - blend, distance_inv);
+
+    // Final color: interpolate between start blend and end blend using between
+    return mix(colorStartBlend, colorEndBlend, between);
+}
@@ -0,0 +1,10 @@
+//Compiled with slider_body.glsl in front of it (see DrawableHitSlider.zig)
+
+varying float v_Depth;
+varying vec2 v_Local;
+
+uniform float u_Alpha;
+
+void main() {
+    gl_FragColor = sliderBody(v_Depth, v_Local, u_Alpha);
+}
@@ -0,0 +1,33 @@
+attribute vec3 a_Position;
+//Distance along the path, segment direction
+attribute vec3 a_Along;
+
+uniform mat4 u_Projection;
+//Start and size of this slider's slice of the depth range, in normalized device coordinates
+uniform vec2 u_DepthRange;
+//Slider bounds in osu pixels
+uniform vec2 u_Size;
+//Visible stretch of the path while snaking, partial segments get pulled in to it
+uniform vec2 u_Range;
+//Moves the end caps to the ends of the visible stretch
+uniform vec2 u_Offset;
+
+varying float v_Depth;
+varying vec2 v_Local;
+
+//The depth and colour passes use different programs and have to land on exactly the same depth
+invariant gl_Position;
+
+void main() {
+	float along = a_Along.x;
+	vec2 position = a_Position.xy + u_Offset + a_Along.yz * (clamp(along, u_Range.x, u_Range.y) - along);
+
+	vec4 projected = vec4(position, 0.0, 1.0) * u_Projection;
+	//a_Position.z goes from 0 on the path to -1 at the edge
+	projected.z = u_DepthRange.x - a_Position.z * u_DepthRange.y;
+	gl_Position = projected;
+
+	//What the offscreen depth texture would hold here
+	v_Depth = 0.5 - 0.5 * a_Position.z;
+	v_Local = position / u_Size;
+}
@@ -0,0 +1,8 @@
+precision mediump float;
+
+varying float v_Depth;
+
+//The depth as colour for a colour atlas page, main.frag reads the red channel like it reads a depth texture
+void main() {
+    gl_FragColor = vec4(v_Depth, v_Depth, v_Depth, 1.0);
+}
@@ -0,0 +1,12 @@
+//zig build test
+//Every file with tests has to be referenced from here, zig only runs the tests of files the root pulls in
+
+test {
+    _ = @import("CurveApproximator.zig");
+    _ = @import("GameClock.zig");
+    _ = @import("Osu/ReplayParser.zig");
+    _ = @import("Osu/SliderPath.zig");
+    _ = @import("Osu/SliderAtlas.zig");
+    _ = @import("Osu/SliderCurveCache.zig");
+    _ = @import("Tools/CurveBench.zig");
+}